@@ -0,0 +1,628 @@
+#include "assembler.h"
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+static const char *const registers64[] = {"rax", "rcx", "rdx", "rbx", "rsp", "rbp", "rsi", "rdi",
+                                          "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15"};
+static const char *const registers32[] = {"eax", "ecx", "edx", "ebx", "esp", "ebp", "esi", "edi",
+                                          "r8d", "r9d", "r10d", "r11d", "r12d", "r13d", "r14d", "r15d"};
+static const char *const registers8[] = {"al", "cl", "dl", "bl", "spl", "bpl", "sil", "dil",
+                                         "r8b", "r9b", "r10b", "r11b", "r12b", "r13b", "r14b", "r15b"};
+
+// Códigos de condición de jcc y setcc
+static const unordered_map<string, int> conditions = {
+    {"o", 0}, {"no", 1}, {"b", 2}, {"c", 2}, {"nae", 2}, {"ae", 3}, {"nb", 3}, {"nc", 3},
+    {"e", 4}, {"z", 4}, {"ne", 5}, {"nz", 5}, {"be", 6}, {"na", 6}, {"a", 7}, {"nbe", 7},
+    {"s", 8}, {"ns", 9}, {"p", 10}, {"pe", 10}, {"np", 11}, {"po", 11}, {"l", 12}, {"nge", 12},
+    {"ge", 13}, {"nl", 13}, {"le", 14}, {"ng", 14}, {"g", 15}, {"nle", 15}};
+
+static string trim(const string &text)
+{
+    size_t start = text.find_first_not_of(" \t\r");
+    if (start == string::npos)
+        return "";
+    size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(start, end - start + 1);
+}
+
+static bool fitsInt8(long long value)
+{
+    return value >= -128 && value <= 127;
+}
+
+static bool fitsInt32(long long value)
+{
+    return value >= INT32_MIN && value <= INT32_MAX;
+}
+
+void X86Assembler::fail(const string &motivo)
+{
+    throw runtime_error(motivo);
+}
+
+void X86Assembler::bytes(const void *data, size_t count)
+{
+    const uint8_t *begin = static_cast<const uint8_t *>(data);
+    sections[current].insert(sections[current].end(), begin, begin + count);
+}
+
+void X86Assembler::imm32(long long value)
+{
+    if (!fitsInt32(value))
+        fail("inmediato fuera de rango: " + to_string(value));
+    int32_t value32 = value;
+    bytes(&value32, 4);
+}
+
+X86Assembler::Operand X86Assembler::parseOperand(const string &text)
+{
+    Operand operand;
+    if (text.empty())
+        fail("operando vacio");
+    if (text[0] == '$')
+    {
+        char *end;
+        operand.kind = Operand::IMM;
+        operand.imm = strtoll(text.c_str() + 1, &end, 0);
+        if (*end)
+            fail("inmediato no soportado: " + text);
+        return operand;
+    }
+    if (text[0] == '%')
+    {
+        string name = text.substr(1);
+        if (name.compare(0, 3, "xmm") == 0)
+        {
+            operand.kind = Operand::XMM;
+            operand.reg = atoi(name.c_str() + 3);
+            return operand;
+        }
+        operand.kind = Operand::REG;
+        const char *const *tables[] = {registers64, registers32, registers8};
+        const int sizes[] = {64, 32, 8};
+        for (int t = 0; t < 3; t++)
+        {
+            for (int r = 0; r < 16; r++)
+            {
+                if (name == tables[t][r])
+                {
+                    operand.reg = r;
+                    operand.size = sizes[t];
+                    return operand;
+                }
+            }
+        }
+        fail("registro desconocido: " + text);
+    }
+
+    size_t paren = text.find('(');
+    if (paren == string::npos)
+    {
+        operand.kind = Operand::LABEL;
+        operand.label = text.substr(0, text.find('@'));
+        return operand;
+    }
+
+    operand.kind = Operand::MEM;
+    string displacement = trim(text.substr(0, paren));
+    string base = trim(text.substr(paren + 1, text.find(')') - paren - 1));
+    if (base == "%rip")
+    {
+        operand.reg = RIP_BASE;
+        operand.label = displacement;
+        if (displacement.empty() || isdigit(displacement[0]) || displacement[0] == '-')
+            fail("direccion relativa a %rip sin etiqueta: " + text);
+        return operand;
+    }
+    Operand baseReg = parseOperand(base);
+    if (baseReg.kind != Operand::REG || baseReg.size != 64)
+        fail("base de memoria no soportada: " + text);
+    operand.reg = baseReg.reg;
+    if (!displacement.empty())
+    {
+        char *end;
+        long long value = strtoll(displacement.c_str(), &end, 0);
+        if (*end || !fitsInt32(value))
+            fail("desplazamiento no soportado: " + text);
+        operand.disp = value;
+    }
+    return operand;
+}
+
+string X86Assembler::parseString(const string &args)
+{
+    if (args.empty() || args[0] != '"')
+        fail("se esperaba una cadena: " + args);
+    string value;
+    size_t i = 1;
+    while (i < args.size() && args[i] != '"')
+    {
+        char c = args[i++];
+        if (c != '\\' || i >= args.size())
+        {
+            value += c;
+            continue;
+        }
+        c = args[i++];
+        if (c >= '0' && c <= '7')
+        {
+            int code = c - '0';
+            for (int digits = 1; digits < 3 && i < args.size() && args[i] >= '0' && args[i] <= '7'; digits++)
+                code = code * 8 + (args[i++] - '0');
+            value += (char)code;
+        }
+        else if (c == 'n')
+            value += '\n';
+        else if (c == 't')
+            value += '\t';
+        else if (c == 'r')
+            value += '\r';
+        else
+            value += c;
+    }
+    if (i >= args.size())
+        fail("cadena sin cerrar: " + args);
+    return value;
+}
+
+void X86Assembler::define(const string &label)
+{
+    if (current == IGNORED)
+        return;
+    if (labels.count(label))
+        fail("etiqueta repetida: " + label);
+    labels[label] = make_pair(current, sections[current].size());
+}
+
+void X86Assembler::assembleLine(const string &raw)
+{
+    string line = trim(raw);
+    // Etiquetas al inicio de la línea, con o sin directiva después
+    while (!line.empty() && line[0] != '"')
+    {
+        size_t colon = line.find(':');
+        size_t space = line.find_first_of(" \t\"");
+        if (colon == string::npos || (space != string::npos && space < colon))
+            break;
+        define(line.substr(0, colon));
+        line = trim(line.substr(colon + 1));
+    }
+    if (line.empty() || line[0] == '#')
+        return;
+
+    size_t space = line.find_first_of(" \t");
+    string name = line.substr(0, space);
+    string args = space == string::npos ? "" : trim(line.substr(space));
+    if (name[0] == '.')
+    {
+        directive(name, args);
+        return;
+    }
+    if (current == IGNORED)
+        return;
+
+    vector<Operand> ops;
+    size_t start = 0;
+    int depth = 0;
+    for (size_t i = 0; i <= args.size(); i++)
+    {
+        if (i < args.size() && args[i] == '(')
+            depth++;
+        else if (i < args.size() && args[i] == ')')
+            depth--;
+        else if (i == args.size() || (args[i] == ',' && depth == 0))
+        {
+            string text = trim(args.substr(start, i - start));
+            if (!text.empty())
+                ops.push_back(parseOperand(text));
+            start = i + 1;
+        }
+    }
+    instruction(name, ops);
+}
+
+void X86Assembler::directive(const string &name, const string &args)
+{
+    if (name == ".text")
+        current = TEXT;
+    else if (name == ".data")
+        current = DATA;
+    else if (name == ".section")
+    {
+        string section = trim(args.substr(0, args.find(',')));
+        current = section == ".rodata" ? RODATA : section == ".data" ? DATA : section == ".text" ? TEXT : IGNORED;
+    }
+    else if (name == ".globl" || name == ".global")
+        globals.insert(args);
+    else if (current == IGNORED || name == ".type" || name == ".size")
+        return;
+    else if (name == ".string" || name == ".asciz" || name == ".ascii")
+    {
+        string value = parseString(args);
+        bytes(value.data(), value.size());
+        if (name != ".ascii")
+            byte(0);
+    }
+    else if (name == ".space" || name == ".zero")
+        sections[current].resize(sections[current].size() + strtoul(args.c_str(), nullptr, 0));
+    else if (name == ".align" || name == ".p2align" || name == ".balign")
+    {
+        size_t alignment = strtoul(args.c_str(), nullptr, 0);
+        if (name == ".p2align")
+            alignment = (size_t)1 << alignment;
+        while (alignment && sections[current].size() % alignment)
+            byte(current == TEXT ? 0x90 : 0);
+    }
+    else if (name == ".byte" || name == ".long" || name == ".quad" || name == ".float" || name == ".double")
+    {
+        // Uno o varios valores separados por comas
+        for (size_t start = 0; start <= args.size();)
+        {
+            size_t comma = min(args.find(',', start), args.size());
+            string value = trim(args.substr(start, comma - start));
+            if (name == ".float")
+            {
+                float number = strtof(value.c_str(), nullptr);
+                bytes(&number, 4);
+            }
+            else if (name == ".double")
+            {
+                double number = strtod(value.c_str(), nullptr);
+                bytes(&number, 8);
+            }
+            else
+            {
+                long long number = strtoll(value.c_str(), nullptr, 0);
+                bytes(&number, name == ".byte" ? 1 : name == ".long" ? 4 : 8);
+            }
+            start = comma + 1;
+        }
+    }
+    else
+        fail("directiva no soportada: " + name);
+}
+
+// REX.W para operandos de 64 bits; REX.R y REX.B extienden los campos reg y
+// r/m a r8-r15 y xmm8-xmm15. spl, bpl, sil y dil solo existen con REX.
+void X86Assembler::rex(bool wide, int reg, const Operand &rm)
+{
+    bool r = reg >= 8;
+    bool b = (rm.kind == Operand::REG || rm.kind == Operand::XMM || rm.kind == Operand::MEM) && rm.reg >= 8;
+    bool byteRegister = rm.kind == Operand::REG && rm.size == 8 && rm.reg >= 4 && rm.reg < 8;
+    if (wide || r || b || byteRegister)
+        byte(0x40 | (wide ? 8 : 0) | (r ? 4 : 0) | (b ? 1 : 0));
+}
+
+// trailing son los bytes de inmediato que siguen al desplazamiento, para
+// calcular la dirección de la instrucción siguiente en las relativas a %rip
+void X86Assembler::modrm(int reg, const Operand &rm, size_t trailing)
+{
+    reg &= 7;
+    if (rm.kind == Operand::REG || rm.kind == Operand::XMM)
+    {
+        byte(0xC0 | reg << 3 | (rm.reg & 7));
+        return;
+    }
+    if (rm.kind != Operand::MEM)
+        fail("se esperaba un registro o memoria");
+    if (rm.reg == RIP_BASE)
+    {
+        byte(0x05 | reg << 3);
+        size_t at = sections[current].size();
+        fixups.push_back({current, at, at + 4 + trailing, rm.label});
+        imm32(0);
+        return;
+    }
+
+    int base = rm.reg & 7;
+    int mod = (rm.disp == 0 && base != 5) ? 0 : fitsInt8(rm.disp) ? 1 : 2;
+    byte(mod << 6 | reg << 3 | base);
+    if (base == 4)
+        byte(0x24); // SIB sin índice para rsp y r12
+    if (mod == 1)
+        byte((int8_t)rm.disp);
+    else if (mod == 2)
+        imm32(rm.disp);
+}
+
+void X86Assembler::op(const vector<uint8_t> &prefix, bool wide, const vector<uint8_t> &opcode, int reg,
+                     const Operand &rm, size_t trailing)
+{
+    for (uint8_t p : prefix)
+        byte(p);
+    rex(wide, reg, rm);
+    for (uint8_t o : opcode)
+        byte(o);
+    modrm(reg, rm, trailing);
+}
+
+void X86Assembler::rel32(uint8_t opcode1, int opcode2, const Operand &target)
+{
+    if (target.kind != Operand::LABEL)
+        fail("salto a algo que no es una etiqueta");
+    byte(opcode1);
+    if (opcode2 >= 0)
+        byte(opcode2);
+    size_t at = sections[current].size();
+    fixups.push_back({current, at, at + 4, target.label});
+    imm32(0);
+}
+
+// add, or, and, sub, xor y cmp comparten codificación; code es el /digit
+void X86Assembler::alu(int code, bool wide, const vector<Operand> &ops)
+{
+    const Operand &src = ops[0];
+    const Operand &dst = ops[1];
+    if (src.kind == Operand::IMM)
+    {
+        if (fitsInt8(src.imm))
+        {
+            op({}, wide, {0x83}, code, dst, 1);
+            byte((int8_t)src.imm);
+        }
+        else
+        {
+            op({}, wide, {0x81}, code, dst, 4);
+            imm32(src.imm);
+        }
+    }
+    else if (src.kind == Operand::REG)
+        op({}, wide, {(uint8_t)(0x01 + 8 * code)}, src.reg, dst);
+    else if (dst.kind == Operand::REG)
+        op({}, wide, {(uint8_t)(0x03 + 8 * code)}, dst.reg, src);
+    else
+        fail("operandos no soportados");
+}
+
+// Instrucción SSE escalar con el destino en el campo reg; prefix 0 es sin
+// prefijo (comiss, xorps)
+void X86Assembler::sse(uint8_t prefix, uint8_t opcode, const vector<Operand> &ops)
+{
+    if (ops[1].kind != Operand::XMM)
+        fail("el destino debe ser un registro xmm");
+    op(prefix ? vector<uint8_t>{prefix} : vector<uint8_t>{}, false, {0x0F, opcode}, ops[1].reg, ops[0]);
+}
+
+void X86Assembler::instruction(const string &mnemonic, const vector<Operand> &ops)
+{
+    static const unordered_map<string, int> aluOps = {{"add", 0}, {"or", 1}, {"and", 4},
+                                                      {"sub", 5}, {"xor", 6}, {"cmp", 7}};
+    static const unordered_map<string, pair<int, int>> unaryOps = {
+        {"idivq", {0xF7, 7}}, {"divq", {0xF7, 6}}, {"negq", {0xF7, 3}}, {"notq", {0xF7, 2}}, {"incq", {0xFF, 0}}, {"decq", {0xFF, 1}}};
+    static const unordered_map<string, int> shiftOps = {{"shlq", 4}, {"shrq", 5}, {"sarq", 7}};
+    static const unordered_map<string, pair<uint8_t, uint8_t>> sseOps = {
+        {"addsd", {0xF2, 0x58}}, {"mulsd", {0xF2, 0x59}}, {"subsd", {0xF2, 0x5C}}, {"divsd", {0xF2, 0x5E}},
+        {"sqrtsd", {0xF2, 0x51}}, {"comisd", {0x66, 0x2F}}, {"ucomisd", {0x66, 0x2E}}, {"xorpd", {0x66, 0x57}},
+        {"cvtsd2ss", {0xF2, 0x5A}}, {"addss", {0xF3, 0x58}}, {"mulss", {0xF3, 0x59}}, {"subss", {0xF3, 0x5C}},
+        {"divss", {0xF3, 0x5E}}, {"sqrtss", {0xF3, 0x51}}, {"comiss", {0, 0x2F}}, {"ucomiss", {0, 0x2E}},
+        {"xorps", {0, 0x57}}, {"cvtss2sd", {0xF3, 0x5A}}};
+
+    size_t count = ops.size();
+    auto expect = [&](size_t n) {
+        if (count != n)
+            fail("'" + mnemonic + "' espera " + to_string(n) + " operandos");
+    };
+
+    if (mnemonic == "leave" || mnemonic == "ret" || mnemonic == "cqto" || mnemonic == "syscall")
+    {
+        expect(0);
+        if (mnemonic == "leave")
+            byte(0xC9);
+        else if (mnemonic == "ret")
+            byte(0xC3);
+        else if (mnemonic == "cqto")
+        {
+            byte(0x48);
+            byte(0x99);
+        }
+        else
+        {
+            byte(0x0F);
+            byte(0x05);
+        }
+        return;
+    }
+    if (mnemonic == "jmp" || mnemonic == "call")
+    {
+        expect(1);
+        rel32(mnemonic == "jmp" ? 0xE9 : 0xE8, -1, ops[0]);
+        return;
+    }
+    if (mnemonic[0] == 'j' && conditions.count(mnemonic.substr(1)))
+    {
+        expect(1);
+        rel32(0x0F, 0x80 + conditions.at(mnemonic.substr(1)), ops[0]);
+        return;
+    }
+    if (mnemonic.compare(0, 3, "set") == 0 && conditions.count(mnemonic.substr(3)))
+    {
+        expect(1);
+        if (ops[0].kind == Operand::REG && ops[0].size != 8)
+            fail("'" + mnemonic + "' espera un registro de 8 bits");
+        op({}, false, {0x0F, (uint8_t)(0x90 + conditions.at(mnemonic.substr(3)))}, 0, ops[0]);
+        return;
+    }
+    if (mnemonic == "pushq" || mnemonic == "popq")
+    {
+        expect(1);
+        bool push = mnemonic == "pushq";
+        if (ops[0].kind == Operand::REG)
+        {
+            if (ops[0].reg >= 8)
+                byte(0x41);
+            byte((push ? 0x50 : 0x58) + (ops[0].reg & 7));
+        }
+        else if (push && ops[0].kind == Operand::IMM)
+        {
+            byte(0x68);
+            imm32(ops[0].imm);
+        }
+        else if (ops[0].kind == Operand::MEM)
+            op({}, false, {(uint8_t)(push ? 0xFF : 0x8F)}, push ? 6 : 0, ops[0]);
+        else
+            fail("operando no soportado en '" + mnemonic + "'");
+        return;
+    }
+    auto unary = unaryOps.find(mnemonic);
+    if (unary != unaryOps.end())
+    {
+        expect(1);
+        op({}, true, {(uint8_t)unary->second.first}, unary->second.second, ops[0]);
+        return;
+    }
+    auto sseOp = sseOps.find(mnemonic);
+    if (sseOp != sseOps.end())
+    {
+        expect(2);
+        sse(sseOp->second.first, sseOp->second.second, ops);
+        return;
+    }
+
+    if (count != 2)
+        fail("instruccion no soportada: " + mnemonic + " con " + to_string(count) + " operandos");
+    const Operand &src = ops[0];
+    const Operand &dst = ops[1];
+    string base = mnemonic.substr(0, mnemonic.size() - 1);
+    char suffix = mnemonic.back();
+    if ((suffix == 'q' || suffix == 'l') && aluOps.count(base))
+    {
+        alu(aluOps.at(base), suffix == 'q', ops);
+    }
+    else if (mnemonic == "movq" || mnemonic == "movl")
+    {
+        bool wide = mnemonic == "movq";
+        if (src.kind == Operand::IMM && dst.kind == Operand::REG && !fitsInt32(src.imm))
+        {
+            // movabs con inmediato de 64 bits
+            rex(true, 0, dst);
+            byte(0xB8 + (dst.reg & 7));
+            bytes(&src.imm, 8);
+        }
+        else if (src.kind == Operand::IMM && dst.kind == Operand::REG && !wide)
+        {
+            rex(false, 0, dst);
+            byte(0xB8 + (dst.reg & 7));
+            imm32(src.imm);
+        }
+        else if (src.kind == Operand::IMM)
+        {
+            op({}, wide, {0xC7}, 0, dst, 4);
+            imm32(src.imm);
+        }
+        else if (src.kind == Operand::REG)
+            op({}, wide, {0x89}, src.reg, dst);
+        else if (dst.kind == Operand::REG)
+            op({}, wide, {0x8B}, dst.reg, src);
+        else
+            fail("operandos no soportados en '" + mnemonic + "'");
+    }
+    else if (mnemonic == "leaq")
+    {
+        if (src.kind != Operand::MEM || dst.kind != Operand::REG)
+            fail("operandos no soportados en 'leaq'");
+        op({}, true, {0x8D}, dst.reg, src);
+    }
+    else if (mnemonic == "testq")
+    {
+        if (src.kind != Operand::REG)
+            fail("operandos no soportados en 'testq'");
+        op({}, true, {0x85}, src.reg, dst);
+    }
+    else if (mnemonic == "imulq")
+    {
+        if (dst.kind != Operand::REG)
+            fail("operandos no soportados en 'imulq'");
+        op({}, true, {0x0F, 0xAF}, dst.reg, src);
+    }
+    else if (shiftOps.count(mnemonic))
+    {
+        if (src.kind == Operand::REG && src.size == 8 && src.reg == 1)
+            op({}, true, {0xD3}, shiftOps.at(mnemonic), dst);
+        else if (src.kind == Operand::IMM)
+        {
+            op({}, true, {0xC1}, shiftOps.at(mnemonic), dst, 1);
+            byte(src.imm);
+        }
+        else
+            fail("'" + mnemonic + "' solo admite un desplazamiento inmediato o %cl");
+    }
+    else if (mnemonic == "movb")
+    {
+        // Sin REX, los códigos 4-7 de un registro de 8 bits son ah, ch, dh y bh
+        bool highByte = (src.kind == Operand::REG && src.reg >= 4 && src.reg < 8) ||
+                        (dst.kind == Operand::REG && dst.reg >= 4 && dst.reg < 8);
+        if (highByte || (src.kind == Operand::REG && src.size != 8) || (dst.kind == Operand::REG && dst.size != 8))
+            fail("operandos no soportados en 'movb'");
+        if (src.kind == Operand::IMM)
+        {
+            op({}, false, {0xC6}, 0, dst, 1);
+            byte(src.imm);
+        }
+        else if (src.kind == Operand::REG)
+            op({}, false, {0x88}, src.reg, dst);
+        else if (dst.kind == Operand::REG)
+            op({}, false, {0x8A}, dst.reg, src);
+        else
+            fail("operandos no soportados en 'movb'");
+    }
+    else if (mnemonic == "movzbq")
+    {
+        if (dst.kind != Operand::REG)
+            fail("operandos no soportados en 'movzbq'");
+        op({}, true, {0x0F, 0xB6}, dst.reg, src);
+    }
+    else if (mnemonic == "movsd" || mnemonic == "movss")
+    {
+        uint8_t prefix = mnemonic == "movsd" ? 0xF2 : 0xF3;
+        if (dst.kind == Operand::XMM)
+            sse(prefix, 0x10, ops);
+        else if (src.kind == Operand::XMM)
+            op({prefix}, false, {0x0F, 0x11}, src.reg, dst);
+        else
+            fail("operandos no soportados en '" + mnemonic + "'");
+    }
+    else if (mnemonic == "cvtsi2sd" || mnemonic == "cvtsi2sdq" || mnemonic == "cvtsi2sdl" ||
+             mnemonic == "cvtsi2ss" || mnemonic == "cvtsi2ssq" || mnemonic == "cvtsi2ssl")
+    {
+        // ss convierte a Float y sd a double; sin sufijo manda el registro de origen
+        if (dst.kind != Operand::XMM)
+            fail("el destino debe ser un registro xmm");
+        bool wide = mnemonic.back() == 'q' || (mnemonic.size() == 8 && src.kind == Operand::REG && src.size == 64);
+        op({(uint8_t)(mnemonic[7] == 's' ? 0xF3 : 0xF2)}, wide, {0x0F, 0x2A}, dst.reg, src);
+    }
+    else if (mnemonic == "cvttsd2si" || mnemonic == "cvttsd2siq" || mnemonic == "cvtsd2si" || mnemonic == "cvtsd2siq" ||
+             mnemonic == "cvttss2si" || mnemonic == "cvttss2siq" || mnemonic == "cvtss2si" || mnemonic == "cvtss2siq")
+    {
+        // cvtsd2si redondea según MXCSR (al par más cercano); cvttsd2si trunca
+        if (dst.kind != Operand::REG)
+            fail("operandos no soportados en '" + mnemonic + "'");
+        bool cvtt = mnemonic.compare(0, 4, "cvtt") == 0;
+        uint8_t prefix = mnemonic[cvtt ? 5 : 4] == 's' ? 0xF3 : 0xF2;
+        op({prefix}, dst.size == 64, {0x0F, (uint8_t)(cvtt ? 0x2C : 0x2D)}, dst.reg, src);
+    }
+    else
+        fail("instruccion no soportada: " + mnemonic);
+}
+
+void X86Assembler::assemble(const string &codigo)
+{
+    istringstream input(codigo);
+    string line;
+    int number = 0;
+    try
+    {
+        while (getline(input, line))
+        {
+            number++;
+            assembleLine(line);
+        }
+    }
+    catch (const runtime_error &e)
+    {
+        throw runtime_error("linea " + to_string(number) + ": " + e.what());
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef ASSEMBLER_H
+#define ASSEMBLER_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using namespace std;
+
+// Codificador x86-64 del subconjunto de AT&T que produce GenCodeVisitor,
+// compartido por el JIT de --run y el escritor de objetos ELF. Deja el código
+// y los datos en sections, las etiquetas en labels y los desplazamientos
+// relativos pendientes en fixups; enlazarlos queda para la clase derivada.
+// Los errores lanzan runtime_error con el motivo.
+class X86Assembler
+{
+protected:
+    enum SectionId
+    {
+        TEXT,
+        DATA,
+        RODATA,
+        IGNORED
+    };
+
+    struct Operand
+    {
+        enum Kind
+        {
+            REG,
+            XMM,
+            IMM,
+            MEM,
+            LABEL
+        };
+        Kind kind = IMM;
+        int reg = 0;   // registro, o base de MEM (RIP_BASE si es relativo a %rip)
+        int size = 64; // bits de un registro general
+        long long imm = 0;
+        int disp = 0;
+        string label;
+    };
+
+    // Desplazamiento de 32 bits relativo a la instrucción siguiente
+    struct Fixup
+    {
+        int section;
+        size_t at;
+        size_t next;
+        string label;
+    };
+
+    static const int RIP_BASE = -1;
+
+    vector<uint8_t> sections[3];
+    unordered_map<string, pair<int, size_t>> labels;
+    unordered_set<string> globals;
+    vector<Fixup> fixups;
+    int current = TEXT;
+
+    void fail(const string &motivo);
+    void assemble(const string &codigo);
+    void define(const string &label);
+    void byte(uint8_t value) { sections[current].push_back(value); }
+    void bytes(const void *data, size_t count);
+    void imm32(long long value);
+
+private:
+    void assembleLine(const string &line);
+    void directive(const string &name, const string &args);
+    void instruction(const string &mnemonic, const vector<Operand> &ops);
+    Operand parseOperand(const string &text);
+    string parseString(const string &args);
+    void rex(bool wide, int reg, const Operand &rm);
+    void modrm(int reg, const Operand &rm, size_t trailing = 0);
+    void op(const vector<uint8_t> &prefix, bool wide, const vector<uint8_t> &opcode, int reg, const Operand &rm,
+            size_t trailing = 0);
+    void rel32(uint8_t opcode1, int opcode2, const Operand &target);
+    void alu(int code, bool wide, const vector<Operand> &ops);
+    void sse(uint8_t prefix, uint8_t opcode, const vector<Operand> &ops);
+};
+
+#endif
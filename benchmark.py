@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+import subprocess
+import os
+import sys
+import re
+import glob
+import resource
+import shutil
+import tempfile
+
+REPETICIONES = 2000
+CORRIDAS = 3
+test_dir = "test"
+
+
+def escalar(codigo, repeticiones):
+    """Renombra main y la llama en un bucle para que domine la ejecución"""
+    codigo = re.sub(r"\bfun\s+main\s*\(", "fun mainBenchmark(", codigo)
+    return codigo + (
+        "\nfun main(): Unit {\n"
+        "    var repeticionBenchmark: Int = 0\n"
+        f"    while (repeticionBenchmark < {repeticiones}) {{\n"
+        "        mainBenchmark()\n"
+        "        repeticionBenchmark = repeticionBenchmark + 1\n"
+        "    }\n"
+        "}\n")
+
+
+def salida_eval(stdout):
+    lineas = stdout.split("\n")
+    if "EJECUTAR:" not in lineas:
+        return None
+    inicio = lineas.index("EJECUTAR:") + 1
+    fin = len(lineas)
+    for marca in ("PERFIL:", "GENERAR CODIGO ASSEMBLY:"):
+        if marca in lineas:
+            fin = min(fin, lineas.index(marca))
+    return lineas[inicio:fin]
+
+
+def motor(compiler, bandera, prefijo, fuente):
+    """Línea de --perfil que describe el motor, sin el prefijo"""
+    perfil = subprocess.run([compiler, bandera, "--perfil", fuente],
+                            capture_output=True, text=True, timeout=600).stdout
+    linea = next((l for l in perfil.split("\n") if l.startswith(prefijo)), "")
+    return linea.replace(prefijo, "").strip()
+
+
+def medir(comando):
+    """Mejor tiempo de CPU (usuario + sistema) entre varias corridas"""
+    mejor = None
+    result = None
+    for _ in range(CORRIDAS):
+        antes = resource.getrusage(resource.RUSAGE_CHILDREN)
+        result = subprocess.run(comando, capture_output=True, text=True, timeout=600)
+        despues = resource.getrusage(resource.RUSAGE_CHILDREN)
+        tiempo = (despues.ru_utime - antes.ru_utime) + (despues.ru_stime - antes.ru_stime)
+        mejor = tiempo if mejor is None else min(mejor, tiempo)
+    return mejor, result
+
+
+def main():
+    compiler = sys.argv[1] if len(sys.argv) > 1 else ("main.exe" if os.name == 'nt' else "./main")
+    compiler = os.path.abspath(compiler)
+    repeticiones = int(sys.argv[2]) if len(sys.argv) > 2 else REPETICIONES
+    print("⏱️  BENCHMARK - EvalVisitor vs motor enhebrado vs motor de clausuras")
+    print(f"Cada test/*.txt repite su main {repeticiones} veces; mejor de {CORRIDAS} corridas")
+    print("=" * 60)
+
+    test_files = sorted(glob.glob(os.path.join(test_dir, "*.txt")))
+    tmp_dir = tempfile.mkdtemp(prefix="bench_")
+    distintas = 0
+    totales = {"--enhebrado": [0.0, 0.0], "--clausuras": [0.0, 0.0]}
+    try:
+        for test_file in test_files:
+            nombre = os.path.splitext(os.path.basename(test_file))[0]
+            with open(test_file) as f:
+                codigo = f.read()
+            fuente = os.path.join(tmp_dir, nombre + ".txt")
+            with open(fuente, "w") as f:
+                f.write(escalar(codigo, repeticiones))
+
+            t_arbol, r_arbol = medir([compiler, fuente])
+            esperada = (r_arbol.returncode, salida_eval(r_arbol.stdout))
+            iguales = True
+            columnas = []
+            for bandera, prefijo in (("--enhebrado", "Motor enhebrado:"), ("--clausuras", "Motor de clausuras:")):
+                t_motor, r_motor = medir([compiler, bandera, fuente])
+                iguales = iguales and (r_motor.returncode, salida_eval(r_motor.stdout)) == esperada
+                descripcion = motor(compiler, bandera, prefijo, fuente)
+                if "no disponible" in descripcion:
+                    columnas.append(f"{bandera[2:]} {t_motor:7.3f}s  (no disponible)")
+                    continue
+                aceleracion = t_arbol / t_motor if t_motor > 0 else float("inf")
+                columnas.append(f"{bandera[2:]} {t_motor:7.3f}s x{aceleracion:5.2f}")
+                totales[bandera][0] += t_arbol
+                totales[bandera][1] += t_motor
+            if not iguales:
+                distintas += 1
+            marca = "✅" if iguales else "❌"
+            print(f"{marca} {nombre:8} arbol {t_arbol:7.3f}s  " + "  ".join(columnas))
+    finally:
+        shutil.rmtree(tmp_dir, ignore_errors=True)
+
+    print("=" * 60)
+    for bandera, (t_arbol, t_motor) in totales.items():
+        if t_motor > 0:
+            print(f"📊 Programas con {bandera[2:]}: arbol {t_arbol:.3f}s, motor "
+                  f"{t_motor:.3f}s (x{t_arbol / t_motor:.2f})")
+    if distintas == 0:
+        print("🎉 ¡Los tres motores produjeron la misma salida!")
+    else:
+        print(f"⚠️  {distintas} programa(s) con salidas distintas")
+    sys.exit(1 if distintas else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,1141 @@
+#include "closure.h"
+#include "output.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+void ClosureContext::reserve(size_t cellsNeeded, size_t stringsNeeded)
+{
+    if (cellsNeeded > cells.size())
+    {
+        size_t fpOffset = fp - cells.data();
+        cells.resize(max(cells.size() * 2, cellsNeeded));
+        fp = cells.data() + fpOffset;
+    }
+    if (stringsNeeded > strings.size())
+    {
+        size_t sfpOffset = sfp - strings.data();
+        strings.resize(max(strings.size() * 2, stringsNeeded));
+        sfp = strings.data() + sfpOffset;
+    }
+}
+
+// Ranuras resueltas al compilar: las locales son relativas al marco actual
+template <bool Global>
+static SlotCell &cellAt(ClosureContext &ctx, int index)
+{
+    return Global ? ctx.globalCells[index] : ctx.fp[index];
+}
+
+template <bool Global>
+static string &stringAt(ClosureContext &ctx, int index)
+{
+    return Global ? ctx.globalStrings[index] : ctx.sfp[index];
+}
+
+template <typename T>
+static T &member(SlotCell &cell);
+
+template <>
+int &member<int>(SlotCell &cell)
+{
+    return cell.i;
+}
+
+template <>
+float &member<float>(SlotCell &cell)
+{
+    return cell.f;
+}
+
+template <typename T, typename R, typename Op>
+static function<R(ClosureContext &)> binary(function<T(ClosureContext &)> l, function<T(ClosureContext &)> r, Op op)
+{
+    return [l = std::move(l), r = std::move(r), op](ClosureContext &ctx) -> R {
+        T a = l(ctx);
+        return op(a, r(ctx));
+    };
+}
+
+static int modulo(int a, int b)
+{
+    return a % b;
+}
+
+static float modulo(float a, float b)
+{
+    return fmod(a, b);
+}
+
+template <typename T>
+static function<T(ClosureContext &)> arithmetic(int op, function<T(ClosureContext &)> l, function<T(ClosureContext &)> r)
+{
+    switch (op)
+    {
+    case PLUS_OP:
+        return binary<T, T>(std::move(l), std::move(r), plus<T>());
+    case MINUS_OP:
+        return binary<T, T>(std::move(l), std::move(r), minus<T>());
+    case MUL_OP:
+        return binary<T, T>(std::move(l), std::move(r), multiplies<T>());
+    case DIV_OP:
+        return binary<T, T>(std::move(l), std::move(r), divides<T>());
+    default:
+        return binary<T, T>(std::move(l), std::move(r), [](T a, T b) { return modulo(a, b); });
+    }
+}
+
+template <typename T>
+static function<T(T, T)> operation(int op)
+{
+    switch (op)
+    {
+    case PLUS_OP:
+        return plus<T>();
+    case MINUS_OP:
+        return minus<T>();
+    case MUL_OP:
+        return multiplies<T>();
+    case DIV_OP:
+        return divides<T>();
+    default:
+        return [](T a, T b) { return modulo(a, b); };
+    }
+}
+
+template <typename T>
+static IntClosure comparison(int op, function<T(ClosureContext &)> l, function<T(ClosureContext &)> r)
+{
+    switch (op)
+    {
+    case LT_OP:
+        return binary<T, int>(std::move(l), std::move(r), less<T>());
+    case LE_OP:
+        return binary<T, int>(std::move(l), std::move(r), less_equal<T>());
+    case GT_OP:
+        return binary<T, int>(std::move(l), std::move(r), greater<T>());
+    case GE_OP:
+        return binary<T, int>(std::move(l), std::move(r), greater_equal<T>());
+    case EQ_OP:
+        return binary<T, int>(std::move(l), std::move(r), equal_to<T>());
+    default:
+        return binary<T, int>(std::move(l), std::move(r), not_equal_to<T>());
+    }
+}
+
+template <bool Global>
+static ClosureExp loadSlot(int type, int index)
+{
+    ClosureExp exp;
+    exp.type = type;
+    if (type == 5)
+        exp.s = [index](ClosureContext &ctx) { return stringAt<Global>(ctx, index); };
+    else if (type == 2)
+        exp.f = [index](ClosureContext &ctx) { return cellAt<Global>(ctx, index).f; };
+    else
+        exp.i = [index](ClosureContext &ctx) { return cellAt<Global>(ctx, index).i; };
+    return exp;
+}
+
+template <bool Global>
+static StmClosure storeSlot(int index, const ClosureExp &value)
+{
+    if (value.type == 5)
+    {
+        StringClosure s = value.s;
+        return [index, s](ClosureContext &ctx) {
+            string v = s(ctx);
+            stringAt<Global>(ctx, index) = std::move(v);
+            return (int)FLOW_NEXT;
+        };
+    }
+    if (value.type == 2)
+    {
+        FloatClosure f = value.f;
+        return [index, f](ClosureContext &ctx) {
+            float v = f(ctx);
+            cellAt<Global>(ctx, index).f = v;
+            return (int)FLOW_NEXT;
+        };
+    }
+    IntClosure i = value.i;
+    return [index, i](ClosureContext &ctx) {
+        int v = i(ctx);
+        cellAt<Global>(ctx, index).i = v;
+        return (int)FLOW_NEXT;
+    };
+}
+
+template <bool Global, typename T>
+static function<T(ClosureContext &)> incrementSlot(int index, int delta, bool post)
+{
+    if (post)
+    {
+        return [index, delta](ClosureContext &ctx) {
+            T &value = member<T>(cellAt<Global>(ctx, index));
+            T old = value;
+            value = value + (T)delta;
+            return old;
+        };
+    }
+    return [index, delta](ClosureContext &ctx) {
+        T &value = member<T>(cellAt<Global>(ctx, index));
+        value = value + (T)delta;
+        return value;
+    };
+}
+
+// Asignación compuesta numérica: primero el lado derecho, después la variable
+template <bool Global, typename T>
+static StmClosure compoundSlot(int index, function<T(ClosureContext &)> value, function<T(T, T)> op)
+{
+    return [index, value, op](ClosureContext &ctx) {
+        T v = value(ctx);
+        T &target = member<T>(cellAt<Global>(ctx, index));
+        target = op(target, v);
+        return (int)FLOW_NEXT;
+    };
+}
+
+template <bool Global>
+static StmClosure concatSlot(int index, StringClosure value)
+{
+    return [index, value](ClosureContext &ctx) {
+        string v = value(ctx);
+        stringAt<Global>(ctx, index) += v;
+        return (int)FLOW_NEXT;
+    };
+}
+
+static StmClosure sequence(const vector<StmClosure> &stms)
+{
+    if (stms.empty())
+        return [](ClosureContext &) { return (int)FLOW_NEXT; };
+    if (stms.size() == 1)
+        return stms[0];
+    return [stms](ClosureContext &ctx) {
+        for (auto &stm : stms)
+        {
+            int flow = stm(ctx);
+            if (flow != FLOW_NEXT)
+                return flow;
+        }
+        return (int)FLOW_NEXT;
+    };
+}
+
+// Evalúa los argumentos en las ranuras de los parámetros de un marco nuevo
+static void bindArguments(ClosureContext &ctx, const vector<ClosureArgument> &args, size_t base, size_t sbase)
+{
+    for (auto &arg : args)
+    {
+        if (arg.value.type == 5)
+        {
+            string v = arg.value.s(ctx);
+            ctx.strings[sbase + arg.index] = std::move(v);
+        }
+        else if (arg.value.type == 2)
+        {
+            float v = arg.value.f(ctx);
+            ctx.cells[base + arg.index].f = v;
+        }
+        else
+        {
+            int v = arg.value.i(ctx);
+            ctx.cells[base + arg.index].i = v;
+        }
+    }
+}
+
+// Deja el valor devuelto en ctx.result o ctx.stringResult
+static void invoke(ClosureContext &ctx, const ClosureFunction &fn, const vector<ClosureArgument> &args, bool memo)
+{
+    size_t base = ctx.top;
+    size_t sbase = ctx.stringTop;
+    ctx.reserve(base + fn.localCells, sbase + fn.localStrings);
+    ctx.top += fn.localCells;
+    ctx.stringTop += fn.localStrings;
+    bindArguments(ctx, args, base, sbase);
+
+    size_t slot = 0;
+    vector<SlotCell> memoCells;
+    vector<string> memoStrings;
+    if (memo)
+    {
+        SlotCell *cells = ctx.cells.data() + base;
+        string *strings = ctx.strings.data() + sbase;
+        slot = ctx.memo.slot(fn.index, cells, fn.paramCells, strings, fn.paramStrings);
+        if (ctx.memo.matches(slot, fn.index, cells, fn.paramCells, strings, fn.paramStrings))
+        {
+            ctx.memo.hits++;
+            if (fn.decl->returnTypeCode == 5)
+                ctx.stringResult = ctx.memo[slot].stringResult;
+            else
+                ctx.result = ctx.memo[slot].result;
+            ctx.top = base;
+            ctx.stringTop = sbase;
+            return;
+        }
+        ctx.memo.misses++;
+        memoCells.assign(cells, cells + fn.paramCells);
+        memoStrings.assign(strings, strings + fn.paramStrings);
+    }
+
+    size_t callerFp = ctx.fp - ctx.cells.data();
+    size_t callerSfp = ctx.sfp - ctx.strings.data();
+    ctx.fp = ctx.cells.data() + base;
+    ctx.sfp = ctx.strings.data() + sbase;
+    while (fn.body(ctx) == FLOW_TAIL_CALL)
+        ;
+    if (fn.decl->returnTypeCode == 0)
+        ctx.result.i = 0;
+
+    if (memo)
+    {
+        MemoTable::Entry &entry = ctx.memo[slot];
+        entry.func = fn.index;
+        entry.cells.swap(memoCells);
+        entry.strings.swap(memoStrings);
+        if (fn.decl->returnTypeCode == 5)
+            entry.stringResult = ctx.stringResult;
+        else
+            entry.result = ctx.result;
+    }
+    ctx.fp = ctx.cells.data() + callerFp;
+    ctx.sfp = ctx.strings.data() + callerSfp;
+    ctx.top = base;
+    ctx.stringTop = sbase;
+}
+
+void ClosureCompiler::compilar(Program *program)
+{
+    vector<FunctionDecl *> functions;
+    vector<VarDec *> globalDecs;
+    FunctionDecl *mainFunc = prepare(program, functions, globalDecs);
+    out.functions.resize(functions.size());
+    for (size_t i = 0; i < functions.size(); i++)
+    {
+        functionIndex[functions[i]] = i;
+        out.functions[i].decl = functions[i];
+        out.functions[i].index = i;
+    }
+    out.main = functionIndex[mainFunc];
+
+    for (auto dec : globalDecs)
+        out.globalInits.push_back(compileStm(dec));
+    out.globalCells = globalCells;
+    out.globalStrings = globalStrings;
+
+    for (auto func : functions)
+        compileFunction(func);
+}
+
+void ClosureCompiler::compileFunction(FunctionDecl *func)
+{
+    ClosureFunction &compiled = out.functions[functionIndex[func]];
+    beginFunction(func);
+    compiled.paramCells = localCells;
+    compiled.paramStrings = localStrings;
+
+    vector<StmClosure> body;
+    for (auto stmt : func->body->statements->stms)
+        body.push_back(compileStm(stmt));
+    endFunction(func);
+
+    compiled.body = sequence(body);
+    compiled.localCells = localCells;
+    compiled.localStrings = localStrings;
+}
+
+ClosureExp ClosureCompiler::compileExp(Exp *exp)
+{
+    walk(exp);
+    ClosureExp result = std::move(values.back());
+    values.pop_back();
+    return result;
+}
+
+IntClosure ClosureCompiler::compileCondition(Exp *exp)
+{
+    ClosureExp condition = compileExp(exp);
+    checkCondition(condition.type);
+    return condition.i;
+}
+
+StmClosure ClosureCompiler::compileStm(Stm *stm)
+{
+    compiled = nullptr;
+    stm->accept(this);
+    out.closures++;
+    return compiled;
+}
+
+StmClosure ClosureCompiler::compileBody(Stm *stm)
+{
+    Block *block = dynamic_cast<Block *>(stm);
+    if (!block)
+        return compileStm(stm);
+    scopes.push_back(unordered_map<string, Slot>());
+    vector<StmClosure> stms;
+    for (auto s : block->statements->stms)
+        stms.push_back(compileStm(s));
+    scopes.pop_back();
+    return sequence(stms);
+}
+
+ClosureExp ClosureCompiler::finish(ClosureExp exp)
+{
+    out.closures++;
+    return exp;
+}
+
+// Conversión a otro tipo numérico o Boolean, con las mismas reglas que
+// bindArguments
+ClosureExp ClosureCompiler::convert(ClosureExp exp, int to)
+{
+    checkConversion(exp.type, to);
+    int from = exp.type;
+    exp.type = to;
+    if (from == to || (to == 1 && from == 3))
+        return exp;
+    if (to == 1)
+        exp.i = [f = std::move(exp.f)](ClosureContext &ctx) { return (int)f(ctx); };
+    else if (to == 2)
+        exp.f = [i = std::move(exp.i)](ClosureContext &ctx) { return (float)i(ctx); };
+    else
+        exp.i = [i = std::move(exp.i)](ClosureContext &ctx) { return (int)(i(ctx) != 0); };
+    return finish(exp);
+}
+
+FloatClosure ClosureCompiler::toFloat(ClosureExp exp)
+{
+    if (exp.type == 2)
+        return std::move(exp.f);
+    return [i = std::move(exp.i)](ClosureContext &ctx) { return (float)i(ctx); };
+}
+
+StringClosure ClosureCompiler::toString(ClosureExp exp)
+{
+    if (exp.type == 5)
+        return std::move(exp.s);
+    if (exp.type == 2)
+        return [f = std::move(exp.f)](ClosureContext &ctx) { return formatFloat(f(ctx)); };
+    if (exp.type == 3)
+        return [i = std::move(exp.i)](ClosureContext &ctx) { return string(i(ctx) ? "true" : "false"); };
+    return [i = std::move(exp.i)](ClosureContext &ctx) { return to_string(i(ctx)); };
+}
+
+ClosureExp ClosureCompiler::load(const Slot &slot)
+{
+    return finish(slot.global ? loadSlot<true>(slot.type, slot.index) : loadSlot<false>(slot.type, slot.index));
+}
+
+StmClosure ClosureCompiler::store(const Slot &slot, const ClosureExp &value)
+{
+    return slot.global ? storeSlot<true>(slot.index, value) : storeSlot<false>(slot.index, value);
+}
+
+ClosureExp ClosureCompiler::increment(const Slot &slot, int delta, bool post)
+{
+    ClosureExp exp;
+    exp.type = slot.type;
+    if (slot.type == 1)
+        exp.i = slot.global ? incrementSlot<true, int>(slot.index, delta, post)
+                            : incrementSlot<false, int>(slot.index, delta, post);
+    else
+        exp.f = slot.global ? incrementSlot<true, float>(slot.index, delta, post)
+                            : incrementSlot<false, float>(slot.index, delta, post);
+    return finish(exp);
+}
+
+StmClosure ClosureCompiler::discard(const ClosureExp &exp)
+{
+    if (exp.type == 5)
+    {
+        StringClosure s = exp.s;
+        return [s](ClosureContext &ctx) {
+            s(ctx);
+            return (int)FLOW_NEXT;
+        };
+    }
+    if (exp.type == 2)
+    {
+        FloatClosure f = exp.f;
+        return [f](ClosureContext &ctx) {
+            f(ctx);
+            return (int)FLOW_NEXT;
+        };
+    }
+    IntClosure i = exp.i;
+    return [i](ClosureContext &ctx) {
+        i(ctx);
+        return (int)FLOW_NEXT;
+    };
+}
+
+vector<ClosureArgument> ClosureCompiler::compileArguments(FunctionCallExp *call)
+{
+    FunctionDecl *func = call->decl;
+    if (!func || !functionIndex.count(func) || call->args.size() != func->paramTypes.size())
+        fail("llamada sin resolver a '" + call->name + "'");
+    vector<ClosureArgument> args;
+    int cells = 0, strings = 0;
+    size_t i = 0;
+    for (auto arg : call->args)
+    {
+        int type = func->paramTypes[i++];
+        ClosureArgument bound;
+        bound.value = convert(compileExp(arg), type);
+        bound.index = type == 5 ? strings++ : cells++;
+        args.push_back(std::move(bound));
+    }
+    return args;
+}
+
+void ClosureCompiler::onLeaf(Exp *exp)
+{
+    exp->accept(this);
+}
+
+// La profundidad se cuenta al bajar, antes de componer ninguna clausura
+void ClosureCompiler::onEnter(Exp *exp)
+{
+    if (nodeKind(exp) != PAREN_NODE && ++nesting >= MAX_DEPTH)
+        fail("expresion demasiado profunda");
+}
+
+void ClosureCompiler::onExit(Exp *exp)
+{
+    int kind = nodeKind(exp);
+    if (kind == UNARY_NODE)
+    {
+        UnaryExp *unary = static_cast<UnaryExp *>(exp);
+        ClosureExp operand = std::move(values.back());
+        values.pop_back();
+        nesting--;
+        ClosureExp result;
+        result.type = unaryType(unary->op, operand.type);
+        if (unary->op == UnaryExp::NOT_OP)
+            result.i = [i = std::move(operand.i)](ClosureContext &ctx) { return (int)!i(ctx); };
+        else if (operand.type == 1)
+            result.i = [i = std::move(operand.i)](ClosureContext &ctx) { return -i(ctx); };
+        else
+            result.f = [f = std::move(operand.f)](ClosureContext &ctx) { return -f(ctx); };
+        values.push_back(finish(std::move(result)));
+        return;
+    }
+    if (kind != BINARY_NODE)
+        return;
+
+    nesting--;
+    BinaryExp *bin = static_cast<BinaryExp *>(exp);
+    ClosureExp right = std::move(values.back());
+    values.pop_back();
+    ClosureExp left = std::move(values.back());
+    values.pop_back();
+    ClosureExp result;
+    result.type = binaryType(bin->op, left.type, right.type);
+
+    // Los hijos se mueven a la clausura del padre: copiarlos copiaría todo el
+    // subárbol en cada nivel
+    if (bin->op == AND_OP)
+        result.i = [l = std::move(left.i), r = std::move(right.i)](ClosureContext &ctx) { return l(ctx) ? (int)(r(ctx) != 0) : 0; };
+    else if (bin->op == OR_OP)
+        result.i = [l = std::move(left.i), r = std::move(right.i)](ClosureContext &ctx) { return l(ctx) ? 1 : (int)(r(ctx) != 0); };
+    else if (result.type == 5)
+    {
+        result.s = [a = toString(std::move(left)), b = toString(std::move(right))](ClosureContext &ctx) {
+            string value = a(ctx);
+            value += b(ctx);
+            return value;
+        };
+    }
+    else if (bin->op <= MOD_OP)
+    {
+        if (result.type == 1)
+            result.i = arithmetic<int>(bin->op, std::move(left.i), std::move(right.i));
+        else
+            result.f = arithmetic<float>(bin->op, toFloat(std::move(left)), toFloat(std::move(right)));
+    }
+    else if (left.type == 5)
+    {
+        if (bin->op == EQ_OP)
+            result.i = binary<string, int>(std::move(left.s), std::move(right.s), equal_to<string>());
+        else
+            result.i = binary<string, int>(std::move(left.s), std::move(right.s), not_equal_to<string>());
+    }
+    else if (left.type == 2 || right.type == 2)
+        result.i = comparison<float>(bin->op, toFloat(std::move(left)), toFloat(std::move(right)));
+    else
+        result.i = comparison<int>(bin->op, std::move(left.i), std::move(right.i));
+    values.push_back(finish(std::move(result)));
+}
+
+int ClosureCompiler::visit(BinaryExp *exp)
+{
+    values.push_back(compileExp(exp));
+    return values.back().type;
+}
+
+int ClosureCompiler::visit(ParenthesizedExp *exp)
+{
+    values.push_back(compileExp(exp));
+    return values.back().type;
+}
+
+int ClosureCompiler::visit(NumberExp *exp)
+{
+    ClosureExp result;
+    int value = exp->value;
+    result.i = [value](ClosureContext &) { return value; };
+    values.push_back(finish(result));
+    return 1;
+}
+
+int ClosureCompiler::visit(DecimalExp *exp)
+{
+    ClosureExp result;
+    result.type = 2;
+    float value = exp->value;
+    result.f = [value](ClosureContext &) { return value; };
+    values.push_back(finish(result));
+    return 2;
+}
+
+int ClosureCompiler::visit(BoolExp *exp)
+{
+    ClosureExp result;
+    result.type = 3;
+    int value = exp->value ? 1 : 0;
+    result.i = [value](ClosureContext &) { return value; };
+    values.push_back(finish(result));
+    return 3;
+}
+
+int ClosureCompiler::visit(StringExp *exp)
+{
+    ClosureExp result;
+    result.type = 5;
+    string value = exp->value;
+    result.s = [value](ClosureContext &) { return value; };
+    values.push_back(finish(result));
+    return 5;
+}
+
+int ClosureCompiler::visit(IdentifierExp *exp)
+{
+    values.push_back(load(lookup(exp->name)));
+    return values.back().type;
+}
+
+int ClosureCompiler::visit(RangeExp *exp)
+{
+    fail("rango fuera de un for");
+    return -1;
+}
+
+int ClosureCompiler::visit(RunExp *exp)
+{
+    fail("expresion run");
+    return -1;
+}
+
+int ClosureCompiler::visit(FunctionCallExp *exp)
+{
+    // Las globales todavía no están todas declaradas mientras se inicializan
+    if (!function)
+        fail("llamada en el inicializador de una global");
+    // Los argumentos cuentan un nivel más, como los operandos
+    if (++nesting >= MAX_DEPTH)
+        fail("expresion demasiado profunda");
+    vector<ClosureArgument> args = compileArguments(exp);
+    nesting--;
+    const ClosureFunction *fn = &out.functions[functionIndex[exp->decl]];
+    bool memo = exp->decl->isPure && exp->decl->returnTypeCode > 0;
+
+    ClosureExp result;
+    result.type = exp->decl->returnTypeCode > 0 ? exp->decl->returnTypeCode : 1;
+    if (result.type == 5)
+    {
+        result.s = [fn, args = std::move(args), memo](ClosureContext &ctx) {
+            invoke(ctx, *fn, args, memo);
+            return std::move(ctx.stringResult);
+        };
+    }
+    else if (result.type == 2)
+    {
+        result.f = [fn, args = std::move(args), memo](ClosureContext &ctx) {
+            invoke(ctx, *fn, args, memo);
+            return ctx.result.f;
+        };
+    }
+    else
+    {
+        result.i = [fn, args = std::move(args), memo](ClosureContext &ctx) {
+            invoke(ctx, *fn, args, memo);
+            return ctx.result.i;
+        };
+    }
+    values.push_back(finish(result));
+    return result.type;
+}
+
+int ClosureCompiler::visit(UnaryExp *exp)
+{
+    if (isOperatorNode(exp))
+    {
+        values.push_back(compileExp(exp));
+        return values.back().type;
+    }
+
+    IdentifierExp *id = dynamic_cast<IdentifierExp *>(exp->expr);
+    if (!id)
+        fail("incremento sobre algo que no es una variable");
+    Slot slot = lookup(id->name);
+    if (slot.type != 1 && slot.type != 2)
+        fail("incremento de una variable que no es Int ni Float");
+
+    int delta = (exp->op == UnaryExp::PRE_INC_OP || exp->op == UnaryExp::POST_INC_OP) ? 1 : -1;
+    bool post = exp->op == UnaryExp::POST_INC_OP || exp->op == UnaryExp::POST_DEC_OP;
+    values.push_back(increment(slot, delta, post));
+    return slot.type;
+}
+
+StmClosure ClosureCompiler::compileUpdate(const string &id, int op, Exp *rhs)
+{
+    Slot slot = lookup(id);
+    if (op == AssignStatement::INCREMENT_OP || op == AssignStatement::DECREMENT_OP ||
+        op == AssignStatement::POST_INCREMENT_OP || op == AssignStatement::POST_DECREMENT_OP)
+    {
+        if (slot.type != 1 && slot.type != 2)
+            return sequence({});
+        int delta = (op == AssignStatement::INCREMENT_OP || op == AssignStatement::POST_INCREMENT_OP) ? 1 : -1;
+        return discard(increment(slot, delta, false));
+    }
+
+    ClosureExp value = compileExp(rhs);
+    // Las combinaciones que no cambian la variable solo evalúan el lado derecho
+    if (!checkCompound(slot, op, value.type))
+        return discard(value);
+    if (slot.type == 5)
+        return slot.global ? concatSlot<true>(slot.index, toString(std::move(value))) : concatSlot<false>(slot.index, toString(std::move(value)));
+
+    int binaryOp = MOD_OP;
+    switch (op)
+    {
+    case AssignStatement::PLUS_ASSIGN_OP:
+        binaryOp = PLUS_OP;
+        break;
+    case AssignStatement::MINUS_ASSIGN_OP:
+        binaryOp = MINUS_OP;
+        break;
+    case AssignStatement::MUL_ASSIGN_OP:
+        binaryOp = MUL_OP;
+        break;
+    case AssignStatement::DIV_ASSIGN_OP:
+        binaryOp = DIV_OP;
+        break;
+    }
+    ClosureExp converted = convert(std::move(value), slot.type);
+    if (slot.type == 1)
+        return slot.global ? compoundSlot<true, int>(slot.index, converted.i, operation<int>(binaryOp))
+                           : compoundSlot<false, int>(slot.index, converted.i, operation<int>(binaryOp));
+    return slot.global ? compoundSlot<true, float>(slot.index, converted.f, operation<float>(binaryOp))
+                       : compoundSlot<false, float>(slot.index, converted.f, operation<float>(binaryOp));
+}
+
+void ClosureCompiler::visit(AssignStatement *stm)
+{
+    if (stm->op != AssignStatement::ASSIGN_OP)
+    {
+        compiled = compileUpdate(stm->id, stm->op, stm->rhs);
+        return;
+    }
+
+    Slot slot = lookup(stm->id);
+    ClosureExp value = compileExp(stm->rhs);
+    checkAssign(stm->id, slot, value.type);
+    compiled = store(slot, convert(value, slot.type));
+}
+
+void ClosureCompiler::visit(PrintStatement *stm)
+{
+    ClosureExp value = compileExp(stm->e);
+    bool newline = stm->newline;
+    if (value.type == 5)
+    {
+        StringClosure s = value.s;
+        compiled = [s, newline](ClosureContext &ctx) {
+            salidaPrograma.escribir(s(ctx));
+            if (newline)
+                salidaPrograma.saltoDeLinea();
+            return (int)FLOW_NEXT;
+        };
+    }
+    else if (value.type == 2)
+    {
+        FloatClosure f = value.f;
+        compiled = [f, newline](ClosureContext &ctx) {
+            salidaPrograma.escribirFlotante(f(ctx));
+            if (newline)
+                salidaPrograma.saltoDeLinea();
+            return (int)FLOW_NEXT;
+        };
+    }
+    else if (value.type == 1 || value.type == 3)
+    {
+        IntClosure i = value.i;
+        bool boolean = value.type == 3;
+        compiled = [i, newline, boolean](ClosureContext &ctx) {
+            int v = i(ctx);
+            if (boolean)
+                salidaPrograma.escribirBooleano(v);
+            else
+                salidaPrograma.escribirEntero(v);
+            if (newline)
+                salidaPrograma.saltoDeLinea();
+            return (int)FLOW_NEXT;
+        };
+    }
+    else
+    {
+        fail("print de un valor no soportado");
+    }
+}
+
+void ClosureCompiler::visit(ExpressionStatement *stm)
+{
+    compiled = discard(compileExp(stm->expr));
+}
+
+void ClosureCompiler::visit(IfStatement *stm)
+{
+    IntClosure condition = compileCondition(stm->condition);
+    StmClosure thenStm = compileBody(stm->thenStmt);
+    if (!stm->elseStmt)
+    {
+        compiled = [condition, thenStm](ClosureContext &ctx) {
+            return condition(ctx) ? thenStm(ctx) : (int)FLOW_NEXT;
+        };
+        return;
+    }
+    StmClosure elseStm = compileBody(stm->elseStmt);
+    compiled = [condition, thenStm, elseStm](ClosureContext &ctx) {
+        return condition(ctx) ? thenStm(ctx) : elseStm(ctx);
+    };
+}
+
+void ClosureCompiler::visit(WhileStatement *stm)
+{
+    loopDepth++;
+    StmClosure body = compileBody(stm->stmt);
+    loopDepth--;
+    IntClosure condition = compileCondition(stm->condition);
+    compiled = [condition, body](ClosureContext &ctx) {
+        while (condition(ctx))
+        {
+            int flow = body(ctx);
+            if (flow == FLOW_BREAK)
+                break;
+            if (flow >= FLOW_RETURN)
+                return flow;
+        }
+        return (int)FLOW_NEXT;
+    };
+}
+
+void ClosureCompiler::visit(DoWhileStatement *stm)
+{
+    loopDepth++;
+    StmClosure body = compileBody(stm->stmt);
+    loopDepth--;
+    IntClosure condition = compileCondition(stm->condition);
+    compiled = [condition, body](ClosureContext &ctx) {
+        do
+        {
+            int flow = body(ctx);
+            if (flow == FLOW_BREAK)
+                break;
+            if (flow >= FLOW_RETURN)
+                return flow;
+        } while (condition(ctx));
+        return (int)FLOW_NEXT;
+    };
+}
+
+// El contador vive en la clausura; la variable del for se declara en el nivel
+// actual y recibe el contador en cada vuelta, como env.update en el intérprete.
+void ClosureCompiler::visit(ForStatement *stm)
+{
+    RangeExp *range = dynamic_cast<RangeExp *>(stm->range);
+    if (!range || scopes.empty())
+        fail("for que no recorre un rango");
+
+    IntClosure bounds[3];
+    Exp *exps[] = {range->start, range->end, range->step};
+    for (int i = 0; i < 3; i++)
+    {
+        if (!exps[i])
+        {
+            bounds[i] = [](ClosureContext &) { return 1; };
+            continue;
+        }
+        ClosureExp bound = compileExp(exps[i]);
+        if (bound.type != 1 && bound.type != 3)
+            fail("limite de rango que no es Int");
+        bounds[i] = bound.i;
+    }
+    IntClosure start = bounds[0], end = bounds[1], step = bounds[2];
+    int var = declare(stm->id, 1).index;
+    bool until = range->until;
+
+    loopDepth++;
+    StmClosure body = compileBody(stm->stmt);
+    loopDepth--;
+
+    if (range->downTo)
+    {
+        compiled = [start, end, step, var, until, body](ClosureContext &ctx) {
+            int counter = start(ctx);
+            int last = end(ctx);
+            int by = step(ctx);
+            if (by == 0)
+            {
+                salidaPrograma.escribir("Error: step no puede ser 0 en un rango\n");
+                return (int)FLOW_NEXT;
+            }
+            int limit = until ? last : last - 1;
+            by = by > 0 ? -by : by;
+            ctx.fp[var].i = counter;
+            for (; counter > limit; counter += by)
+            {
+                ctx.fp[var].i = counter;
+                int flow = body(ctx);
+                if (flow == FLOW_BREAK)
+                    break;
+                if (flow >= FLOW_RETURN)
+                    return flow;
+            }
+            return (int)FLOW_NEXT;
+        };
+        return;
+    }
+    compiled = [start, end, step, var, until, body](ClosureContext &ctx) {
+        int counter = start(ctx);
+        int last = end(ctx);
+        int by = step(ctx);
+        if (by == 0)
+        {
+            salidaPrograma.escribir("Error: step no puede ser 0 en un rango\n");
+            return (int)FLOW_NEXT;
+        }
+        int limit = until ? last : last + 1;
+        ctx.fp[var].i = counter;
+        for (; counter < limit; counter += by)
+        {
+            ctx.fp[var].i = counter;
+            int flow = body(ctx);
+            if (flow == FLOW_BREAK)
+                break;
+            if (flow >= FLOW_RETURN)
+                return flow;
+        }
+        return (int)FLOW_NEXT;
+    };
+}
+
+void ClosureCompiler::visit(VarDec *stm)
+{
+    int type = typeCode(stm->type);
+    ClosureExp value;
+    if (stm->value)
+    {
+        value = compileExp(stm->value);
+        checkVarDec(stm, value.type);
+        value = convert(value, type);
+    }
+    else
+    {
+        value.type = type;
+        if (type == 5)
+            value.s = [](ClosureContext &) { return string(); };
+        else if (type == 2)
+            value.f = [](ClosureContext &) { return 0.0f; };
+        else
+            value.i = [](ClosureContext &) { return 0; };
+    }
+    compiled = store(declare(stm->id, type), value);
+}
+
+void ClosureCompiler::visit(VarDecList *stm)
+{
+    vector<StmClosure> decls;
+    for (auto dec : stm->decls)
+        decls.push_back(compileStm(dec));
+    compiled = sequence(decls);
+}
+
+void ClosureCompiler::visit(StatementList *stm)
+{
+    vector<StmClosure> stms;
+    for (auto s : stm->stms)
+        stms.push_back(compileStm(s));
+    compiled = sequence(stms);
+}
+
+// Un bloque suelto solo se ejecuta dentro de un if o un bucle del llamador
+void ClosureCompiler::visit(Block *stm)
+{
+    fail("bloque suelto");
+}
+
+void ClosureCompiler::visit(RunBlock *stm)
+{
+    fail("bloque run");
+}
+
+void ClosureCompiler::visit(FunctionDecl *stm)
+{
+    fail("funcion anidada");
+}
+
+void ClosureCompiler::visit(ReturnStatement *stm)
+{
+    FunctionDecl *func = function;
+    if (!func)
+        fail("return fuera de una funcion");
+
+    FunctionCallExp *call = dynamic_cast<FunctionCallExp *>(stm->expr);
+    if (call && call->decl == func)
+    {
+        // Llamada de cola a sí misma: se reemplazan los parámetros y se vuelve
+        // a correr el cuerpo en el mismo marco
+        vector<ClosureArgument> args = compileArguments(call);
+        const ClosureFunction *fn = &out.functions[functionIndex[func]];
+        compiled = [fn, args](ClosureContext &ctx) {
+            size_t base = ctx.top;
+            size_t sbase = ctx.stringTop;
+            ctx.reserve(base + fn->paramCells, sbase + fn->paramStrings);
+            ctx.top += fn->paramCells;
+            ctx.stringTop += fn->paramStrings;
+            bindArguments(ctx, args, base, sbase);
+            copy(ctx.cells.begin() + base, ctx.cells.begin() + base + fn->paramCells, ctx.fp);
+            for (int i = 0; i < fn->paramStrings; i++)
+                ctx.sfp[i] = std::move(ctx.strings[sbase + i]);
+            ctx.top = base;
+            ctx.stringTop = sbase;
+            return (int)FLOW_TAIL_CALL;
+        };
+        return;
+    }
+
+    int returnType = func->returnTypeCode;
+    if (returnType == 0)
+    {
+        StmClosure value = stm->expr ? discard(compileExp(stm->expr)) : sequence({});
+        compiled = [value](ClosureContext &ctx) {
+            value(ctx);
+            return (int)FLOW_RETURN;
+        };
+        return;
+    }
+
+    if (!stm->expr)
+        fail("return sin valor en '" + func->name + "'");
+    ClosureExp value = compileExp(stm->expr);
+    checkReturn(value.type);
+    if (returnType == 5)
+    {
+        StringClosure s = value.s;
+        compiled = [s](ClosureContext &ctx) {
+            ctx.stringResult = s(ctx);
+            return (int)FLOW_RETURN;
+        };
+    }
+    else if (returnType == 2)
+    {
+        FloatClosure f = value.f;
+        compiled = [f](ClosureContext &ctx) {
+            ctx.result.f = f(ctx);
+            return (int)FLOW_RETURN;
+        };
+    }
+    else
+    {
+        IntClosure i = value.i;
+        compiled = [i](ClosureContext &ctx) {
+            ctx.result.i = i(ctx);
+            return (int)FLOW_RETURN;
+        };
+    }
+}
+
+void ClosureCompiler::visit(BreakStatement *stm)
+{
+    if (loopDepth == 0)
+        fail("break fuera de un bucle");
+    compiled = [](ClosureContext &) { return (int)FLOW_BREAK; };
+}
+
+void ClosureCompiler::visit(ContinueStatement *stm)
+{
+    if (loopDepth == 0)
+        fail("continue fuera de un bucle");
+    compiled = [](ClosureContext &) { return (int)FLOW_CONTINUE; };
+}
+
+bool ClosureEngine::compilar(Program *programa)
+{
+    program = ClosureProgram();
+    ClosureCompiler compiler(program);
+    try
+    {
+        compiler.compilar(programa);
+    }
+    catch (const runtime_error &e)
+    {
+        motivo = e.what();
+        compilado = false;
+        return false;
+    }
+    compilado = true;
+    return true;
+}
+
+void ClosureEngine::imprimirPerfil()
+{
+    if (!compilado)
+    {
+        cout << "Motor de clausuras: no disponible (" << motivo << ")" << endl;
+        return;
+    }
+    cout << "Motor de clausuras: " << program.closures << " clausuras, " << program.functions.size()
+         << " funciones" << endl;
+    cout << "Memoizacion (" << MemoTable::SIZE << " entradas): " << context.memo.hits << " aciertos, "
+         << context.memo.misses << " fallos" << endl;
+}
+
+void ClosureEngine::ejecutar()
+{
+    cout << endl;
+
+    ClosureContext &ctx = context;
+    ctx.cells.assign(1 << 16, SlotCell());
+    ctx.strings.assign(1 << 10, string());
+    ctx.globalCells.assign(program.globalCells, SlotCell());
+    ctx.globalStrings.assign(program.globalStrings, string());
+    ctx.fp = ctx.cells.data();
+    ctx.sfp = ctx.strings.data();
+    ctx.top = ctx.stringTop = 0;
+    ctx.memo.reset();
+
+    for (auto &init : program.globalInits)
+        init(ctx);
+    invoke(ctx, program.functions[program.main], vector<ClosureArgument>(), false);
+
+    salidaPrograma.vaciar();
+    cout << endl;
+}
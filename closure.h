@@ -0,0 +1,161 @@
+#ifndef CLOSURE_H
+#define CLOSURE_H
+
+#include "lowering.h"
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Motor de clausuras: cada nodo del AST se convierte una sola vez en una
+// función de C++ que ya tiene resueltas sus ranuras, el tipo de sus operandos
+// y las clausuras de sus hijos, y ejecutar es llamar a la raíz. No hay
+// despacho por Visitor, ni lastType, ni búsqueda de nombres en el Environment.
+struct ClosureContext;
+typedef std::function<int(ClosureContext &)> IntClosure; // Int y Boolean
+typedef std::function<float(ClosureContext &)> FloatClosure;
+typedef std::function<string(ClosureContext &)> StringClosure;
+typedef std::function<int(ClosureContext &)> StmClosure; // devuelve un ClosureFlow
+
+enum ClosureFlow
+{
+    FLOW_NEXT,
+    FLOW_BREAK,
+    FLOW_CONTINUE,
+    FLOW_RETURN,
+    FLOW_TAIL_CALL
+};
+
+// Expresión compilada: solo la clausura de su tipo está definida
+struct ClosureExp
+{
+    int type = 1;
+    IntClosure i;
+    FloatClosure f;
+    StringClosure s;
+};
+
+// Argumento ya convertido al tipo del parámetro, con su ranura en el marco
+struct ClosureArgument
+{
+    ClosureExp value;
+    int index;
+};
+
+struct ClosureFunction
+{
+    FunctionDecl *decl = nullptr;
+    int index = 0;
+    bool memo = false;
+    StmClosure body;
+    int paramCells = 0, paramStrings = 0;
+    int localCells = 0, localStrings = 0; // incluye parámetros
+};
+
+struct ClosureProgram
+{
+    std::vector<ClosureFunction> functions;
+    std::vector<StmClosure> globalInits;
+    int main = 0;
+    int globalCells = 0, globalStrings = 0;
+    long closures = 0;
+};
+
+// Estado de una ejecución. Los marcos de las funciones se apilan en cells y
+// strings; fp y sfp apuntan al marco actual y se recalculan al crecer.
+struct ClosureContext
+{
+    std::vector<SlotCell> cells;
+    std::vector<string> strings;
+    std::vector<SlotCell> globalCells;
+    std::vector<string> globalStrings;
+    SlotCell *fp = nullptr;
+    string *sfp = nullptr;
+    size_t top = 0, stringTop = 0; // primera ranura libre
+    SlotCell result;
+    string stringResult;
+    MemoTable memo;
+
+    void reserve(size_t cellsNeeded, size_t stringsNeeded);
+};
+
+// Baja el programa a ClosureProgram con la resolución estática compartida con
+// el motor enhebrado. Las expresiones muy profundas también se rechazan,
+// porque las clausuras se llaman recursivamente.
+class ClosureCompiler : public StaticLowering
+{
+    static const int MAX_DEPTH = 10000;
+
+    ClosureProgram &out;
+    std::unordered_map<FunctionDecl *, int> functionIndex;
+    std::vector<ClosureExp> values;
+    StmClosure compiled;
+    int loopDepth = 0;
+    int nesting = 0; // operadores y llamadas abiertos en la expresión actual
+
+    ClosureExp compileExp(Exp *exp);
+    IntClosure compileCondition(Exp *exp);
+    StmClosure compileStm(Stm *stm);
+    StmClosure compileBody(Stm *stm);
+    void compileFunction(FunctionDecl *func);
+    ClosureExp finish(ClosureExp exp);
+    ClosureExp convert(ClosureExp exp, int to);
+    StringClosure toString(ClosureExp exp);
+    FloatClosure toFloat(ClosureExp exp);
+    ClosureExp load(const Slot &slot);
+    StmClosure store(const Slot &slot, const ClosureExp &value);
+    ClosureExp increment(const Slot &slot, int delta, bool post);
+    std::vector<ClosureArgument> compileArguments(FunctionCallExp *call);
+    StmClosure compileUpdate(const string &id, int op, Exp *rhs);
+    StmClosure discard(const ClosureExp &exp);
+    void onLeaf(Exp *exp) override;
+    void onEnter(Exp *exp) override;
+    void onExit(Exp *exp) override;
+
+public:
+    ClosureCompiler(ClosureProgram &program) : out(program) {}
+    void compilar(Program *program);
+    int visit(BinaryExp *exp) override;
+    int visit(NumberExp *exp) override;
+    int visit(DecimalExp *exp) override;
+    int visit(BoolExp *exp) override;
+    int visit(IdentifierExp *exp) override;
+    int visit(RangeExp *exp) override;
+    int visit(StringExp *exp) override;
+    int visit(ParenthesizedExp *exp) override;
+    int visit(FunctionCallExp *exp) override;
+    int visit(UnaryExp *exp) override;
+    int visit(RunExp *exp) override;
+    void visit(AssignStatement *stm) override;
+    void visit(PrintStatement *stm) override;
+    void visit(ExpressionStatement *stm) override;
+    void visit(IfStatement *stm) override;
+    void visit(WhileStatement *stm) override;
+    void visit(DoWhileStatement *stm) override;
+    void visit(ForStatement *stm) override;
+    void visit(VarDec *stm) override;
+    void visit(VarDecList *stm) override;
+    void visit(StatementList *stm) override;
+    void visit(Block *stm) override;
+    void visit(RunBlock *stm) override;
+    void visit(FunctionDecl *stm) override;
+    void visit(ReturnStatement *stm) override;
+    void visit(BreakStatement *stm) override;
+    void visit(ContinueStatement *stm) override;
+};
+
+class ClosureEngine
+{
+    ClosureProgram program;
+    ClosureContext context;
+    string motivo;
+    bool compilado = false;
+
+public:
+    bool compilar(Program *program);
+    const string &motivoFallo() const { return motivo; }
+    void ejecutar();
+    void imprimirPerfil();
+};
+
+#endif
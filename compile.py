@@ -18,7 +18,17 @@ def compile_cpp():
             'parser.cpp',
             'token.cpp',
             'exp.cpp',
-            'visitor.cpp'
+            'visitor.cpp',
+            'optimizer.cpp',
+            'lowering.cpp',
+            'threaded.cpp',
+            'closure.cpp',
+            'assembler.cpp',
+            'elfwriter.cpp',
+            'jit.cpp',
+            'output.cpp',
+            'peephole.cpp',
+            'frame.cpp'
         ]
         
         result = subprocess.run(
@@ -0,0 +1,261 @@
+#include "elfwriter.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+static const int SHT_PROGBITS = 1, SHT_SYMTAB = 2, SHT_STRTAB = 3, SHT_RELA = 4;
+static const int SHF_WRITE = 1, SHF_ALLOC = 2, SHF_EXECINSTR = 4, SHF_INFO_LINK = 0x40;
+static const int STB_LOCAL = 0, STB_GLOBAL = 1;
+static const int STT_NOTYPE = 0, STT_FUNC = 2, STT_SECTION = 3;
+static const int R_X86_64_PC32 = 2, R_X86_64_PLT32 = 4;
+
+// Índices fijos en la tabla de secciones; las .rela van al final
+enum
+{
+    SECTION_NULL,
+    SECTION_TEXT,
+    SECTION_DATA,
+    SECTION_RODATA,
+    SECTION_SYMTAB,
+    SECTION_STRTAB,
+    SECTION_SHSTRTAB,
+    SECTION_NOTE,
+    SECTION_COUNT
+};
+
+static const char *const sectionNames[] = {".text", ".data", ".rodata"};
+
+// Enteros en little-endian, como los espera x86-64
+static void put(string &out, uint64_t value, int size)
+{
+    for (int i = 0; i < size; i++)
+        out += (char)(value >> (8 * i));
+}
+
+static size_t addName(string &table, const string &name)
+{
+    size_t offset = table.size();
+    table += name;
+    table += '\0';
+    return offset;
+}
+
+static void putSymbol(string &out, size_t name, int bind, int type, int section, uint64_t value)
+{
+    put(out, name, 4);
+    put(out, bind << 4 | type, 1);
+    put(out, 0, 1);
+    put(out, section, 2);
+    put(out, value, 8);
+    put(out, 0, 8);
+}
+
+string ElfWriter::build()
+{
+    // Símbolos: nulo, uno por sección, las etiquetas locales y al final las
+    // globales, definidas o externas, como exige el formato
+    string symtab, strtab(1, '\0');
+    putSymbol(symtab, 0, STB_LOCAL, STT_NOTYPE, 0, 0);
+    for (int s = 0; s < 3; s++)
+        putSymbol(symtab, 0, STB_LOCAL, STT_SECTION, SECTION_TEXT + s, 0);
+    size_t count = 4;
+
+    vector<pair<pair<int, size_t>, string>> locals, defined;
+    for (auto &label : labels)
+    {
+        if (label.first.compare(0, 2, ".L") == 0)
+            continue;
+        (globals.count(label.first) ? defined : locals).push_back(make_pair(label.second, label.first));
+    }
+    sort(locals.begin(), locals.end());
+    sort(defined.begin(), defined.end());
+    for (auto &label : locals)
+        putSymbol(symtab, addName(strtab, label.second), STB_LOCAL, STT_NOTYPE, SECTION_TEXT + label.first.first,
+                  label.first.second);
+    count += locals.size();
+    size_t firstGlobal = count;
+
+    unordered_map<string, size_t> globalIndex;
+    for (auto &label : defined)
+    {
+        int type = label.first.first == TEXT ? STT_FUNC : STT_NOTYPE;
+        putSymbol(symtab, addName(strtab, label.second), STB_GLOBAL, type, SECTION_TEXT + label.first.first,
+                  label.first.second);
+        globalIndex[label.second] = count++;
+    }
+
+    for (auto &fixup : fixups)
+    {
+        long long length = fixup.next - fixup.at;
+        auto target = labels.find(fixup.label);
+        if (target == labels.end())
+        {
+            if (!globalIndex.count(fixup.label))
+            {
+                putSymbol(symtab, addName(strtab, fixup.label), STB_GLOBAL, STT_NOTYPE, 0, 0);
+                globalIndex[fixup.label] = count++;
+            }
+            relocations[fixup.section].push_back({fixup.at, globalIndex[fixup.label], R_X86_64_PLT32, -length});
+        }
+        else if (target->second.first == fixup.section)
+        {
+            int32_t relative = (long long)target->second.second - (long long)fixup.next;
+            for (int i = 0; i < 4; i++)
+                sections[fixup.section][fixup.at + i] = (uint8_t)(relative >> (8 * i));
+        }
+        else
+        {
+            relocations[fixup.section].push_back({fixup.at, (size_t)1 + target->second.first, R_X86_64_PC32,
+                                                  (long long)target->second.second - length});
+        }
+    }
+    simbolos = count;
+
+    // Contenido de las secciones, en el orden en que se escriben tras la cabecera
+    string shstrtab(1, '\0');
+    vector<string> contents(SECTION_COUNT);
+    vector<size_t> names(SECTION_COUNT, 0);
+    for (int s = 0; s < 3; s++)
+    {
+        contents[SECTION_TEXT + s].assign(sections[s].begin(), sections[s].end());
+        names[SECTION_TEXT + s] = addName(shstrtab, sectionNames[s]);
+    }
+    contents[SECTION_SYMTAB] = symtab;
+    names[SECTION_SYMTAB] = addName(shstrtab, ".symtab");
+    contents[SECTION_STRTAB] = strtab;
+    names[SECTION_STRTAB] = addName(shstrtab, ".strtab");
+    names[SECTION_NOTE] = addName(shstrtab, ".note.GNU-stack");
+    vector<int> relaTargets;
+    for (int s = 0; s < 3; s++)
+    {
+        if (relocations[s].empty())
+            continue;
+        string rela;
+        for (auto &relocation : relocations[s])
+        {
+            put(rela, relocation.offset, 8);
+            put(rela, (uint64_t)relocation.symbol << 32 | relocation.type, 8);
+            put(rela, relocation.addend, 8);
+        }
+        contents.push_back(rela);
+        names.push_back(addName(shstrtab, string(".rela") + sectionNames[s]));
+        relaTargets.push_back(SECTION_TEXT + s);
+    }
+    names[SECTION_SHSTRTAB] = addName(shstrtab, ".shstrtab");
+    contents[SECTION_SHSTRTAB] = shstrtab;
+
+    string body;
+    vector<size_t> offsets(contents.size(), 0);
+    for (size_t i = 1; i < contents.size(); i++)
+    {
+        while ((64 + body.size()) % 16)
+            body += '\0';
+        offsets[i] = 64 + body.size();
+        body += contents[i];
+    }
+    while ((64 + body.size()) % 8)
+        body += '\0';
+
+    string elf("\x7f" "ELF", 4);
+    put(elf, 2, 1); // 64 bits
+    put(elf, 1, 1); // little-endian
+    put(elf, 1, 1); // versión
+    put(elf, 0, 9); // System V y relleno
+    put(elf, 1, 2); // ET_REL
+    put(elf, 62, 2); // EM_X86_64
+    put(elf, 1, 4);
+    put(elf, 0, 8); // sin punto de entrada
+    put(elf, 0, 8); // sin cabeceras de programa
+    put(elf, 64 + body.size(), 8);
+    put(elf, 0, 4);
+    put(elf, 64, 2);
+    put(elf, 0, 2);
+    put(elf, 0, 2);
+    put(elf, 64, 2);
+    put(elf, contents.size(), 2);
+    put(elf, SECTION_SHSTRTAB, 2);
+    elf += body;
+
+    for (size_t i = 0; i < contents.size(); i++)
+    {
+        uint64_t type = 0, flags = 0, link = 0, info = 0, align = 1, entsize = 0;
+        if (i == SECTION_TEXT || i == SECTION_DATA || i == SECTION_RODATA || i == SECTION_NOTE)
+            type = SHT_PROGBITS;
+        if (i == SECTION_TEXT)
+            flags = SHF_ALLOC | SHF_EXECINSTR;
+        else if (i == SECTION_DATA)
+            flags = SHF_ALLOC | SHF_WRITE;
+        else if (i == SECTION_RODATA)
+            flags = SHF_ALLOC;
+        if (i >= SECTION_TEXT && i <= SECTION_RODATA)
+            align = 16;
+        if (i == SECTION_SYMTAB)
+        {
+            type = SHT_SYMTAB;
+            link = SECTION_STRTAB;
+            info = firstGlobal;
+            align = 8;
+            entsize = 24;
+        }
+        else if (i == SECTION_STRTAB || i == SECTION_SHSTRTAB)
+            type = SHT_STRTAB;
+        else if (i >= SECTION_COUNT)
+        {
+            type = SHT_RELA;
+            flags = SHF_INFO_LINK;
+            link = SECTION_SYMTAB;
+            info = relaTargets[i - SECTION_COUNT];
+            align = 8;
+            entsize = 24;
+        }
+        put(elf, names[i], 4);
+        put(elf, type, 4);
+        put(elf, flags, 8);
+        put(elf, 0, 8);
+        put(elf, i ? offsets[i] : 0, 8);
+        put(elf, contents[i].size(), 8);
+        put(elf, link, 4);
+        put(elf, info, 4);
+        put(elf, i ? align : 0, 8);
+        put(elf, entsize, 8);
+    }
+    return elf;
+}
+
+bool ElfWriter::escribir(const string &codigo, const string &archivo)
+{
+    auto inicio = chrono::steady_clock::now();
+    string elf;
+    try
+    {
+        assemble(codigo);
+        elf = build();
+    }
+    catch (const runtime_error &e)
+    {
+        motivo = e.what();
+        return false;
+    }
+
+    ofstream out(archivo, ios::binary);
+    if (!out.is_open() || !out.write(elf.data(), elf.size()))
+    {
+        motivo = "no se pudo escribir " + archivo;
+        return false;
+    }
+    bytesEscritos = elf.size();
+    milisegundos = chrono::duration<double, milli>(chrono::steady_clock::now() - inicio).count();
+    return true;
+}
+
+void ElfWriter::imprimirPerfil()
+{
+    size_t reubicaciones = relocations[TEXT].size() + relocations[DATA].size() + relocations[RODATA].size();
+    cerr << "Objeto ELF: " << bytesEscritos << " bytes, " << sections[TEXT].size() << " bytes de codigo, "
+         << simbolos << " simbolos, " << reubicaciones << " reubicaciones, escrito en " << milisegundos << " ms"
+         << endl;
+}
@@ -0,0 +1,35 @@
+#ifndef ELFWRITER_H
+#define ELFWRITER_H
+
+#include "assembler.h"
+
+// Escribe un objeto ELF64 reubicable (.text, .data, .rodata, tabla de
+// símbolos y reubicaciones) a partir del texto que produce GenCodeVisitor,
+// listo para enlazar con gcc sin pasar por as. Los saltos dentro de una misma
+// sección se resuelven aquí; las referencias entre secciones llevan
+// R_X86_64_PC32 y las funciones externas R_X86_64_PLT32.
+class ElfWriter : X86Assembler
+{
+    struct Relocation
+    {
+        size_t offset;
+        size_t symbol;
+        int type;
+        long long addend;
+    };
+
+    vector<Relocation> relocations[3];
+    size_t simbolos = 0;
+    size_t bytesEscritos = 0;
+    double milisegundos = 0;
+    string motivo;
+
+    string build();
+
+public:
+    bool escribir(const string &codigo, const string &archivo);
+    const string &motivoFallo() const { return motivo; }
+    void imprimirPerfil();
+};
+
+#endif
@@ -232,6 +232,31 @@ public:
         return "";
     }
 
+    // Celda de la variable visible con ese nombre si es Int (o Float), o
+    // nullptr si tiene otro tipo o no existe. La celda deja de ser válida al
+    // agregar o quitar niveles.
+    int *int_slot(const string &var)
+    {
+        for (int n = type_levels.size() - 1; n >= 0; n--)
+        {
+            auto it = type_levels[n].find(var);
+            if (it != type_levels[n].end())
+                return it->second == "Int" ? &int_levels[n][var] : nullptr;
+        }
+        return nullptr;
+    }
+
+    float *float_slot(const string &var)
+    {
+        for (int n = type_levels.size() - 1; n >= 0; n--)
+        {
+            auto it = type_levels[n].find(var);
+            if (it != type_levels[n].end())
+                return it->second == "Float" ? &float_levels[n][var] : nullptr;
+        }
+        return nullptr;
+    }
+
     bool check(string var)
     {
         int n = type_levels.size() - 1;
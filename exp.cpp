@@ -1,7 +1,42 @@
 #include <iostream>
+#include <vector>
 #include "exp.h"
 using namespace std;
 
+// Libera una expresion desenganchando los operadores en una pila explicita,
+// para que cadenas muy profundas no desborden la pila en los destructores.
+static void releaseExp(Exp *exp)
+{
+    vector<Exp *> pending;
+    pending.push_back(exp);
+    while (!pending.empty())
+    {
+        Exp *current = pending.back();
+        pending.pop_back();
+        if (!current)
+            continue;
+
+        if (BinaryExp *bin = dynamic_cast<BinaryExp *>(current))
+        {
+            pending.push_back(bin->left);
+            pending.push_back(bin->right);
+            bin->left = nullptr;
+            bin->right = nullptr;
+        }
+        else if (ParenthesizedExp *paren = dynamic_cast<ParenthesizedExp *>(current))
+        {
+            pending.push_back(paren->expr);
+            paren->expr = nullptr;
+        }
+        else if (UnaryExp *unary = dynamic_cast<UnaryExp *>(current))
+        {
+            pending.push_back(unary->expr);
+            unary->expr = nullptr;
+        }
+        delete current;
+    }
+}
+
 Exp::~Exp() {}
 BinaryExp::BinaryExp(Exp *l, Exp *r, BinaryOp op) : left(l), right(r), op(op)
 {
@@ -17,8 +52,8 @@ BinaryExp::BinaryExp(Exp *l, Exp *r, BinaryOp op) : left(l), right(r), op(op)
 
 BinaryExp::~BinaryExp()
 {
-    delete left;
-    delete right;
+    releaseExp(left);
+    releaseExp(right);
 }
 
 NumberExp::NumberExp(int v) : value(v) {}
@@ -105,7 +140,7 @@ int ParenthesizedExp::accept(Visitor *visitor)
 {
     return visitor->visit(this);
 }
-ParenthesizedExp::~ParenthesizedExp() { delete expr; }
+ParenthesizedExp::~ParenthesizedExp() { releaseExp(expr); }
 
 FunctionCallExp::FunctionCallExp(const string &name) : name(name) {}
 void FunctionCallExp::addArg(Exp *arg)
@@ -121,16 +156,18 @@ FunctionCallExp::~FunctionCallExp()
 }
 
 UnaryExp::UnaryExp(UnaryOp op, Exp *expr) : op(op), expr(expr) {}
-UnaryExp::~UnaryExp() { delete expr; }
+UnaryExp::~UnaryExp() { releaseExp(expr); }
 
 RunExp::RunExp(Block *block) : block(block) {}
 int RunExp::accept(Visitor *visitor) { return visitor->visit(this); }
 RunExp::~RunExp() { delete block; }
 
-FunctionDecl::FunctionDecl(const string &name, const string &returnType, Block *body) : name(name), returnType(returnType), body(body) {}
+FunctionDecl::FunctionDecl(const string &name, const string &returnType, Block *body)
+    : name(name), returnType(returnType), returnTypeCode(typeCode(returnType)), body(body) {}
 void FunctionDecl::addParam(const string &name, const string &type)
 {
     params.push_back(make_pair(name, type));
+    paramTypes.push_back(typeCode(type));
 }
 FunctionDecl::~FunctionDecl() { delete body; }
 
@@ -192,6 +229,21 @@ Program::~Program()
 }
 
 Stm::~Stm() {}
+
+int typeCode(const string &typeName)
+{
+    if (typeName == "Int")
+        return 1;
+    if (typeName == "Float")
+        return 2;
+    if (typeName == "Boolean")
+        return 3;
+    if (typeName == "String")
+        return 5;
+    if (typeName == "Unit")
+        return 0;
+    return -1;
+}
 string Exp::binopToChar(BinaryOp op)
 {
     string c;
@@ -5,6 +5,7 @@
 #include <unordered_map>
 #include <list>
 #include <string>
+#include <vector>
 #include "visitor.h"
 using namespace std;
 enum BinaryOp
@@ -28,17 +29,27 @@ class Exp
 {
 public:
     bool has_f = false;
+    int walkKind = -1; // clase de nodo para ExpWalker, resuelta en la primera visita
     virtual int accept(Visitor *visitor) = 0;
     virtual ~Exp() = 0;
     static string binopToChar(BinaryOp op);
 };
 
+// Codigo de tipo usado por los visitors: 1 Int, 2 Float, 3 Boolean, 5 String
+// (0 para Unit, -1 si el nombre no es un tipo).
+int typeCode(const string &typeName);
+
 class BinaryExp : public Exp
 {
 public:
     Exp *left, *right;
     string type;
     BinaryOp op;
+    // Especialización del intérprete según los tipos vistos en la primera evaluación.
+    int quickState = 0; // 0 sin observar, 1 especializado, 2 genérico
+    int quickHandler = 0;
+    int quickLeft = 0, quickRight = 0;
+    int superOp = SUPER_NONE;
     BinaryExp(Exp *l, Exp *r, BinaryOp op);
     int accept(Visitor *visitor);
     ~BinaryExp();
@@ -117,6 +128,8 @@ class FunctionCallExp : public Exp
 public:
     string name;
     list<Exp *> args;
+    FunctionDecl *decl = nullptr;
+    vector<int> argTypes; // tipos estáticos de los argumentos (CallResolver)
     FunctionCallExp(const string &name);
     void addArg(Exp *arg);
     int accept(Visitor *visitor);
@@ -138,6 +151,9 @@ public:
     };
     UnaryOp op;
     Exp *expr;
+    int quickState = 0; // igual que en BinaryExp
+    int quickHandler = 0;
+    int quickOperand = 0;
     UnaryExp(UnaryOp op, Exp *expr);
     int accept(Visitor *visitor);
     ~UnaryExp();
@@ -178,6 +194,9 @@ public:
     string id;
     Exp *rhs;
     AssignOp op;
+    int superOp = SUPER_NONE;
+    int superStep = 0;              // incremento de SUPER_INCREMENT_LOCAL
+    Exp *superOperand = nullptr;    // sumando de SUPER_ACCUMULATE_LOCAL (apunta dentro de rhs)
     AssignStatement(string id, Exp *e, AssignOp op = ASSIGN_OP);
     int accept(Visitor *visitor);
     ~AssignStatement();
@@ -226,6 +245,10 @@ public:
     string name;
     string returnType;
     list<pair<string, string>> params;
+    vector<int> paramTypes;
+    int returnTypeCode;
+    bool isTailrec = false;
+    bool isPure = false; // solo lee sus parámetros y locales, sin efectos (PurityAnalyzer)
     Block *body;
     FunctionDecl(const string &name, const string &returnType, Block *body);
     void addParam(const string &name, const string &type);
@@ -335,6 +358,7 @@ public:
     std::string id;
     Exp *range;
     Stm *stmt;
+    AssignStatement *superBody = nullptr; // única sentencia del cuerpo (SUPER_FOR_ASSIGN)
     ForStatement(std::string id, Exp *range, Stm *stmt);
     int accept(Visitor *visitor) override;
     ~ForStatement();
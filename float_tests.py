@@ -0,0 +1,277 @@
+#!/usr/bin/env python3
+import subprocess
+import os
+import re
+import sys
+import shutil
+import tempfile
+
+# Compara formatFloatTo (intérprete) y salida_flotante (runtime del código
+# generado) con una referencia independiente: los dígitos más cortos de
+# std::to_chars, la regla de los dos dígitos de Float.toString comprobada con
+# strtof y el formato armado con strings.
+#   python3 float_tests.py [compilador]               muestra (unos segundos)
+#   python3 float_tests.py --exhaustivo [compilador]  los 2^32 patrones de bits
+#   python3 float_tests.py --bench [compilador]       microbenchmark
+
+PROGRAMA = "fun main(): Unit {\n    println(1.5f)\n}\n"
+
+HARNESS = r'''
+#include "output.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <charconv>
+using namespace std;
+
+extern "C" void salida_flotante(float value);
+extern "C" char *salida_buffer;
+extern "C" long salida_pos;
+
+static string reference(float x)
+{
+    if (x != x)
+        return "NaN";
+    string sign = signbit(x) ? "-" : "";
+    float a = fabsf(x);
+    if (a == INFINITY)
+        return sign + "Infinity";
+    if (a == 0)
+        return sign + "0.0";
+    char buf[64];
+    string s(buf, to_chars(buf, buf + 64, a, chars_format::scientific).ptr);
+    size_t e = s.find('e');
+    string digits = s.substr(0, 1) + (e > 1 ? s.substr(2, e - 2) : "");
+    int exp10 = atoi(s.c_str() + e + 1);
+    if (digits.size() == 1)
+    {
+        // El decimal de dos dígitos más cercano, o su vecino si no vuelve a x
+        char exact[200];
+        snprintf(exact, sizeof exact, "%.120e", (double)a);
+        int te = atoi(strchr(exact, 'e') + 1);
+        int lo = (exact[0] - '0') * 10 + (exact[2] - '0'), loe = te, hi = lo + 1, hie = te;
+        if (hi == 100)
+        {
+            hi = 10;
+            hie++;
+        }
+        bool exactTwo = true;
+        for (char *p = exact + 3; *p != 'e'; p++)
+            exactTwo = exactTwo && *p == '0';
+        auto value = [](int d, int ex) {
+            char b[64];
+            snprintf(b, 64, "%d.%de%d", d / 10, d % 10, ex);
+            return strtof(b, nullptr);
+        };
+        int c = lo, ce = loe;
+        if (!exactTwo)
+        {
+            char b[64];
+            snprintf(b, 64, "%.1e", (double)a);
+            c = (b[0] - '0') * 10 + (b[2] - '0');
+            ce = atoi(strchr(b, 'e') + 1);
+        }
+        if (value(c, ce) != a)
+        {
+            bool low = c == lo && ce == loe;
+            c = low ? hi : lo;
+            ce = low ? hie : loe;
+        }
+        digits = to_string(c);
+        exp10 = ce;
+        while (digits.size() > 1 && digits.back() == '0')
+            digits.pop_back();
+    }
+    int point = exp10 + 1, n = digits.size();
+    string r;
+    if (point > -3 && point <= 7)
+    {
+        if (point <= 0)
+            r = "0." + string(-point, '0') + digits;
+        else if (point >= n)
+            r = digits + string(point - n, '0') + ".0";
+        else
+            r = digits.substr(0, point) + "." + digits.substr(point);
+    }
+    else
+        r = digits.substr(0, 1) + "." + (n > 1 ? digits.substr(1) : "0") + "E" + to_string(point - 1);
+    return sign + r;
+}
+
+static float fromBits(uint32_t bits)
+{
+    float x;
+    memcpy(&x, &bits, 4);
+    return x;
+}
+
+static string compiled(float x)
+{
+    salida_pos = 0;
+    salida_flotante(x);
+    return string(salida_buffer, salida_pos - 1);
+}
+
+static unsigned long long fallos = 0;
+
+static void check(uint32_t bits)
+{
+    float x = fromBits(bits);
+    char text[32];
+    string want = reference(x);
+    string got(text, formatFloatTo(text, x));
+    string gen = compiled(x);
+    if ((got != want || gen != want) && fallos++ < 20)
+        printf("%08x: referencia %s, interprete %s, compilado %s\n", bits, want.c_str(), got.c_str(), gen.c_str());
+}
+
+template <class F> static double nanos(const vector<uint32_t> &values, F f)
+{
+    auto start = chrono::steady_clock::now();
+    for (uint32_t bits : values)
+        f(fromBits(bits));
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / values.size();
+}
+
+int main(int argc, char **argv)
+{
+    string mode = argv[1];
+    if (mode == "bench")
+    {
+        // Float finitos al azar y valores "redondos" como los de los programas
+        mt19937 random(7);
+        vector<uint32_t> values;
+        for (int i = 0; i < 2000000; i++)
+        {
+            uint32_t bits = random();
+            if ((bits >> 23 & 0xff) != 0xff)
+                values.push_back(bits);
+        }
+        for (int i = 0; i < 2000000; i++)
+        {
+            float x = (float)(random() % 100000) / 100;
+            uint32_t bits;
+            memcpy(&bits, &x, 4);
+            values.push_back(bits);
+        }
+        static char sink[64];
+        double actual = nanos(values, [](float x) { formatFloatTo(sink, x); });
+        double generado = nanos(values, [](float x) {
+            salida_pos = 0;
+            salida_flotante(x);
+        });
+        double anterior = nanos(values, [](float x) {
+            string s = x == floor(x) ? to_string((int)x) : to_string(x);
+            sink[0] = s[0];
+        });
+        double printf6g = nanos(values, [](float x) { snprintf(sink, 64, "%.6g", (double)x); });
+        printf("formatFloatTo: %.1f ns por valor\n", actual);
+        printf("salida_flotante: %.1f ns por valor\n", generado);
+        printf("to_string (formato anterior del interprete): %.1f ns por valor\n", anterior);
+        printf("printf %%.6g (formato anterior del codigo generado): %.1f ns por valor\n", printf6g);
+        return 0;
+    }
+
+    if (mode == "exhaustivo")
+    {
+        for (uint64_t bits = 0; bits <= 0xffffffffull; bits++)
+        {
+            check((uint32_t)bits);
+            if ((bits & 0xfffffff) == 0xfffffff)
+            {
+                printf("  %llu/16 completado\n", (unsigned long long)(bits >> 28) + 1);
+                fflush(stdout);
+            }
+        }
+    }
+    else
+    {
+        // Subnormales, alrededor de cada potencia de 2 y de 10, y al azar
+        for (uint32_t bits = 0; bits < 0x800000; bits += 7)
+            check(bits);
+        for (uint32_t exponent = 0; exponent < 256; exponent++)
+            for (uint32_t m = 0; m < 64; m++)
+            {
+                check(exponent << 23 | m);
+                check(exponent << 23 | (0x7fffff - m));
+                check(0x80000000u | exponent << 23 | m);
+            }
+        for (int p = -45; p <= 38; p++)
+        {
+            float x = strtof(("1e" + to_string(p)).c_str(), nullptr);
+            uint32_t bits;
+            memcpy(&bits, &x, 4);
+            for (int d = -64; d <= 64; d++)
+                check(bits + d);
+        }
+        mt19937 random(45);
+        for (int i = 0; i < 4000000; i++)
+            check(random());
+    }
+    printf("%llu valores distintos de la referencia\n", fallos);
+    return fallos != 0;
+}
+'''
+
+
+def main():
+    args = sys.argv[1:]
+    mode = "muestra"
+    if args and args[0] in ("--exhaustivo", "--bench"):
+        mode = args.pop(0)[2:]
+    compiler = args[0] if args else ("main.exe" if os.name == 'nt' else "./main")
+    compiler = os.path.abspath(compiler)
+    repo = os.path.dirname(os.path.abspath(__file__))
+
+    print("🔢 FORMATO DE FLOAT - INTERPRETE Y CODIGO GENERADO")
+    print("=" * 60)
+    tmp_dir = tempfile.mkdtemp(prefix="float_")
+    try:
+        fuente = os.path.join(tmp_dir, "programa.txt")
+        with open(fuente, "w") as f:
+            f.write(PROGRAMA)
+        subprocess.run([compiler, fuente], capture_output=True, text=True, timeout=60)
+        with open(os.path.join(tmp_dir, "programa.s")) as f:
+            codigo = f.read()
+
+        # El runtime de salida se enlaza con el harness: main deja de ser main
+        # y las funciones que se prueban se exportan
+        codigo = re.sub(r"\bmain\b", "programa_main", codigo)
+        codigo += "\n.globl salida_flotante\n.globl salida_buffer\n.globl salida_pos\n"
+        runtime = os.path.join(tmp_dir, "runtime.s")
+        with open(runtime, "w") as f:
+            f.write(codigo)
+        harness = os.path.join(tmp_dir, "harness.cpp")
+        with open(harness, "w") as f:
+            f.write(HARNESS)
+
+        ejecutable = os.path.join(tmp_dir, "harness")
+        build = subprocess.run(["g++", "-O2", "-std=c++17", "-I", repo, "-o", ejecutable, harness,
+                                os.path.join(repo, "output.cpp"), runtime], capture_output=True, text=True)
+        if build.returncode != 0:
+            print(f"❌ Error compilando el harness: {build.stderr.strip()[:400]}")
+            sys.exit(1)
+
+        if mode == "exhaustivo":
+            print("📁 Los 2^32 patrones de bits (varios minutos)")
+        elif mode == "muestra":
+            print("📁 Muestra: subnormales, potencias de 2 y de 10, valores al azar")
+        result = subprocess.run([ejecutable, mode])
+    finally:
+        shutil.rmtree(tmp_dir, ignore_errors=True)
+
+    print("=" * 60)
+    if result.returncode == 0:
+        print("🎉 ¡Formato de Float correcto!" if mode != "bench" else "🏁 Microbenchmark completado")
+    else:
+        print("⚠️  Hay valores con formato distinto")
+    sys.exit(result.returncode)
+
+
+if __name__ == "__main__":
+    main()
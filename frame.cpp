@@ -0,0 +1,362 @@
+#include "frame.h"
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+
+using namespace std;
+
+void FrameLayout::calcular(FunctionDecl *func)
+{
+    intervals.clear();
+    declarations.clear();
+    scopes.assign(1, unordered_map<string, int>());
+    loops.clear();
+    point = 0;
+
+    int index = 0;
+    for (auto &param : func->params)
+    {
+        int type = index < (int)func->paramTypes.size() ? func->paramTypes[index] : 1;
+        declare(param.first, type == 2 ? 4 : 8, func, index);
+        index++;
+    }
+    if (func->body)
+        func->body->accept(this);
+
+    assignOffsets();
+}
+
+int FrameLayout::ranura(const void *nodo, int indice) const
+{
+    auto found = declarations.find({nodo, indice});
+    if (found == declarations.end())
+        throw runtime_error("Declaración sin ranura en el marco");
+    return intervals[found->second].offset;
+}
+
+int FrameLayout::reservaSinReutilizar() const
+{
+    int total = 0;
+    for (auto &interval : intervals)
+        total += interval.size;
+    return (total + 15) / 16 * 16;
+}
+
+int FrameLayout::declare(const string &name, int size, const void *node, int index)
+{
+    int id = intervals.size();
+    intervals.push_back({point, point, size, 0});
+    point++;
+    declarations[{node, index}] = id;
+    if (!name.empty())
+        scopes.back()[name] = id;
+    return id;
+}
+
+// Solo hace falta recordar en el bucle los usos de lo declarado antes de él
+void FrameLayout::use(int id)
+{
+    intervals[id].end = point++;
+    if (!loops.empty() && intervals[id].start < loops.back().start)
+        loops.back().used.push_back(id);
+}
+
+void FrameLayout::use(const string &name)
+{
+    for (auto it = scopes.rbegin(); it != scopes.rend(); ++it)
+    {
+        auto found = it->find(name);
+        if (found != it->end())
+        {
+            use(found->second);
+            return;
+        }
+    }
+}
+
+void FrameLayout::scan(Exp *exp)
+{
+    if (exp)
+        walk(exp);
+}
+
+void FrameLayout::beginLoop()
+{
+    loops.push_back({point++, {}});
+}
+
+// Lo que se usa en el bucle y vive desde antes tiene que sobrevivir a la
+// vuelta atrás, así que su intervalo llega hasta el final del bucle
+void FrameLayout::endLoop()
+{
+    Loop loop = move(loops.back());
+    loops.pop_back();
+    for (int id : loop.used)
+    {
+        intervals[id].end = max(intervals[id].end, point);
+        if (!loops.empty() && intervals[id].start < loops.back().start)
+            loops.back().used.push_back(id);
+    }
+    point++;
+}
+
+// Barrido lineal por orden de inicio. Las ranuras de 8 bytes libres se
+// reutilizan y un Float toma media; dos mitades libres vuelven a ser una
+// ranura entera.
+void FrameLayout::assignOffsets()
+{
+    priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> active;
+    set<int> whole, halves;
+    int top = 0;
+
+    auto release = [&](int id) {
+        int offset = intervals[id].offset;
+        if (intervals[id].size == 8)
+        {
+            whole.insert(offset);
+            return;
+        }
+        int partner = offset % 8 == 0 ? offset + 4 : offset - 4;
+        if (halves.erase(partner))
+            whole.insert(min(offset, partner));
+        else
+            halves.insert(offset);
+    };
+
+    for (int id = 0; id < (int)intervals.size(); id++)
+    {
+        Interval &interval = intervals[id];
+        while (!active.empty() && active.top().first < interval.start)
+        {
+            release(active.top().second);
+            active.pop();
+        }
+
+        if (interval.size == 4 && !halves.empty())
+        {
+            interval.offset = *halves.rbegin();
+            halves.erase(interval.offset);
+        }
+        else
+        {
+            int slot;
+            if (!whole.empty())
+            {
+                slot = *whole.rbegin();
+                whole.erase(slot);
+            }
+            else
+            {
+                top += 8;
+                slot = -top;
+            }
+            interval.offset = slot;
+            if (interval.size == 4)
+            {
+                interval.offset = slot + 4;
+                halves.insert(slot);
+            }
+        }
+        active.push({interval.end, id});
+    }
+
+    bytes = (top + 15) / 16 * 16;
+}
+
+void FrameLayout::onLeaf(Exp *exp)
+{
+    exp->accept(this);
+}
+
+int FrameLayout::visit(BinaryExp *exp)
+{
+    walk(exp);
+    return 0;
+}
+
+int FrameLayout::visit(NumberExp *exp) { return 0; }
+int FrameLayout::visit(DecimalExp *exp) { return 0; }
+int FrameLayout::visit(BoolExp *exp) { return 0; }
+int FrameLayout::visit(StringExp *exp) { return 0; }
+
+int FrameLayout::visit(IdentifierExp *exp)
+{
+    use(exp->name);
+    return 0;
+}
+
+int FrameLayout::visit(RangeExp *exp)
+{
+    scan(exp->start);
+    scan(exp->end);
+    scan(exp->step);
+    return 0;
+}
+
+int FrameLayout::visit(ParenthesizedExp *exp)
+{
+    walk(exp);
+    return 0;
+}
+
+int FrameLayout::visit(FunctionCallExp *exp)
+{
+    for (auto arg : exp->args)
+    {
+        scan(arg);
+    }
+    return 0;
+}
+
+int FrameLayout::visit(UnaryExp *exp)
+{
+    if (isOperatorNode(exp))
+        walk(exp);
+    else
+        scan(exp->expr);
+    return 0;
+}
+
+int FrameLayout::visit(RunExp *exp)
+{
+    if (exp->block)
+        exp->block->accept(this);
+    return 0;
+}
+
+// Las asignaciones compuestas leen la variable antes del lado derecho
+void FrameLayout::visit(AssignStatement *stm)
+{
+    if (stm->op != AssignStatement::ASSIGN_OP)
+        use(stm->id);
+    scan(stm->rhs);
+    use(stm->id);
+}
+
+void FrameLayout::visit(PrintStatement *stm)
+{
+    scan(stm->e);
+}
+
+void FrameLayout::visit(ExpressionStatement *stm)
+{
+    scan(stm->expr);
+}
+
+void FrameLayout::visit(IfStatement *stm)
+{
+    scan(stm->condition);
+    if (stm->thenStmt)
+        stm->thenStmt->accept(this);
+    if (stm->elseStmt)
+        stm->elseStmt->accept(this);
+}
+
+void FrameLayout::visit(WhileStatement *stm)
+{
+    beginLoop();
+    scan(stm->condition);
+    if (stm->stmt)
+        stm->stmt->accept(this);
+    endLoop();
+}
+
+void FrameLayout::visit(DoWhileStatement *stm)
+{
+    beginLoop();
+    if (stm->stmt)
+        stm->stmt->accept(this);
+    scan(stm->condition);
+    endLoop();
+}
+
+// Mismo orden que GenCodeVisitor: inicio, fin y paso se guardan apenas se
+// evalúan; la variable reutiliza la de afuera si ya hay una con ese nombre
+void FrameLayout::visit(ForStatement *stm)
+{
+    RangeExp *range = dynamic_cast<RangeExp *>(stm->range);
+    if (!range)
+        return;
+
+    scan(range->start);
+    int start = declare("", 8, stm, 0);
+    scan(range->end);
+    int end = declare("", 8, stm, 1);
+    int step = -1;
+    if (range->step)
+    {
+        scan(range->step);
+        step = declare("", 8, stm, 2);
+    }
+
+    use(start);
+    scopes.push_back(unordered_map<string, int>());
+    bool visible = false;
+    for (auto &scope : scopes)
+        visible = visible || scope.count(stm->id);
+    if (visible)
+        use(stm->id);
+    else
+        declare(stm->id, 8, stm, 3);
+
+    beginLoop();
+    use(stm->id);
+    use(end);
+    if (stm->stmt)
+        stm->stmt->accept(this);
+    use(stm->id);
+    if (step >= 0)
+        use(step);
+    endLoop();
+    scopes.pop_back();
+}
+
+void FrameLayout::visit(VarDec *stm)
+{
+    scan(stm->value);
+    declare(stm->id, stm->type == "Float" ? 4 : 8, stm, 0);
+}
+
+void FrameLayout::visit(VarDecList *stm)
+{
+    for (auto dec : stm->decls)
+    {
+        dec->accept(this);
+    }
+}
+
+void FrameLayout::visit(StatementList *stm)
+{
+    for (auto s : stm->stms)
+    {
+        if (s)
+            s->accept(this);
+    }
+}
+
+void FrameLayout::visit(Block *stm)
+{
+    scopes.push_back(unordered_map<string, int>());
+    if (stm->statements)
+        stm->statements->accept(this);
+    scopes.pop_back();
+}
+
+void FrameLayout::visit(RunBlock *stm)
+{
+    scopes.push_back(unordered_map<string, int>());
+    if (stm->statements)
+        stm->statements->accept(this);
+    scopes.pop_back();
+}
+
+void FrameLayout::visit(FunctionDecl *stm) {}
+
+void FrameLayout::visit(ReturnStatement *stm)
+{
+    scan(stm->expr);
+}
+
+void FrameLayout::visit(BreakStatement *stm) {}
+void FrameLayout::visit(ContinueStatement *stm) {}
@@ -0,0 +1,89 @@
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <vector>
+#include "exp.h"
+#include "visitor.h"
+
+// Marco de una función para GenCodeVisitor. Recorre el cuerpo en el mismo
+// orden en que se genera el código y calcula el intervalo de vida de cada
+// parámetro, local y temporal de for (inicio, fin y paso): desde que se
+// declara hasta su último uso, estirado hasta el final del bucle si se usa
+// dentro de un bucle que empezó después. Los intervalos que no se solapan
+// comparten ranura (Float ocupa media ranura de 8 bytes) y la reserva es el
+// tamaño exacto redondeado a 16 bytes, como pide la ABI.
+class FrameLayout : public Visitor, private ExpWalker
+{
+    struct Interval
+    {
+        int start;
+        int end;
+        int size;
+        int offset;
+    };
+    struct Loop
+    {
+        int start;
+        std::vector<int> used;
+    };
+
+    std::vector<Interval> intervals;
+    std::map<std::pair<const void *, int>, int> declarations;
+    std::vector<std::unordered_map<string, int>> scopes;
+    std::vector<Loop> loops;
+    int point = 0;
+    int bytes = 0;
+
+    int declare(const string &name, int size, const void *node, int index);
+    void use(int id);
+    void use(const string &name);
+    void scan(Exp *exp);
+    void beginLoop();
+    void endLoop();
+    void assignOffsets();
+    void onLeaf(Exp *exp) override;
+    void onExit(Exp *exp) override {}
+
+public:
+    void calcular(FunctionDecl *func);
+    // Desplazamiento respecto de %rbp. Índices: el del parámetro en la
+    // FunctionDecl; 0 en VarDec; 0 inicio, 1 fin, 2 paso y 3 variable en for
+    int ranura(const void *nodo, int indice = 0) const;
+    bool tieneRanura(const void *nodo, int indice) const { return declarations.count({nodo, indice}) != 0; }
+    int reserva() const { return bytes; }
+    // Lo que ocuparía el marco con una ranura distinta para cada declaración
+    int reservaSinReutilizar() const;
+
+    int visit(BinaryExp *exp) override;
+    int visit(NumberExp *exp) override;
+    int visit(DecimalExp *exp) override;
+    int visit(BoolExp *exp) override;
+    int visit(IdentifierExp *exp) override;
+    int visit(RangeExp *exp) override;
+    int visit(StringExp *exp) override;
+    int visit(ParenthesizedExp *exp) override;
+    int visit(FunctionCallExp *exp) override;
+    int visit(UnaryExp *exp) override;
+    int visit(RunExp *exp) override;
+    void visit(AssignStatement *stm) override;
+    void visit(PrintStatement *stm) override;
+    void visit(ExpressionStatement *stm) override;
+    void visit(IfStatement *stm) override;
+    void visit(WhileStatement *stm) override;
+    void visit(DoWhileStatement *stm) override;
+    void visit(ForStatement *stm) override;
+    void visit(VarDec *stm) override;
+    void visit(VarDecList *stm) override;
+    void visit(StatementList *stm) override;
+    void visit(Block *stm) override;
+    void visit(RunBlock *stm) override;
+    void visit(FunctionDecl *stm) override;
+    void visit(ReturnStatement *stm) override;
+    void visit(BreakStatement *stm) override;
+    void visit(ContinueStatement *stm) override;
+};
+
+#endif
@@ -0,0 +1,118 @@
+#include "jit.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#ifdef JIT_DISPONIBLE
+#include <dlfcn.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+JitCompiler::~JitCompiler()
+{
+#ifdef JIT_DISPONIBLE
+    if (memoria)
+        munmap(memoria, tamano);
+#endif
+}
+
+// Las funciones externas se llaman a través de un salto indirecto en el mismo
+// bloque, porque la libc puede quedar a más de 2 GB del código
+void JitCompiler::link()
+{
+#ifdef JIT_DISPONIBLE
+    current = TEXT;
+    for (size_t i = 0; i < fixups.size(); i++)
+    {
+        string name = fixups[i].label;
+        if (labels.count(name))
+            continue;
+        void *address = dlsym(RTLD_DEFAULT, name.c_str());
+        if (!address)
+            fail("simbolo sin definir: " + name);
+        define(name);
+        byte(0xFF);
+        byte(0x25);
+        imm32(0);
+        bytes(&address, 8);
+        externas++;
+    }
+
+    size_t page = sysconf(_SC_PAGESIZE);
+    auto align = [page](size_t size) { return (size + page - 1) / page * page; };
+    size_t offsets[3];
+    offsets[TEXT] = 0;
+    offsets[DATA] = align(sections[TEXT].size());
+    offsets[RODATA] = offsets[DATA] + align(sections[DATA].size());
+    tamano = offsets[RODATA] + align(sections[RODATA].size());
+
+    void *block = mmap(nullptr, tamano, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (block == MAP_FAILED)
+    {
+        tamano = 0;
+        fail("mmap fallo");
+    }
+    memoria = static_cast<uint8_t *>(block);
+    for (int s = 0; s < 3; s++)
+    {
+        if (!sections[s].empty())
+            memcpy(memoria + offsets[s], sections[s].data(), sections[s].size());
+    }
+
+    for (auto &fixup : fixups)
+    {
+        auto target = labels.at(fixup.label);
+        long long address = offsets[target.first] + target.second;
+        long long next = offsets[fixup.section] + fixup.next;
+        int32_t relative = address - next;
+        memcpy(memoria + offsets[fixup.section] + fixup.at, &relative, 4);
+    }
+
+    auto mainLabel = labels.find("main");
+    if (mainLabel == labels.end() || mainLabel->second.first != TEXT)
+        fail("no hay funcion main");
+    if (mprotect(memoria, offsets[DATA], PROT_READ | PROT_EXEC) != 0 ||
+        (tamano > offsets[RODATA] && mprotect(memoria + offsets[RODATA], tamano - offsets[RODATA], PROT_READ) != 0))
+        fail("mprotect fallo");
+    entrada = reinterpret_cast<int (*)()>(memoria + mainLabel->second.second);
+#else
+    fail("JIT no disponible en esta plataforma");
+#endif
+}
+
+bool JitCompiler::ensamblar(const string &codigo)
+{
+    auto inicio = chrono::steady_clock::now();
+    try
+    {
+        assemble(codigo);
+        link();
+    }
+    catch (const runtime_error &e)
+    {
+        motivo = e.what();
+        return false;
+    }
+    milisegundos = chrono::duration<double, milli>(chrono::steady_clock::now() - inicio).count();
+    return true;
+}
+
+// Devuelve el código de salida de main, como el ejecutable de gcc
+int JitCompiler::ejecutar()
+{
+    int codigo = entrada();
+    fflush(stdout);
+    return codigo;
+}
+
+void JitCompiler::imprimirPerfil()
+{
+    cerr << "JIT: " << sections[TEXT].size() << " bytes de codigo, "
+         << sections[DATA].size() + sections[RODATA].size() << " bytes de datos, " << externas
+         << " funciones externas, ensamblado en " << milisegundos << " ms" << endl;
+}
@@ -0,0 +1,33 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include "assembler.h"
+
+// Compilación en memoria para --run: ensambla con X86Assembler el texto que
+// produce GenCodeVisitor en un buffer de mmap, resuelve printf, strcpy,
+// strcat y sprintf con dlsym y llama a main en el mismo proceso, sin gcc ni
+// a.out. Si algo falla, ensamblar devuelve false y motivoFallo dice por qué.
+#if defined(__x86_64__) && defined(__unix__)
+#define JIT_DISPONIBLE 1
+#endif
+
+class JitCompiler : X86Assembler
+{
+    uint8_t *memoria = nullptr;
+    size_t tamano = 0;
+    int (*entrada)() = nullptr;
+    size_t externas = 0;
+    double milisegundos = 0;
+    string motivo;
+
+    void link();
+
+public:
+    ~JitCompiler();
+    bool ensamblar(const string &codigo);
+    const string &motivoFallo() const { return motivo; }
+    int ejecutar();
+    void imprimirPerfil();
+};
+
+#endif
@@ -0,0 +1,318 @@
+#include "lowering.h"
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+using namespace std;
+
+void StaticLowering::fail(const string &motivo)
+{
+    throw runtime_error(motivo);
+}
+
+void StaticLowering::declareName(const string &name, int type, bool inFunction)
+{
+    if (type <= 0 || type == 4)
+        fail("la variable '" + name + "' tiene un tipo no soportado");
+    if (type == 1)
+        intNames.insert(name);
+    if (inFunction)
+        localNames.insert(name);
+}
+
+void StaticLowering::collect(Stm *stm, bool inFunction)
+{
+    if (!stm)
+        return;
+    if (VarDec *dec = dynamic_cast<VarDec *>(stm))
+        declareName(dec->id, typeCode(dec->type), inFunction);
+    else if (VarDecList *list = dynamic_cast<VarDecList *>(stm))
+    {
+        for (auto dec : list->decls)
+            collect(dec, inFunction);
+    }
+    else if (Block *block = dynamic_cast<Block *>(stm))
+    {
+        for (auto s : block->statements->stms)
+            collect(s, inFunction);
+    }
+    else if (IfStatement *ifStm = dynamic_cast<IfStatement *>(stm))
+    {
+        collect(ifStm->thenStmt, inFunction);
+        collect(ifStm->elseStmt, inFunction);
+    }
+    else if (WhileStatement *whileStm = dynamic_cast<WhileStatement *>(stm))
+        collect(whileStm->stmt, inFunction);
+    else if (DoWhileStatement *doStm = dynamic_cast<DoWhileStatement *>(stm))
+        collect(doStm->stmt, inFunction);
+    else if (ForStatement *forStm = dynamic_cast<ForStatement *>(stm))
+    {
+        declareName(forStm->id, 1, inFunction);
+        collect(forStm->stmt, inFunction);
+    }
+    else if (FunctionDecl *func = dynamic_cast<FunctionDecl *>(stm))
+    {
+        auto type_it = func->paramTypes.begin();
+        for (auto &param : func->params)
+            declareName(param.first, *type_it++, true);
+        collect(func->body, true);
+    }
+}
+
+FunctionDecl *StaticLowering::prepare(Program *program, vector<FunctionDecl *> &functions,
+                                      vector<VarDec *> &globalDecs)
+{
+    unordered_map<string, FunctionDecl *> byName;
+    for (auto stmt : program->statements->stms)
+    {
+        if (FunctionDecl *func = dynamic_cast<FunctionDecl *>(stmt))
+            byName[func->name] = func;
+        else if (VarDec *dec = dynamic_cast<VarDec *>(stmt))
+            globalDecs.push_back(dec);
+    }
+    auto mainFunc = byName.find("main");
+    if (mainFunc == byName.end())
+        fail("no hay funcion main");
+    if (!mainFunc->second->params.empty())
+        fail("main con parametros");
+
+    for (auto dec : globalDecs)
+        collect(dec, false);
+    for (auto stmt : program->statements->stms)
+    {
+        FunctionDecl *func = dynamic_cast<FunctionDecl *>(stmt);
+        if (func && byName[func->name] == func)
+        {
+            collect(func, true);
+            functions.push_back(func);
+        }
+    }
+    return mainFunc->second;
+}
+
+// Abre el marco de la función con sus parámetros en las primeras ranuras
+void StaticLowering::beginFunction(FunctionDecl *func)
+{
+    function = func;
+    localCells = localStrings = 0;
+    if (func->returnTypeCode < 0 || func->returnTypeCode == 4)
+        fail("'" + func->name + "' devuelve un tipo no soportado");
+
+    scopes.assign(1, unordered_map<string, Slot>());
+    auto type_it = func->paramTypes.begin();
+    for (auto &param : func->params)
+        declare(param.first, *type_it++);
+    scopes.push_back(unordered_map<string, Slot>());
+}
+
+void StaticLowering::endFunction(FunctionDecl *func)
+{
+    scopes.clear();
+    if (func->returnTypeCode != 0 && !alwaysReturns(func->body))
+        fail("'" + func->name + "' puede terminar sin return");
+}
+
+bool StaticLowering::alwaysReturns(Stm *stm)
+{
+    if (dynamic_cast<ReturnStatement *>(stm))
+        return true;
+    if (Block *block = dynamic_cast<Block *>(stm))
+    {
+        for (auto s : block->statements->stms)
+        {
+            if (alwaysReturns(s))
+                return true;
+        }
+        return false;
+    }
+    if (IfStatement *ifStm = dynamic_cast<IfStatement *>(stm))
+        return ifStm->elseStmt && alwaysReturns(ifStm->thenStmt) && alwaysReturns(ifStm->elseStmt);
+    return false;
+}
+
+StaticLowering::Slot StaticLowering::lookup(const string &name)
+{
+    for (auto it = scopes.rbegin(); it != scopes.rend(); ++it)
+    {
+        auto found = it->find(name);
+        if (found != it->end())
+            return found->second;
+    }
+    auto global = globals.find(name);
+    if (global == globals.end())
+        fail("'" + name + "' no se puede resolver estaticamente");
+    // Un local del mismo nombre en otra función podría taparla al llamar
+    if (function && localNames.count(name))
+        fail("la global '" + name + "' depende del alcance dinamico");
+    return global->second;
+}
+
+StaticLowering::Slot StaticLowering::declare(const string &name, int type)
+{
+    auto &scope = scopes.empty() ? globals : scopes.back();
+    auto it = scope.find(name);
+    if (it != scope.end())
+    {
+        if (it->second.type != type)
+            fail("'" + name + "' se redeclara con otro tipo en el mismo bloque");
+        return it->second;
+    }
+
+    Slot slot;
+    slot.type = type;
+    slot.global = scopes.empty();
+    if (slot.global)
+        slot.index = type == 5 ? globalStrings++ : globalCells++;
+    else
+        slot.index = type == 5 ? localStrings++ : localCells++;
+    scope[name] = slot;
+    return slot;
+}
+
+static bool isNumeric(int type)
+{
+    return type == 1 || type == 2;
+}
+
+static bool isCondition(int type)
+{
+    return type == 1 || type == 3;
+}
+
+int StaticLowering::binaryType(int op, int left, int right)
+{
+    switch (op)
+    {
+    case AND_OP:
+    case OR_OP:
+        if (!isCondition(left) || !isCondition(right))
+            fail("operando logico que no es Int ni Boolean");
+        return 3;
+    case PLUS_OP:
+    case MINUS_OP:
+    case MUL_OP:
+    case DIV_OP:
+    case MOD_OP:
+        if (op == PLUS_OP && (left == 5 || right == 5))
+        {
+            int other = left == 5 ? right : left;
+            if (other != 5 && !isNumeric(other) && other != 3)
+                fail("concatenacion con un operando no soportado");
+            return 5;
+        }
+        if (!isNumeric(left) || !isNumeric(right))
+            fail("operacion aritmetica con operandos no soportados");
+        return left == 1 && right == 1 ? 1 : 2;
+    default:
+        if (left == 5 || right == 5)
+        {
+            if (left != 5 || right != 5 || (op != EQ_OP && op != NE_OP))
+                fail("comparacion con String no soportada");
+        }
+        else if (left == 2 || right == 2)
+        {
+            if (!isNumeric(left) || !isNumeric(right))
+                fail("comparacion con operandos no soportados");
+        }
+        else if (!isCondition(left) || !isCondition(right))
+        {
+            fail("comparacion con operandos no soportados");
+        }
+        return 3;
+    }
+}
+
+int StaticLowering::unaryType(int op, int type)
+{
+    if (op == UnaryExp::NOT_OP)
+    {
+        if (!isCondition(type))
+            fail("'!' sobre un operando no soportado");
+        return 3;
+    }
+    if (!isNumeric(type))
+        fail("'-' sobre un operando no soportado");
+    return type;
+}
+
+// Conversiones de bindArguments
+void StaticLowering::checkConversion(int from, int to)
+{
+    bool supported = from == to || (to == 1 && (from == 2 || from == 3)) ||
+                     (to == 2 && isCondition(from)) || (to == 3 && from == 1);
+    if (!supported)
+        fail("conversion no soportada de " + to_string(from) + " a " + to_string(to));
+}
+
+void StaticLowering::checkVarDec(VarDec *stm, int value)
+{
+    int type = typeCode(stm->type);
+    // add_var ignora la declaración con cualquier otra combinación
+    if (value != type && !(value == 1 && type == 2))
+        fail("inicializacion de '" + stm->id + "' con un valor de otro tipo");
+}
+
+void StaticLowering::checkAssign(const string &id, const Slot &slot, int value)
+{
+    // storeLast elige la versión de update según el tipo del valor
+    if (value != slot.type && !(value == 1 && slot.type == 2))
+        fail("asignacion de un valor de otro tipo a '" + id + "'");
+    // update(var, int) busca primero entre las variables Int de ese nombre
+    if (value == 1 && slot.type == 2 && intNames.count(id))
+        fail("asignacion Int a la Float '" + id + "' con una Int del mismo nombre");
+}
+
+// Devuelve false si la asignación compuesta no cambia la variable
+bool StaticLowering::checkCompound(const Slot &slot, int op, int value)
+{
+    if (slot.type == 5 && op == AssignStatement::PLUS_ASSIGN_OP)
+    {
+        binaryType(PLUS_OP, 5, value);
+        return true;
+    }
+    if (!isNumeric(slot.type))
+        return false;
+    if (slot.type == 1 && !isCondition(value))
+        fail("asignacion compuesta a Int con un valor que no es Int");
+    checkConversion(value, slot.type);
+    return true;
+}
+
+void StaticLowering::checkReturn(int value)
+{
+    int returnType = function->returnTypeCode;
+    if (value != returnType && !(returnType == 1 && value == 3))
+        fail("'" + function->name + "' devuelve un valor de otro tipo");
+}
+
+void StaticLowering::checkCondition(int type)
+{
+    if (!isCondition(type))
+        fail("condicion que no es Int ni Boolean");
+}
+
+void MemoTable::reset()
+{
+    entries.assign(SIZE, Entry());
+    hits = misses = 0;
+}
+
+size_t MemoTable::slot(int func, const SlotCell *cells, int ncells, const string *strings, int nstrings) const
+{
+    size_t h = hash<int>()(func);
+    for (int i = 0; i < ncells; i++)
+        h ^= hash<int>()(cells[i].i) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    for (int i = 0; i < nstrings; i++)
+        h ^= hash<string>()(strings[i]) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    return h % SIZE;
+}
+
+bool MemoTable::matches(size_t slot, int func, const SlotCell *cells, int ncells,
+                        const string *strings, int nstrings) const
+{
+    const Entry &entry = entries[slot];
+    return entry.func == func &&
+           equal(cells, cells + ncells, entry.cells.begin(),
+                 [](SlotCell x, SlotCell y) { return x.i == y.i; }) &&
+           equal(strings, strings + nstrings, entry.strings.begin());
+}
@@ -0,0 +1,95 @@
+#ifndef LOWERING_H
+#define LOWERING_H
+
+#include "exp.h"
+#include "visitor.h"
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Celdas de locales y globales numéricas de los motores que bajan el AST;
+// los String van en ranuras aparte.
+union SlotCell
+{
+    int i;
+    float f;
+};
+
+// Resolución estática de nombres compartida por el motor enhebrado y el de
+// clausuras. Cada variable recibe una ranura fija del marco de su función (o
+// de las globales). Si la ejecución podría depender del alcance dinámico o de
+// las conversiones silenciosas de EvalVisitor, fail lanza runtime_error con
+// el motivo y el driver usa el intérprete de árbol.
+class StaticLowering : public Visitor, protected ExpWalker
+{
+protected:
+    struct Slot
+    {
+        int type;
+        int index;
+        bool global;
+    };
+
+    std::unordered_set<string> intNames;
+    std::unordered_set<string> localNames;
+    std::unordered_map<string, Slot> globals;
+    std::vector<std::unordered_map<string, Slot>> scopes;
+    FunctionDecl *function = nullptr; // nullptr al inicializar las globales
+    int localCells = 0, localStrings = 0;
+    int globalCells = 0, globalStrings = 0;
+
+    void fail(const string &motivo);
+    // Valida el programa y devuelve main; deja las funciones en orden de
+    // aparición (si un nombre se repite gana la última, como en EvalVisitor)
+    FunctionDecl *prepare(Program *program, std::vector<FunctionDecl *> &functions,
+                          std::vector<VarDec *> &globalDecs);
+    void beginFunction(FunctionDecl *func);
+    void endFunction(FunctionDecl *func);
+    Slot lookup(const string &name);
+    Slot declare(const string &name, int type);
+    bool alwaysReturns(Stm *stm);
+
+    // Reglas de tipos de EvalVisitor; fallan si la combinación no se baja
+    int binaryType(int op, int left, int right);
+    int unaryType(int op, int type);
+    void checkConversion(int from, int to);
+    void checkVarDec(VarDec *stm, int value);
+    void checkAssign(const string &id, const Slot &slot, int value);
+    bool checkCompound(const Slot &slot, int op, int value);
+    void checkReturn(int value);
+    void checkCondition(int type);
+
+private:
+    void collect(Stm *stm, bool inFunction);
+    void declareName(const string &name, int type, bool inFunction);
+};
+
+// Memoización de funciones puras, igual que en EvalVisitor: tabla de
+// correspondencia directa indexada por función y argumentos.
+class MemoTable
+{
+public:
+    struct Entry
+    {
+        int func = -1;
+        std::vector<SlotCell> cells;
+        std::vector<string> strings;
+        SlotCell result;
+        string stringResult;
+    };
+    static const size_t SIZE = 4096;
+    long hits = 0;
+    long misses = 0;
+
+    void reset();
+    size_t slot(int func, const SlotCell *cells, int ncells, const string *strings, int nstrings) const;
+    bool matches(size_t slot, int func, const SlotCell *cells, int ncells,
+                 const string *strings, int nstrings) const;
+    Entry &operator[](size_t slot) { return entries[slot]; }
+
+private:
+    std::vector<Entry> entries;
+};
+
+#endif
@@ -1,24 +1,180 @@
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <string>
 #include "scanner.h"
 #include "parser.h"
 #include "visitor.h"
+#include "optimizer.h"
+#include "threaded.h"
+#include "closure.h"
+#include "elfwriter.h"
+#include "jit.h"
+#include "output.h"
 
 using namespace std;
 
+// Pasos (sentencias e iteraciones) que puede ejecutar main en tiempo de
+// compilación antes de renunciar a la evaluación anticipada.
+const long PRESUPUESTO_AOT = 10000000;
+
+void optimizar(Program *program)
+{
+    CallResolver callResolver;
+    callResolver.resolver(program);
+    Inliner inliner;
+    inliner.expandir(program);
+    ConstantFolder constantFolder;
+    constantFolder.optimizar(program);
+    DeadCodeEliminator deadCodeEliminator;
+    deadCodeEliminator.eliminar(program);
+    PurityAnalyzer purityAnalyzer;
+    purityAnalyzer.analizar(program);
+    SuperinstructionFuser superinstructionFuser;
+    superinstructionFuser.fusionar(program);
+}
+
+// Assembly de GenCodeVisitor para --run y --objeto, o el archivo tal cual si
+// ya es un .s
+bool generarAssembly(const string &archivo, const string &input, string &codigo, bool mirilla, bool marcos, bool perfil)
+{
+    if (archivo.size() > 2 && archivo.compare(archivo.size() - 2, 2, ".s") == 0)
+    {
+        codigo = input;
+        return true;
+    }
+    try
+    {
+        Scanner scanner(input.c_str());
+        Parser parser(&scanner);
+        Program *program = parser.parseProgram();
+        optimizar(program);
+        ostringstream assembly;
+        GenCodeVisitor genCodeVisitor(assembly);
+        if (!mirilla)
+            genCodeVisitor.desactivarMirilla();
+        if (marcos)
+            genCodeVisitor.conservarMarcos();
+        genCodeVisitor.generar(program);
+        if (perfil)
+            genCodeVisitor.imprimirPerfil(cerr);
+        codigo = assembly.str();
+        delete program;
+    }
+    catch (const exception &e)
+    {
+        cout << "Error durante la compilación: " << e.what() << endl;
+        return false;
+    }
+    return true;
+}
+
+// --run: ensambla con JitCompiler y ejecuta main en este proceso. Solo se
+// imprime la salida del programa y el código de salida es el que devuelve main.
+int ejecutarEnMemoria(const string &archivo, const string &input, bool mirilla, bool marcos, bool perfil)
+{
+    string codigo;
+    if (!generarAssembly(archivo, input, codigo, mirilla, marcos, perfil))
+        return 1;
+    JitCompiler jit;
+    if (!jit.ensamblar(codigo))
+    {
+        cout << "Error: " << jit.motivoFallo() << endl;
+        return 1;
+    }
+    if (perfil)
+        jit.imprimirPerfil();
+    return jit.ejecutar();
+}
+
+// --objeto: escribe <base>.o directamente, sin as, para enlazarlo con gcc
+int generarObjeto(const string &archivo, const string &input, bool mirilla, bool marcos, bool perfil)
+{
+    string codigo;
+    if (!generarAssembly(archivo, input, codigo, mirilla, marcos, perfil))
+        return 1;
+    size_t dotPos = archivo.find_last_of('.');
+    string baseName = (dotPos == string::npos) ? archivo : archivo.substr(0, dotPos);
+    ElfWriter elfWriter;
+    if (!elfWriter.escribir(codigo, baseName + ".o"))
+    {
+        cout << "Error: " << elfWriter.motivoFallo() << endl;
+        return 1;
+    }
+    if (perfil)
+        elfWriter.imprimirPerfil();
+    return 0;
+}
+
 int main(int argc, const char *argv[])
 {
-    if (argc != 2)
+    bool perfil = false;
+    bool aot = false;
+    bool especializar = true;
+    bool mirilla = true;
+    bool marcos = false;
+    bool enhebrado = false;
+    bool clausuras = false;
+    bool run = false;
+    bool objeto = false;
+    const char *archivo = nullptr;
+    int archivos = 0;
+    for (int i = 1; i < argc; i++)
     {
-        cout << "Numero incorrecto de argumentos. Uso: " << argv[0] << " <archivo_de_entrada>" << endl;
+        string arg = argv[i];
+        if (arg == "--perfil")
+        {
+            perfil = true;
+        }
+        else if (arg == "--aot")
+        {
+            aot = true;
+        }
+        else if (arg == "--sin-especializar")
+        {
+            especializar = false;
+        }
+        else if (arg == "--sin-mirilla")
+        {
+            mirilla = false;
+        }
+        else if (arg == "--con-marco")
+        {
+            marcos = true;
+        }
+        else if (arg == "--enhebrado")
+        {
+            enhebrado = true;
+        }
+        else if (arg == "--clausuras")
+        {
+            clausuras = true;
+        }
+        else if (arg == "--run")
+        {
+            run = true;
+        }
+        else if (arg == "--objeto")
+        {
+            objeto = true;
+        }
+        else
+        {
+            archivo = argv[i];
+            archivos++;
+        }
+    }
+    // --aot precalcula la salida con el intérprete, que --run y --objeto no usan
+    if (archivos != 1 || enhebrado + clausuras + run + objeto > 1 || (aot && (run || objeto)))
+    {
+        cout << "Numero incorrecto de argumentos. Uso: " << argv[0] << " [--perfil] [--aot] [--sin-especializar] [--sin-mirilla] [--con-marco] [--enhebrado | --clausuras | --run | --objeto] <archivo_de_entrada>" << endl;
         exit(1);
     }
 
-    ifstream infile(argv[1]);
+    ifstream infile(archivo);
     if (!infile.is_open())
     {
-        cout << "No se pudo abrir el archivo: " << argv[1] << endl;
+        cout << "No se pudo abrir el archivo: " << archivo << endl;
         exit(1);
     }
 
@@ -30,6 +186,11 @@ int main(int argc, const char *argv[])
     }
     infile.close();
 
+    if (run)
+        return ejecutarEnMemoria(archivo, input, mirilla, marcos, perfil);
+    if (objeto)
+        return generarObjeto(archivo, input, mirilla, marcos, perfil);
+
     Scanner scanner(input.c_str());
 
     string input_copy = input;
@@ -51,12 +212,40 @@ int main(int argc, const char *argv[])
         cout << "IMPRIMIR:" << endl;
         printVisitor.imprimir(program);
         cout << endl;
+        optimizar(program);
         cout << "EJECUTAR:" << endl;
-        evalVisitor.ejecutar(program);
+        if (aot)
+            evalVisitor.capturarSalida(PRESUPUESTO_AOT);
+        if (!especializar)
+            evalVisitor.desactivarEspecializacion();
+        if (perfil)
+            evalVisitor.activarPerfil();
+        // La evaluación anticipada necesita la salida capturada por EvalVisitor
+        ThreadedEngine motorEnhebrado;
+        bool usarEnhebrado = enhebrado && !aot && motorEnhebrado.compilar(program);
+        ClosureEngine motorClausuras;
+        bool usarClausuras = clausuras && !aot && motorClausuras.compilar(program);
+        if (usarEnhebrado)
+            motorEnhebrado.ejecutar();
+        else if (usarClausuras)
+            motorClausuras.ejecutar();
+        else
+            evalVisitor.ejecutar(program);
         cout << endl;
+        if (perfil)
+        {
+            cout << "PERFIL:" << endl;
+            if (enhebrado && !aot)
+                motorEnhebrado.imprimirPerfil();
+            if (clausuras && !aot)
+                motorClausuras.imprimirPerfil();
+            if (!usarEnhebrado && !usarClausuras)
+                evalVisitor.imprimirPerfil();
+            cout << endl;
+        }
         cout << "GENERAR CODIGO ASSEMBLY:" << endl;
 
-        string inputFile(argv[1]);
+        string inputFile(archivo);
         size_t dotPos = inputFile.find_last_of('.');
         string baseName = (dotPos == string::npos) ? inputFile : inputFile.substr(0, dotPos);
         string outputFilename = baseName + ".s";
@@ -68,13 +257,31 @@ int main(int argc, const char *argv[])
         }
 
         GenCodeVisitor genCodeVisitor(outfile);
-        genCodeVisitor.generar(program);
+        if (!mirilla)
+            genCodeVisitor.desactivarMirilla();
+        if (marcos)
+            genCodeVisitor.conservarMarcos();
+        string salidaAot;
+        if (aot && evalVisitor.salidaCapturada(salidaAot))
+        {
+            cout << "Evaluacion anticipada: salida precalculada (" << salidaAot.size() << " bytes)" << endl;
+            genCodeVisitor.generarSalidaFija(salidaAot);
+        }
+        else
+        {
+            if (aot)
+                cout << "Evaluacion anticipada: presupuesto agotado, se genera el programa completo" << endl;
+            genCodeVisitor.generar(program);
+            if (perfil)
+                genCodeVisitor.imprimirPerfil(cout);
+        }
         outfile.close();
         cout << endl;
         delete program;
     }
     catch (const exception &e)
     {
+        salidaPrograma.vaciar();
         cout << "Error durante la ejecución: " << e.what() << endl;
         return 1;
     }
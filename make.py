@@ -6,7 +6,9 @@ test_dir = "test"
 
 source_files = [
     "main.cpp", "parser.cpp", "scanner.cpp", "token.cpp",
-    "visitor.cpp", "exp.cpp"
+    "visitor.cpp", "exp.cpp", "optimizer.cpp", "lowering.cpp", "threaded.cpp",
+    "closure.cpp", "assembler.cpp", "elfwriter.cpp", "jit.cpp", "output.cpp", "peephole.cpp",
+    "frame.cpp"
 ]
 
 def compile_project():
@@ -16,6 +18,8 @@ def compile_project():
         executable = "main"
 
     compile_cmd = ["g++", "-o", executable] + source_files
+    if os.name != 'nt':
+        compile_cmd.append("-ldl")
     result = subprocess.run(compile_cmd)
 
     if result.returncode != 0:
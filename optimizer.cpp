@@ -0,0 +1,1820 @@
+#include <iostream>
+#include <stdexcept>
+#include <climits>
+#include "exp.h"
+#include "visitor.h"
+#include "optimizer.h"
+using namespace std;
+
+static bool literalValue(Exp *exp, EvalValue &value)
+{
+    if (NumberExp *num = dynamic_cast<NumberExp *>(exp))
+        value = {1, num->value, 0.0f, ""};
+    else if (DecimalExp *dec = dynamic_cast<DecimalExp *>(exp))
+        value = {2, 0, dec->value, ""};
+    else if (BoolExp *boolean = dynamic_cast<BoolExp *>(exp))
+        value = {3, boolean->value, 0.0f, ""};
+    else if (StringExp *str = dynamic_cast<StringExp *>(exp))
+        value = {5, 0, 0.0f, str->value};
+    else
+        return false;
+    return true;
+}
+
+static Exp *makeLiteral(const EvalValue &value)
+{
+    switch (value.type)
+    {
+    case 1:
+        return new NumberExp(value.intValue);
+    case 2:
+    {
+        DecimalExp *dec = new DecimalExp(value.floatValue);
+        dec->has_f = true;
+        dec->original_text = formatFloat(value.floatValue) + "f";
+        return dec;
+    }
+    case 3:
+        return new BoolExp(value.intValue != 0);
+    case 5:
+        return new StringExp(value.stringValue);
+    default:
+        return nullptr;
+    }
+}
+
+// Sustituye exp por un literal si todos sus operandos ya son literales.
+Exp *ConstantFolder::reduce(Exp *exp)
+{
+    EvalValue left, right;
+    Exp *folded = nullptr;
+
+    if (ParenthesizedExp *paren = dynamic_cast<ParenthesizedExp *>(exp))
+    {
+        if (!literalValue(paren->expr, left))
+            return exp;
+        folded = paren->expr;
+        paren->expr = nullptr;
+    }
+    else if (UnaryExp *unary = dynamic_cast<UnaryExp *>(exp))
+    {
+        if (!isOperatorNode(unary) || !literalValue(unary->expr, left))
+            return exp;
+        folded = makeLiteral(evalUnaryOp(unary->op, left));
+    }
+    else if (BinaryExp *bin = dynamic_cast<BinaryExp *>(exp))
+    {
+        // false && x y true || x no evalúan x: basta con el literal izquierdo
+        bool leftLiteral = literalValue(bin->left, left) && left.type == 3;
+        if (leftLiteral && ((bin->op == AND_OP && !left.intValue) || (bin->op == OR_OP && left.intValue)))
+        {
+            delete exp;
+            return makeLiteral(left);
+        }
+        if (!literalValue(bin->left, left) || !literalValue(bin->right, right))
+            return exp;
+        bool zeroDivisor = (right.type == 2) ? right.floatValue == 0.0f : right.intValue == 0;
+        // INT_MIN / -1 no cabe en un Int: se deja para la ejecución, como x / 0
+        bool overflow = left.type != 2 && right.type != 2 && left.intValue == INT_MIN && right.intValue == -1;
+        if ((bin->op == DIV_OP || bin->op == MOD_OP) && (zeroDivisor || overflow))
+            return exp;
+        folded = makeLiteral(evalBinaryOp(bin->op, left, right));
+    }
+
+    if (!folded)
+        return exp;
+    delete exp;
+    return folded;
+}
+
+void ConstantFolder::foldExp(Exp *&exp)
+{
+    if (!exp)
+        return;
+    walk(exp);
+    exp = reduce(exp);
+}
+
+void ConstantFolder::onLeaf(Exp *exp)
+{
+    exp->accept(this);
+}
+
+void ConstantFolder::onExit(Exp *exp)
+{
+    if (BinaryExp *bin = dynamic_cast<BinaryExp *>(exp))
+    {
+        bin->left = reduce(bin->left);
+        bin->right = reduce(bin->right);
+    }
+    else if (ParenthesizedExp *paren = dynamic_cast<ParenthesizedExp *>(exp))
+    {
+        paren->expr = reduce(paren->expr);
+    }
+    else if (UnaryExp *unary = dynamic_cast<UnaryExp *>(exp))
+    {
+        unary->expr = reduce(unary->expr);
+    }
+}
+
+void ConstantFolder::optimizar(Program *program)
+{
+    if (program && program->statements)
+        program->statements->accept(this);
+}
+
+int ConstantFolder::visit(BinaryExp *exp)
+{
+    walk(exp);
+    return 0;
+}
+
+int ConstantFolder::visit(NumberExp *exp) { return 0; }
+int ConstantFolder::visit(DecimalExp *exp) { return 0; }
+int ConstantFolder::visit(BoolExp *exp) { return 0; }
+int ConstantFolder::visit(IdentifierExp *exp) { return 0; }
+int ConstantFolder::visit(StringExp *exp) { return 0; }
+
+int ConstantFolder::visit(RangeExp *exp)
+{
+    foldExp(exp->start);
+    foldExp(exp->end);
+    foldExp(exp->step);
+    return 0;
+}
+
+int ConstantFolder::visit(ParenthesizedExp *exp)
+{
+    walk(exp);
+    return 0;
+}
+
+int ConstantFolder::visit(FunctionCallExp *exp)
+{
+    for (auto &arg : exp->args)
+    {
+        foldExp(arg);
+    }
+    return 0;
+}
+
+int ConstantFolder::visit(UnaryExp *exp)
+{
+    if (isOperatorNode(exp))
+        walk(exp);
+    return 0;
+}
+
+int ConstantFolder::visit(RunExp *exp)
+{
+    if (exp->block)
+        exp->block->accept(this);
+    return 0;
+}
+
+void ConstantFolder::visit(AssignStatement *stm)
+{
+    foldExp(stm->rhs);
+}
+
+void ConstantFolder::visit(PrintStatement *stm)
+{
+    foldExp(stm->e);
+}
+
+void ConstantFolder::visit(ExpressionStatement *stm)
+{
+    foldExp(stm->expr);
+}
+
+void ConstantFolder::visit(IfStatement *stm)
+{
+    foldExp(stm->condition);
+    if (stm->thenStmt)
+        stm->thenStmt->accept(this);
+    if (stm->elseStmt)
+        stm->elseStmt->accept(this);
+}
+
+void ConstantFolder::visit(WhileStatement *stm)
+{
+    foldExp(stm->condition);
+    if (stm->stmt)
+        stm->stmt->accept(this);
+}
+
+void ConstantFolder::visit(DoWhileStatement *stm)
+{
+    if (stm->stmt)
+        stm->stmt->accept(this);
+    foldExp(stm->condition);
+}
+
+void ConstantFolder::visit(ForStatement *stm)
+{
+    foldExp(stm->range);
+    if (stm->stmt)
+        stm->stmt->accept(this);
+}
+
+void ConstantFolder::visit(VarDec *stm)
+{
+    foldExp(stm->value);
+}
+
+void ConstantFolder::visit(VarDecList *stm)
+{
+    for (auto dec : stm->decls)
+    {
+        dec->accept(this);
+    }
+}
+
+void ConstantFolder::visit(StatementList *stm)
+{
+    for (auto s : stm->stms)
+    {
+        if (s)
+            s->accept(this);
+    }
+}
+
+void ConstantFolder::visit(Block *stm)
+{
+    if (stm->statements)
+        stm->statements->accept(this);
+}
+
+void ConstantFolder::visit(RunBlock *stm)
+{
+    if (stm->statements)
+        stm->statements->accept(this);
+}
+
+void ConstantFolder::visit(FunctionDecl *stm)
+{
+    if (stm->body)
+        stm->body->accept(this);
+}
+
+void ConstantFolder::visit(ReturnStatement *stm)
+{
+    foldExp(stm->expr);
+}
+
+void ConstantFolder::visit(BreakStatement *stm) {}
+void ConstantFolder::visit(ContinueStatement *stm) {}
+
+static string typeName(int type)
+{
+    switch (type)
+    {
+    case 1:
+        return "Int";
+    case 2:
+        return "Float";
+    case 3:
+        return "Boolean";
+    case 5:
+        return "String";
+    case 0:
+        return "Unit";
+    default:
+        return "desconocido";
+    }
+}
+
+// El tipo resultante sale de las mismas reglas que usa el interprete.
+static int binaryResultType(int op, int left, int right)
+{
+    int result = evalBinaryOp(op, {left, 1, 1.0f, ""}, {right, 1, 1.0f, ""}).type;
+    if ((left <= 0 || right <= 0) && result != 3)
+        return -1;
+    return result;
+}
+
+static int unaryResultType(int op, int type)
+{
+    return evalUnaryOp(op, {type, 1, 1.0f, ""}).type;
+}
+
+// Un divisor que no es un literal distinto de cero puede fallar en ejecución
+static bool mayFailDivision(BinaryExp *bin)
+{
+    if (bin->op != DIV_OP && bin->op != MOD_OP)
+        return false;
+    EvalValue divisor;
+    return !literalValue(bin->right, divisor) || (divisor.type == 1 && divisor.intValue == 0);
+}
+
+void CallResolver::resolver(Program *program)
+{
+    if (!program || !program->statements)
+        return;
+
+    errors = 0;
+    scopes.assign(1, unordered_map<string, int>());
+    for (auto stmt : program->statements->stms)
+    {
+        if (FunctionDecl *funcDecl = dynamic_cast<FunctionDecl *>(stmt))
+            functions[funcDecl->name] = funcDecl;
+    }
+
+    program->statements->accept(this);
+
+    if (errors > 0)
+        throw runtime_error(to_string(errors) + " error(es) en llamadas a funciones");
+}
+
+int CallResolver::typeOf(Exp *exp)
+{
+    if (!exp)
+        return -1;
+    walk(exp);
+    int type = typeStack.back();
+    typeStack.pop_back();
+    return type;
+}
+
+int CallResolver::lookupVariable(const string &name)
+{
+    for (auto it = scopes.rbegin(); it != scopes.rend(); ++it)
+    {
+        auto found = it->find(name);
+        if (found != it->end())
+            return found->second;
+    }
+    return -1;
+}
+
+void CallResolver::declare(const string &name, int type)
+{
+    scopes.back()[name] = type;
+}
+
+void CallResolver::onLeaf(Exp *exp)
+{
+    typeStack.push_back(exp->accept(this));
+}
+
+void CallResolver::onExit(Exp *exp)
+{
+    if (BinaryExp *bin = dynamic_cast<BinaryExp *>(exp))
+    {
+        int right = typeStack.back();
+        typeStack.pop_back();
+        typeStack.back() = binaryResultType(bin->op, typeStack.back(), right);
+    }
+    else if (UnaryExp *unary = dynamic_cast<UnaryExp *>(exp))
+    {
+        typeStack.back() = unaryResultType(unary->op, typeStack.back());
+    }
+}
+
+int CallResolver::visit(BinaryExp *exp) { return typeOf(exp); }
+int CallResolver::visit(NumberExp *exp) { return 1; }
+int CallResolver::visit(DecimalExp *exp) { return 2; }
+int CallResolver::visit(BoolExp *exp) { return 3; }
+int CallResolver::visit(StringExp *exp) { return 5; }
+int CallResolver::visit(ParenthesizedExp *exp) { return typeOf(exp); }
+
+int CallResolver::visit(IdentifierExp *exp)
+{
+    return lookupVariable(exp->name);
+}
+
+int CallResolver::visit(RangeExp *exp)
+{
+    typeOf(exp->start);
+    typeOf(exp->end);
+    typeOf(exp->step);
+    return 4;
+}
+
+int CallResolver::visit(FunctionCallExp *exp)
+{
+    // Solo la llamada misma del return está en posición de cola, no sus argumentos
+    bool inTailPosition = exp == tailCall;
+    tailCall = nullptr;
+
+    vector<int> argTypes;
+    for (auto arg : exp->args)
+    {
+        argTypes.push_back(typeOf(arg));
+    }
+
+    auto it = functions.find(exp->name);
+    if (it == functions.end())
+    {
+        cout << "Error: la función '" << exp->name << "' no está declarada" << endl;
+        errors++;
+        return -1;
+    }
+
+    FunctionDecl *func = it->second;
+    exp->decl = func;
+    exp->argTypes = argTypes;
+
+    if (func == currentFunction && func->isTailrec && !inTailPosition)
+    {
+        cout << "Error: la llamada recursiva a '" << exp->name
+             << "' no está en posición de cola en una función tailrec" << endl;
+        errors++;
+    }
+
+    if (argTypes.size() != func->paramTypes.size())
+    {
+        cout << "Error: la función '" << exp->name << "' espera " << func->paramTypes.size()
+             << " argumentos, pero recibió " << argTypes.size() << endl;
+        errors++;
+        return func->returnTypeCode;
+    }
+
+    for (size_t i = 0; i < argTypes.size(); i++)
+    {
+        int expected = func->paramTypes[i];
+        int actual = argTypes[i];
+        bool compatible = actual <= 0 || expected == actual || (expected == 2 && actual == 1);
+        if (!compatible)
+        {
+            cout << "Error: el argumento " << i + 1 << " de '" << exp->name << "' debe ser "
+                 << typeName(expected) << ", pero es " << typeName(actual) << endl;
+            errors++;
+        }
+    }
+    return func->returnTypeCode;
+}
+
+int CallResolver::visit(UnaryExp *exp)
+{
+    if (isOperatorNode(exp))
+        return typeOf(exp);
+    return typeOf(exp->expr);
+}
+
+int CallResolver::visit(RunExp *exp)
+{
+    if (exp->block)
+        exp->block->accept(this);
+    return -1;
+}
+
+void CallResolver::visit(AssignStatement *stm)
+{
+    typeOf(stm->rhs);
+}
+
+void CallResolver::visit(PrintStatement *stm)
+{
+    typeOf(stm->e);
+}
+
+void CallResolver::visit(ExpressionStatement *stm)
+{
+    typeOf(stm->expr);
+}
+
+void CallResolver::visit(IfStatement *stm)
+{
+    typeOf(stm->condition);
+    if (stm->thenStmt)
+        stm->thenStmt->accept(this);
+    if (stm->elseStmt)
+        stm->elseStmt->accept(this);
+}
+
+void CallResolver::visit(WhileStatement *stm)
+{
+    typeOf(stm->condition);
+    if (stm->stmt)
+        stm->stmt->accept(this);
+}
+
+void CallResolver::visit(DoWhileStatement *stm)
+{
+    if (stm->stmt)
+        stm->stmt->accept(this);
+    typeOf(stm->condition);
+}
+
+void CallResolver::visit(ForStatement *stm)
+{
+    typeOf(stm->range);
+    scopes.push_back(unordered_map<string, int>());
+    declare(stm->id, 1);
+    if (stm->stmt)
+        stm->stmt->accept(this);
+    scopes.pop_back();
+}
+
+void CallResolver::visit(VarDec *stm)
+{
+    typeOf(stm->value);
+    declare(stm->id, typeCode(stm->type));
+}
+
+void CallResolver::visit(VarDecList *stm)
+{
+    for (auto dec : stm->decls)
+    {
+        dec->accept(this);
+    }
+}
+
+void CallResolver::visit(StatementList *stm)
+{
+    for (auto s : stm->stms)
+    {
+        if (s)
+            s->accept(this);
+    }
+}
+
+void CallResolver::visit(Block *stm)
+{
+    scopes.push_back(unordered_map<string, int>());
+    if (stm->statements)
+        stm->statements->accept(this);
+    scopes.pop_back();
+}
+
+void CallResolver::visit(RunBlock *stm)
+{
+    scopes.push_back(unordered_map<string, int>());
+    if (stm->statements)
+        stm->statements->accept(this);
+    scopes.pop_back();
+}
+
+void CallResolver::visit(FunctionDecl *stm)
+{
+    if (!functions.count(stm->name))
+        functions[stm->name] = stm;
+
+    scopes.push_back(unordered_map<string, int>());
+    auto type_it = stm->paramTypes.begin();
+    for (auto &param : stm->params)
+    {
+        declare(param.first, *type_it++);
+    }
+    currentFunction = stm;
+    if (stm->body)
+        stm->body->accept(this);
+    currentFunction = nullptr;
+    scopes.pop_back();
+}
+
+void CallResolver::visit(ReturnStatement *stm)
+{
+    tailCall = dynamic_cast<FunctionCallExp *>(stm->expr);
+    typeOf(stm->expr);
+    tailCall = nullptr;
+}
+
+void CallResolver::visit(BreakStatement *stm) {}
+void CallResolver::visit(ContinueStatement *stm) {}
+
+void DeadCodeEliminator::eliminar(Program *program)
+{
+    if (!program || !program->statements)
+        return;
+
+    removed = 0;
+    phase = PRUNE;
+    program->statements->accept(this);
+    removeUnreachableFunctions(program);
+
+    // Quitar un val puede dejar sin lecturas a otro: se repite hasta el punto fijo
+    int before;
+    do
+    {
+        before = removed;
+        uses.clear();
+        phase = COLLECT;
+        program->statements->accept(this);
+        phase = SWEEP;
+        program->statements->accept(this);
+    } while (removed != before);
+}
+
+void DeadCodeEliminator::scan(Exp *exp)
+{
+    if (exp)
+        walk(exp);
+}
+
+bool DeadCodeEliminator::isPure(Exp *exp)
+{
+    impure = false;
+    scan(exp);
+    return !impure;
+}
+
+static bool declaresVariables(Block *block)
+{
+    for (auto stm : block->statements->stms)
+    {
+        if (dynamic_cast<VarDec *>(stm))
+            return true;
+    }
+    return false;
+}
+
+void DeadCodeEliminator::pruneUnreachable(StatementList *list)
+{
+    auto it = list->stms.begin();
+    while (it != list->stms.end())
+    {
+        Stm *stm = *it;
+
+        IfStatement *ifStm = dynamic_cast<IfStatement *>(stm);
+        BoolExp *ifCondition = ifStm ? dynamic_cast<BoolExp *>(ifStm->condition) : nullptr;
+        if (ifCondition)
+        {
+            Stm *taken = ifCondition->value ? ifStm->thenStmt : ifStm->elseStmt;
+            Stm *dropped = ifCondition->value ? ifStm->elseStmt : ifStm->thenStmt;
+            Block *block = dynamic_cast<Block *>(taken);
+
+            if (block && declaresVariables(block))
+            {
+                // El bloque abre un ámbito propio: queda como if (true) sin la otra rama
+                if (dropped || !ifCondition->value)
+                    removed++;
+                delete dropped;
+                ifStm->thenStmt = taken;
+                ifStm->elseStmt = nullptr;
+                ifCondition->value = 1;
+                ++it;
+                continue;
+            }
+
+            ifStm->thenStmt = nullptr;
+            ifStm->elseStmt = nullptr;
+            delete ifStm;
+            delete dropped;
+            removed++;
+
+            if (block)
+            {
+                // Las sentencias de la rama ocupan el lugar del if y se revisan también
+                auto first = block->statements->stms.begin();
+                bool empty = block->statements->stms.empty();
+                list->stms.splice(it, block->statements->stms);
+                it = list->stms.erase(it);
+                if (!empty)
+                    it = first;
+                delete block;
+            }
+            else if (taken)
+            {
+                *it = taken;
+            }
+            else
+            {
+                it = list->stms.erase(it);
+            }
+            continue;
+        }
+
+        WhileStatement *whileStm = dynamic_cast<WhileStatement *>(stm);
+        BoolExp *whileCondition = whileStm ? dynamic_cast<BoolExp *>(whileStm->condition) : nullptr;
+        if (whileCondition && !whileCondition->value)
+        {
+            delete whileStm;
+            removed++;
+            it = list->stms.erase(it);
+            continue;
+        }
+
+        ++it;
+        if (dynamic_cast<ReturnStatement *>(stm) || dynamic_cast<BreakStatement *>(stm) ||
+            dynamic_cast<ContinueStatement *>(stm))
+        {
+            for (auto dead = it; dead != list->stms.end(); ++dead)
+            {
+                delete *dead;
+                removed++;
+            }
+            list->stms.erase(it, list->stms.end());
+            break;
+        }
+    }
+}
+
+void DeadCodeEliminator::sweepUnusedVals(StatementList *list)
+{
+    auto it = list->stms.begin();
+    while (it != list->stms.end())
+    {
+        VarDec *dec = dynamic_cast<VarDec *>(*it);
+        if (dec && dec->isVal && uses[dec->id] == 0 && isPure(dec->value))
+        {
+            delete dec;
+            removed++;
+            it = list->stms.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+// Las llamadas de los inicializadores globales también son raíces: el
+// intérprete los ejecuta antes de main.
+void DeadCodeEliminator::removeUnreachableFunctions(Program *program)
+{
+    unordered_map<string, unordered_set<string>> callGraph;
+    vector<string> pending;
+    bool hasMain = false;
+
+    phase = COLLECT;
+    for (auto stm : program->statements->stms)
+    {
+        calls.clear();
+        stm->accept(this);
+        FunctionDecl *func = dynamic_cast<FunctionDecl *>(stm);
+        if (func)
+        {
+            callGraph[func->name].insert(calls.begin(), calls.end());
+            hasMain = hasMain || func->name == "main";
+        }
+        else
+        {
+            pending.insert(pending.end(), calls.begin(), calls.end());
+        }
+    }
+    if (!hasMain)
+        return;
+
+    unordered_set<string> reachable;
+    pending.push_back("main");
+    while (!pending.empty())
+    {
+        string name = pending.back();
+        pending.pop_back();
+        if (!reachable.insert(name).second)
+            continue;
+        for (const string &callee : callGraph[name])
+        {
+            pending.push_back(callee);
+        }
+    }
+
+    auto &stms = program->statements->stms;
+    auto it = stms.begin();
+    while (it != stms.end())
+    {
+        FunctionDecl *func = dynamic_cast<FunctionDecl *>(*it);
+        if (func && !reachable.count(func->name))
+        {
+            delete func;
+            removed++;
+            it = stms.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void DeadCodeEliminator::onLeaf(Exp *exp)
+{
+    exp->accept(this);
+}
+
+void DeadCodeEliminator::onExit(Exp *exp)
+{
+    BinaryExp *bin = dynamic_cast<BinaryExp *>(exp);
+    if (bin && mayFailDivision(bin))
+        impure = true;
+}
+
+int DeadCodeEliminator::visit(BinaryExp *exp)
+{
+    walk(exp);
+    return 0;
+}
+
+int DeadCodeEliminator::visit(NumberExp *exp) { return 0; }
+int DeadCodeEliminator::visit(DecimalExp *exp) { return 0; }
+int DeadCodeEliminator::visit(BoolExp *exp) { return 0; }
+int DeadCodeEliminator::visit(StringExp *exp) { return 0; }
+
+int DeadCodeEliminator::visit(IdentifierExp *exp)
+{
+    if (phase == COLLECT)
+        uses[exp->name]++;
+    return 0;
+}
+
+int DeadCodeEliminator::visit(RangeExp *exp)
+{
+    scan(exp->start);
+    scan(exp->end);
+    scan(exp->step);
+    return 0;
+}
+
+int DeadCodeEliminator::visit(ParenthesizedExp *exp)
+{
+    walk(exp);
+    return 0;
+}
+
+int DeadCodeEliminator::visit(FunctionCallExp *exp)
+{
+    impure = true;
+    calls.insert(exp->name);
+    for (auto arg : exp->args)
+    {
+        scan(arg);
+    }
+    return 0;
+}
+
+int DeadCodeEliminator::visit(UnaryExp *exp)
+{
+    if (isOperatorNode(exp))
+    {
+        walk(exp);
+        return 0;
+    }
+    impure = true;
+    scan(exp->expr);
+    return 0;
+}
+
+int DeadCodeEliminator::visit(RunExp *exp)
+{
+    impure = true;
+    if (exp->block)
+        exp->block->accept(this);
+    return 0;
+}
+
+void DeadCodeEliminator::visit(AssignStatement *stm)
+{
+    scan(stm->rhs);
+}
+
+void DeadCodeEliminator::visit(PrintStatement *stm)
+{
+    scan(stm->e);
+}
+
+void DeadCodeEliminator::visit(ExpressionStatement *stm)
+{
+    scan(stm->expr);
+}
+
+void DeadCodeEliminator::visit(IfStatement *stm)
+{
+    scan(stm->condition);
+    if (stm->thenStmt)
+        stm->thenStmt->accept(this);
+    if (stm->elseStmt)
+        stm->elseStmt->accept(this);
+}
+
+void DeadCodeEliminator::visit(WhileStatement *stm)
+{
+    scan(stm->condition);
+    if (stm->stmt)
+        stm->stmt->accept(this);
+}
+
+void DeadCodeEliminator::visit(DoWhileStatement *stm)
+{
+    if (stm->stmt)
+        stm->stmt->accept(this);
+    scan(stm->condition);
+}
+
+void DeadCodeEliminator::visit(ForStatement *stm)
+{
+    scan(stm->range);
+    if (stm->stmt)
+        stm->stmt->accept(this);
+}
+
+void DeadCodeEliminator::visit(VarDec *stm)
+{
+    scan(stm->value);
+}
+
+void DeadCodeEliminator::visit(VarDecList *stm)
+{
+    for (auto dec : stm->decls)
+    {
+        dec->accept(this);
+    }
+}
+
+void DeadCodeEliminator::visit(StatementList *stm)
+{
+    if (phase == PRUNE)
+        pruneUnreachable(stm);
+    else if (phase == SWEEP)
+        sweepUnusedVals(stm);
+
+    for (auto s : stm->stms)
+    {
+        if (s)
+            s->accept(this);
+    }
+}
+
+void DeadCodeEliminator::visit(Block *stm)
+{
+    if (stm->statements)
+        stm->statements->accept(this);
+}
+
+void DeadCodeEliminator::visit(RunBlock *stm)
+{
+    if (stm->statements)
+        stm->statements->accept(this);
+}
+
+void DeadCodeEliminator::visit(FunctionDecl *stm)
+{
+    if (stm->body)
+        stm->body->accept(this);
+}
+
+void DeadCodeEliminator::visit(ReturnStatement *stm)
+{
+    scan(stm->expr);
+}
+
+void DeadCodeEliminator::visit(BreakStatement *stm) {}
+void DeadCodeEliminator::visit(ContinueStatement *stm) {}
+
+void Inliner::expandir(Program *program)
+{
+    if (!program || !program->statements)
+        return;
+
+    for (auto stm : program->statements->stms)
+    {
+        FunctionDecl *func = dynamic_cast<FunctionDecl *>(stm);
+        if (!func || !func->body || !func->body->statements || func->body->statements->stms.size() != 1)
+            continue;
+        ReturnStatement *ret = dynamic_cast<ReturnStatement *>(func->body->statements->stms.front());
+        if (!ret || !ret->expr)
+            continue;
+
+        paramTypes.clear();
+        paramUses.clear();
+        auto type_it = func->paramTypes.begin();
+        for (auto &param : func->params)
+        {
+            paramTypes[param.first] = *type_it++;
+        }
+        Summary body = analyze(ret->expr);
+        if (body.size <= BUDGET && !body.hasCall && !body.hasEffect && !body.foreign &&
+            body.type == func->returnTypeCode)
+            candidates[func] = {ret->expr, paramUses};
+    }
+    paramTypes.clear();
+
+    phase = REWRITE;
+    program->statements->accept(this);
+}
+
+Inliner::Summary Inliner::analyze(Exp *exp)
+{
+    Phase previous = phase;
+    phase = ANALYZE;
+    summary = {-1, 0, false, false, false, false};
+    walk(exp);
+    summary.type = typeStack.back();
+    typeStack.pop_back();
+    phase = previous;
+    return summary;
+}
+
+Exp *Inliner::clone(Exp *exp)
+{
+    Phase previous = phase;
+    phase = CLONE;
+    walk(exp);
+    Exp *copy = cloneStack.back();
+    cloneStack.pop_back();
+    phase = previous;
+    return copy;
+}
+
+static bool isSimpleArgument(Exp *exp)
+{
+    return dynamic_cast<NumberExp *>(exp) || dynamic_cast<DecimalExp *>(exp) || dynamic_cast<BoolExp *>(exp) ||
+           dynamic_cast<StringExp *>(exp) || dynamic_cast<IdentifierExp *>(exp);
+}
+
+Exp *Inliner::expand(Exp *exp)
+{
+    FunctionCallExp *call = dynamic_cast<FunctionCallExp *>(exp);
+    if (!call || !call->decl)
+        return exp;
+    auto it = candidates.find(call->decl);
+    if (it == candidates.end() || call->argTypes != call->decl->paramTypes)
+        return exp;
+
+    Candidate &candidate = it->second;
+    unordered_map<string, Exp *> bindings;
+    auto param = call->decl->params.begin();
+    for (auto arg : call->args)
+    {
+        if (!isSimpleArgument(arg))
+        {
+            Summary argument = analyze(arg);
+            if (argument.hasCall || argument.hasEffect || argument.mayFail || candidate.paramUses[param->first] > 1)
+                return exp;
+        }
+        bindings[param->first] = arg;
+        ++param;
+    }
+
+    substitutions = bindings;
+    Exp *result = clone(candidate.body);
+    substitutions.clear();
+    delete call;
+    return result;
+}
+
+void Inliner::inlineExp(Exp *&exp)
+{
+    if (!exp)
+        return;
+    walk(exp);
+    exp = expand(exp);
+}
+
+void Inliner::analyzeLeaf(Exp *exp)
+{
+    int type = -1;
+    if (dynamic_cast<NumberExp *>(exp))
+        type = 1;
+    else if (dynamic_cast<DecimalExp *>(exp))
+        type = 2;
+    else if (dynamic_cast<BoolExp *>(exp))
+        type = 3;
+    else if (dynamic_cast<StringExp *>(exp))
+        type = 5;
+    else if (IdentifierExp *id = dynamic_cast<IdentifierExp *>(exp))
+    {
+        auto it = paramTypes.find(id->name);
+        if (it != paramTypes.end())
+        {
+            type = it->second;
+            paramUses[id->name]++;
+        }
+        else
+        {
+            summary.foreign = true;
+        }
+    }
+    else if (dynamic_cast<FunctionCallExp *>(exp))
+        summary.hasCall = true;
+    else
+        summary.hasEffect = true;
+    typeStack.push_back(type);
+}
+
+Exp *Inliner::cloneLeaf(Exp *exp)
+{
+    if (IdentifierExp *id = dynamic_cast<IdentifierExp *>(exp))
+    {
+        auto it = substitutions.find(id->name);
+        if (it == substitutions.end())
+            return new IdentifierExp(id->name);
+        // El argumento pertenece al llamador: se copia sin sustituciones
+        unordered_map<string, Exp *> saved;
+        saved.swap(substitutions);
+        Exp *copy = clone(it->second);
+        substitutions.swap(saved);
+        return copy;
+    }
+
+    Exp *copy = nullptr;
+    if (NumberExp *num = dynamic_cast<NumberExp *>(exp))
+        copy = new NumberExp(num->value);
+    else if (BoolExp *boolean = dynamic_cast<BoolExp *>(exp))
+        copy = new BoolExp(boolean->value != 0);
+    else if (StringExp *str = dynamic_cast<StringExp *>(exp))
+        copy = new StringExp(str->value);
+    else if (DecimalExp *dec = dynamic_cast<DecimalExp *>(exp))
+    {
+        DecimalExp *decCopy = new DecimalExp(dec->value);
+        decCopy->original_text = dec->original_text;
+        copy = decCopy;
+    }
+    else
+        throw runtime_error("expresión no copiable en la expansión en línea");
+    copy->has_f = exp->has_f;
+    return copy;
+}
+
+void Inliner::onLeaf(Exp *exp)
+{
+    switch (phase)
+    {
+    case ANALYZE:
+        summary.size++;
+        analyzeLeaf(exp);
+        break;
+    case CLONE:
+        cloneStack.push_back(cloneLeaf(exp));
+        break;
+    case REWRITE:
+        exp->accept(this);
+        break;
+    }
+}
+
+void Inliner::onExit(Exp *exp)
+{
+    BinaryExp *bin = dynamic_cast<BinaryExp *>(exp);
+    ParenthesizedExp *paren = dynamic_cast<ParenthesizedExp *>(exp);
+    UnaryExp *unary = dynamic_cast<UnaryExp *>(exp);
+
+    if (phase == ANALYZE)
+    {
+        summary.size++;
+        if (bin)
+        {
+            summary.mayFail = summary.mayFail || mayFailDivision(bin);
+            int right = typeStack.back();
+            typeStack.pop_back();
+            typeStack.back() = binaryResultType(bin->op, typeStack.back(), right);
+        }
+        else if (unary)
+        {
+            typeStack.back() = unaryResultType(unary->op, typeStack.back());
+        }
+    }
+    else if (phase == CLONE)
+    {
+        Exp *operand = cloneStack.back();
+        cloneStack.pop_back();
+        Exp *copy;
+        if (bin)
+        {
+            copy = new BinaryExp(cloneStack.back(), operand, bin->op);
+            cloneStack.pop_back();
+        }
+        else if (paren)
+            copy = new ParenthesizedExp(operand);
+        else
+            copy = new UnaryExp(unary->op, operand);
+        copy->has_f = exp->has_f;
+        cloneStack.push_back(copy);
+    }
+    else if (bin)
+    {
+        bin->left = expand(bin->left);
+        bin->right = expand(bin->right);
+    }
+    else if (paren)
+    {
+        paren->expr = expand(paren->expr);
+    }
+    else if (unary)
+    {
+        unary->expr = expand(unary->expr);
+    }
+}
+
+int Inliner::visit(BinaryExp *exp)
+{
+    walk(exp);
+    return 0;
+}
+
+int Inliner::visit(NumberExp *exp) { return 0; }
+int Inliner::visit(DecimalExp *exp) { return 0; }
+int Inliner::visit(BoolExp *exp) { return 0; }
+int Inliner::visit(IdentifierExp *exp) { return 0; }
+int Inliner::visit(StringExp *exp) { return 0; }
+
+int Inliner::visit(RangeExp *exp)
+{
+    inlineExp(exp->start);
+    inlineExp(exp->end);
+    inlineExp(exp->step);
+    return 0;
+}
+
+int Inliner::visit(ParenthesizedExp *exp)
+{
+    walk(exp);
+    return 0;
+}
+
+int Inliner::visit(FunctionCallExp *exp)
+{
+    for (auto &arg : exp->args)
+    {
+        inlineExp(arg);
+    }
+    return 0;
+}
+
+int Inliner::visit(UnaryExp *exp)
+{
+    if (isOperatorNode(exp))
+        walk(exp);
+    return 0;
+}
+
+int Inliner::visit(RunExp *exp)
+{
+    if (exp->block)
+        exp->block->accept(this);
+    return 0;
+}
+
+void Inliner::visit(AssignStatement *stm)
+{
+    inlineExp(stm->rhs);
+}
+
+void Inliner::visit(PrintStatement *stm)
+{
+    inlineExp(stm->e);
+}
+
+void Inliner::visit(ExpressionStatement *stm)
+{
+    inlineExp(stm->expr);
+}
+
+void Inliner::visit(IfStatement *stm)
+{
+    inlineExp(stm->condition);
+    if (stm->thenStmt)
+        stm->thenStmt->accept(this);
+    if (stm->elseStmt)
+        stm->elseStmt->accept(this);
+}
+
+void Inliner::visit(WhileStatement *stm)
+{
+    inlineExp(stm->condition);
+    if (stm->stmt)
+        stm->stmt->accept(this);
+}
+
+void Inliner::visit(DoWhileStatement *stm)
+{
+    if (stm->stmt)
+        stm->stmt->accept(this);
+    inlineExp(stm->condition);
+}
+
+void Inliner::visit(ForStatement *stm)
+{
+    inlineExp(stm->range);
+    if (stm->stmt)
+        stm->stmt->accept(this);
+}
+
+void Inliner::visit(VarDec *stm)
+{
+    inlineExp(stm->value);
+}
+
+void Inliner::visit(VarDecList *stm)
+{
+    for (auto dec : stm->decls)
+    {
+        dec->accept(this);
+    }
+}
+
+void Inliner::visit(StatementList *stm)
+{
+    for (auto s : stm->stms)
+    {
+        if (s)
+            s->accept(this);
+    }
+}
+
+void Inliner::visit(Block *stm)
+{
+    if (stm->statements)
+        stm->statements->accept(this);
+}
+
+void Inliner::visit(RunBlock *stm)
+{
+    if (stm->statements)
+        stm->statements->accept(this);
+}
+
+void Inliner::visit(FunctionDecl *stm)
+{
+    if (stm->body)
+        stm->body->accept(this);
+}
+
+void Inliner::visit(ReturnStatement *stm)
+{
+    inlineExp(stm->expr);
+}
+
+void Inliner::visit(BreakStatement *stm) {}
+void Inliner::visit(ContinueStatement *stm) {}
+
+void PurityAnalyzer::analizar(Program *program)
+{
+    if (!program || !program->statements)
+        return;
+
+    unordered_map<FunctionDecl *, unordered_set<FunctionDecl *>> callGraph;
+    vector<FunctionDecl *> functions;
+    for (auto stm : program->statements->stms)
+    {
+        FunctionDecl *func = dynamic_cast<FunctionDecl *>(stm);
+        if (!func)
+            continue;
+
+        impure = false;
+        callees.clear();
+        scopes.assign(1, unordered_set<string>());
+        for (auto &param : func->params)
+        {
+            scopes.back().insert(param.first);
+        }
+        if (func->body)
+            func->body->accept(this);
+
+        func->isPure = !impure;
+        callGraph[func] = callees;
+        functions.push_back(func);
+    }
+
+    // Una función deja de ser pura si llama a una impura, hasta el punto fijo
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (auto func : functions)
+        {
+            if (!func->isPure)
+                continue;
+            for (auto callee : callGraph[func])
+            {
+                if (!callee->isPure)
+                {
+                    func->isPure = false;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void PurityAnalyzer::scan(Exp *exp)
+{
+    if (exp)
+        walk(exp);
+}
+
+void PurityAnalyzer::use(const string &name)
+{
+    for (auto it = scopes.rbegin(); it != scopes.rend(); ++it)
+    {
+        if (it->count(name))
+            return;
+    }
+    impure = true;
+}
+
+void PurityAnalyzer::onLeaf(Exp *exp)
+{
+    exp->accept(this);
+}
+
+int PurityAnalyzer::visit(BinaryExp *exp)
+{
+    walk(exp);
+    return 0;
+}
+
+int PurityAnalyzer::visit(NumberExp *exp) { return 0; }
+int PurityAnalyzer::visit(DecimalExp *exp) { return 0; }
+int PurityAnalyzer::visit(BoolExp *exp) { return 0; }
+int PurityAnalyzer::visit(StringExp *exp) { return 0; }
+
+int PurityAnalyzer::visit(IdentifierExp *exp)
+{
+    use(exp->name);
+    return 0;
+}
+
+int PurityAnalyzer::visit(RangeExp *exp)
+{
+    scan(exp->start);
+    scan(exp->end);
+    scan(exp->step);
+    return 0;
+}
+
+int PurityAnalyzer::visit(ParenthesizedExp *exp)
+{
+    walk(exp);
+    return 0;
+}
+
+int PurityAnalyzer::visit(FunctionCallExp *exp)
+{
+    if (exp->decl)
+        callees.insert(exp->decl);
+    else
+        impure = true;
+    for (auto arg : exp->args)
+    {
+        scan(arg);
+    }
+    return 0;
+}
+
+int PurityAnalyzer::visit(UnaryExp *exp)
+{
+    if (isOperatorNode(exp))
+        walk(exp);
+    else
+        scan(exp->expr);
+    return 0;
+}
+
+int PurityAnalyzer::visit(RunExp *exp)
+{
+    if (exp->block)
+        exp->block->accept(this);
+    return 0;
+}
+
+void PurityAnalyzer::visit(AssignStatement *stm)
+{
+    scan(stm->rhs);
+    use(stm->id);
+}
+
+void PurityAnalyzer::visit(PrintStatement *stm)
+{
+    impure = true;
+}
+
+void PurityAnalyzer::visit(ExpressionStatement *stm)
+{
+    scan(stm->expr);
+}
+
+void PurityAnalyzer::visit(IfStatement *stm)
+{
+    scan(stm->condition);
+    if (stm->thenStmt)
+        stm->thenStmt->accept(this);
+    if (stm->elseStmt)
+        stm->elseStmt->accept(this);
+}
+
+void PurityAnalyzer::visit(WhileStatement *stm)
+{
+    scan(stm->condition);
+    if (stm->stmt)
+        stm->stmt->accept(this);
+}
+
+void PurityAnalyzer::visit(DoWhileStatement *stm)
+{
+    if (stm->stmt)
+        stm->stmt->accept(this);
+    scan(stm->condition);
+}
+
+void PurityAnalyzer::visit(ForStatement *stm)
+{
+    scan(stm->range);
+    scopes.push_back({stm->id});
+    if (stm->stmt)
+        stm->stmt->accept(this);
+    scopes.pop_back();
+}
+
+void PurityAnalyzer::visit(VarDec *stm)
+{
+    scan(stm->value);
+    scopes.back().insert(stm->id);
+}
+
+void PurityAnalyzer::visit(VarDecList *stm)
+{
+    for (auto dec : stm->decls)
+    {
+        dec->accept(this);
+    }
+}
+
+void PurityAnalyzer::visit(StatementList *stm)
+{
+    for (auto s : stm->stms)
+    {
+        if (s)
+            s->accept(this);
+    }
+}
+
+void PurityAnalyzer::visit(Block *stm)
+{
+    scopes.push_back(unordered_set<string>());
+    if (stm->statements)
+        stm->statements->accept(this);
+    scopes.pop_back();
+}
+
+void PurityAnalyzer::visit(RunBlock *stm)
+{
+    scopes.push_back(unordered_set<string>());
+    if (stm->statements)
+        stm->statements->accept(this);
+    scopes.pop_back();
+}
+
+void PurityAnalyzer::visit(FunctionDecl *stm) {}
+
+void PurityAnalyzer::visit(ReturnStatement *stm)
+{
+    scan(stm->expr);
+}
+
+void PurityAnalyzer::visit(BreakStatement *stm) {}
+void PurityAnalyzer::visit(ContinueStatement *stm) {}
+
+void SuperinstructionFuser::fusionar(Program *program)
+{
+    if (!program || !program->statements)
+        return;
+    program->statements->accept(this);
+}
+
+void SuperinstructionFuser::scan(Exp *exp)
+{
+    if (exp)
+        walk(exp);
+}
+
+// Un RunExp anidado puede contener asignaciones que también se analizan, así
+// que se guarda la bandera del nivel de afuera.
+bool SuperinstructionFuser::hasEffects(Exp *exp)
+{
+    bool saved = effects;
+    effects = false;
+    scan(exp);
+    bool result = effects;
+    effects = saved || result;
+    return result;
+}
+
+void SuperinstructionFuser::fuseAssign(AssignStatement *stm)
+{
+    NumberExp *step = nullptr;
+    Exp *operand = nullptr;
+    bool negate = false;
+
+    switch (stm->op)
+    {
+    case AssignStatement::INCREMENT_OP:
+    case AssignStatement::POST_INCREMENT_OP:
+        stm->superOp = SUPER_INCREMENT_LOCAL;
+        stm->superStep = 1;
+        return;
+    case AssignStatement::DECREMENT_OP:
+    case AssignStatement::POST_DECREMENT_OP:
+        stm->superOp = SUPER_INCREMENT_LOCAL;
+        stm->superStep = -1;
+        return;
+    case AssignStatement::PLUS_ASSIGN_OP:
+    case AssignStatement::MINUS_ASSIGN_OP:
+        negate = stm->op == AssignStatement::MINUS_ASSIGN_OP;
+        step = dynamic_cast<NumberExp *>(stm->rhs);
+        if (!step && !negate)
+            operand = stm->rhs;
+        break;
+    case AssignStatement::ASSIGN_OP:
+    {
+        // x = x + k, x = x - k, x = x + expr
+        BinaryExp *bin = dynamic_cast<BinaryExp *>(stm->rhs);
+        IdentifierExp *self = bin ? dynamic_cast<IdentifierExp *>(bin->left) : nullptr;
+        if (!self || self->name != stm->id || (bin->op != PLUS_OP && bin->op != MINUS_OP))
+            return;
+        negate = bin->op == MINUS_OP;
+        step = dynamic_cast<NumberExp *>(bin->right);
+        if (!step && !negate)
+            operand = bin->right;
+        break;
+    }
+    default:
+        return;
+    }
+
+    if (step && !(negate && step->value == INT_MIN))
+    {
+        stm->superOp = SUPER_INCREMENT_LOCAL;
+        stm->superStep = negate ? -step->value : step->value;
+    }
+    else if (operand && !hasEffects(operand))
+    {
+        stm->superOp = SUPER_ACCUMULATE_LOCAL;
+        stm->superOperand = operand;
+    }
+}
+
+void SuperinstructionFuser::onLeaf(Exp *exp)
+{
+    exp->accept(this);
+}
+
+void SuperinstructionFuser::onExit(Exp *exp)
+{
+    if (nodeKind(exp) != BINARY_NODE)
+        return;
+    BinaryExp *bin = static_cast<BinaryExp *>(exp);
+    if (bin->op != LT_OP && bin->op != LE_OP && bin->op != GT_OP && bin->op != GE_OP &&
+        bin->op != EQ_OP && bin->op != NE_OP)
+        return;
+    if (!dynamic_cast<IdentifierExp *>(bin->left))
+        return;
+    if (dynamic_cast<IdentifierExp *>(bin->right))
+        bin->superOp = SUPER_COMPARE_LOCALS;
+    else if (dynamic_cast<NumberExp *>(bin->right))
+        bin->superOp = SUPER_COMPARE_CONST;
+}
+
+int SuperinstructionFuser::visit(BinaryExp *exp)
+{
+    walk(exp);
+    return 0;
+}
+
+int SuperinstructionFuser::visit(NumberExp *exp) { return 0; }
+int SuperinstructionFuser::visit(DecimalExp *exp) { return 0; }
+int SuperinstructionFuser::visit(BoolExp *exp) { return 0; }
+int SuperinstructionFuser::visit(IdentifierExp *exp) { return 0; }
+int SuperinstructionFuser::visit(StringExp *exp) { return 0; }
+
+int SuperinstructionFuser::visit(RangeExp *exp)
+{
+    scan(exp->start);
+    scan(exp->end);
+    scan(exp->step);
+    return 0;
+}
+
+int SuperinstructionFuser::visit(ParenthesizedExp *exp)
+{
+    walk(exp);
+    return 0;
+}
+
+int SuperinstructionFuser::visit(FunctionCallExp *exp)
+{
+    effects = true;
+    for (auto arg : exp->args)
+    {
+        scan(arg);
+    }
+    return 0;
+}
+
+int SuperinstructionFuser::visit(UnaryExp *exp)
+{
+    if (isOperatorNode(exp))
+    {
+        walk(exp);
+        return 0;
+    }
+    // ++x, x-- y compañía modifican una variable
+    effects = true;
+    scan(exp->expr);
+    return 0;
+}
+
+int SuperinstructionFuser::visit(RunExp *exp)
+{
+    effects = true;
+    if (exp->block)
+        exp->block->accept(this);
+    return 0;
+}
+
+void SuperinstructionFuser::visit(AssignStatement *stm)
+{
+    scan(stm->rhs);
+    fuseAssign(stm);
+}
+
+void SuperinstructionFuser::visit(PrintStatement *stm)
+{
+    scan(stm->e);
+}
+
+void SuperinstructionFuser::visit(ExpressionStatement *stm)
+{
+    scan(stm->expr);
+}
+
+void SuperinstructionFuser::visit(IfStatement *stm)
+{
+    scan(stm->condition);
+    if (stm->thenStmt)
+        stm->thenStmt->accept(this);
+    if (stm->elseStmt)
+        stm->elseStmt->accept(this);
+}
+
+void SuperinstructionFuser::visit(WhileStatement *stm)
+{
+    scan(stm->condition);
+    if (stm->stmt)
+        stm->stmt->accept(this);
+}
+
+void SuperinstructionFuser::visit(DoWhileStatement *stm)
+{
+    if (stm->stmt)
+        stm->stmt->accept(this);
+    scan(stm->condition);
+}
+
+void SuperinstructionFuser::visit(ForStatement *stm)
+{
+    scan(stm->range);
+    if (!stm->stmt)
+        return;
+    stm->stmt->accept(this);
+
+    Stm *body = stm->stmt;
+    if (Block *block = dynamic_cast<Block *>(body))
+    {
+        if (!block->statements || block->statements->stms.size() != 1)
+            return;
+        body = block->statements->stms.front();
+    }
+    if (dynamic_cast<RangeExp *>(stm->range))
+        stm->superBody = dynamic_cast<AssignStatement *>(body);
+}
+
+void SuperinstructionFuser::visit(VarDec *stm)
+{
+    scan(stm->value);
+}
+
+void SuperinstructionFuser::visit(VarDecList *stm)
+{
+    for (auto dec : stm->decls)
+    {
+        dec->accept(this);
+    }
+}
+
+void SuperinstructionFuser::visit(StatementList *stm)
+{
+    for (auto s : stm->stms)
+    {
+        if (s)
+            s->accept(this);
+    }
+}
+
+void SuperinstructionFuser::visit(Block *stm)
+{
+    if (stm->statements)
+        stm->statements->accept(this);
+}
+
+void SuperinstructionFuser::visit(RunBlock *stm)
+{
+    if (stm->statements)
+        stm->statements->accept(this);
+}
+
+void SuperinstructionFuser::visit(FunctionDecl *stm)
+{
+    if (stm->body)
+        stm->body->accept(this);
+}
+
+void SuperinstructionFuser::visit(ReturnStatement *stm)
+{
+    scan(stm->expr);
+}
+
+void SuperinstructionFuser::visit(BreakStatement *stm) {}
+void SuperinstructionFuser::visit(ContinueStatement *stm) {}
@@ -0,0 +1,338 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "exp.h"
+#include "visitor.h"
+
+// Plegado de constantes sobre el AST. Usa las mismas reglas de evaluacion que
+// EvalVisitor (evalBinaryOp/evalUnaryOp), asi el programa plegado produce la
+// misma salida en el interprete. Las expresiones se recorren con pila
+// explicita (ExpWalker).
+class ConstantFolder : public Visitor, private ExpWalker
+{
+private:
+    void foldExp(Exp *&exp);
+    Exp *reduce(Exp *exp);
+    void onLeaf(Exp *exp) override;
+    void onExit(Exp *exp) override;
+
+public:
+    void optimizar(Program *program);
+    int visit(BinaryExp *exp) override;
+    int visit(NumberExp *exp) override;
+    int visit(DecimalExp *exp) override;
+    int visit(BoolExp *exp) override;
+    int visit(IdentifierExp *exp) override;
+    int visit(RangeExp *exp) override;
+    int visit(StringExp *exp) override;
+    int visit(ParenthesizedExp *exp) override;
+    int visit(FunctionCallExp *exp) override;
+    int visit(UnaryExp *exp) override;
+    int visit(RunExp *exp) override;
+    void visit(AssignStatement *stm) override;
+    void visit(PrintStatement *stm) override;
+    void visit(ExpressionStatement *stm) override;
+    void visit(IfStatement *stm) override;
+    void visit(WhileStatement *stm) override;
+    void visit(DoWhileStatement *stm) override;
+    void visit(ForStatement *stm) override;
+    void visit(VarDec *stm) override;
+    void visit(VarDecList *stm) override;
+    void visit(StatementList *stm) override;
+    void visit(Block *stm) override;
+    void visit(RunBlock *stm) override;
+    void visit(FunctionDecl *stm) override;
+    void visit(ReturnStatement *stm) override;
+    void visit(BreakStatement *stm) override;
+    void visit(ContinueStatement *stm) override;
+};
+
+// Enlaza cada FunctionCallExp con su FunctionDecl y verifica aridad y tipos
+// de los argumentos una sola vez, antes de ejecutar o generar codigo. En una
+// funcion tailrec exige que las llamadas recursivas esten en un return. Los
+// errores se informan todos juntos y luego se lanza una excepcion. No asigna
+// ranuras a los parametros: EvalVisitor los declara por nombre.
+class CallResolver : public Visitor, private ExpWalker
+{
+private:
+    std::unordered_map<string, FunctionDecl *> functions;
+    std::vector<std::unordered_map<string, int>> scopes;
+    std::vector<int> typeStack;
+    FunctionDecl *currentFunction = nullptr;
+    FunctionCallExp *tailCall = nullptr;
+    int errors = 0;
+
+    int typeOf(Exp *exp);
+    int lookupVariable(const string &name);
+    void declare(const string &name, int type);
+    void onLeaf(Exp *exp) override;
+    void onExit(Exp *exp) override;
+
+public:
+    void resolver(Program *program);
+    int visit(BinaryExp *exp) override;
+    int visit(NumberExp *exp) override;
+    int visit(DecimalExp *exp) override;
+    int visit(BoolExp *exp) override;
+    int visit(IdentifierExp *exp) override;
+    int visit(RangeExp *exp) override;
+    int visit(StringExp *exp) override;
+    int visit(ParenthesizedExp *exp) override;
+    int visit(FunctionCallExp *exp) override;
+    int visit(UnaryExp *exp) override;
+    int visit(RunExp *exp) override;
+    void visit(AssignStatement *stm) override;
+    void visit(PrintStatement *stm) override;
+    void visit(ExpressionStatement *stm) override;
+    void visit(IfStatement *stm) override;
+    void visit(WhileStatement *stm) override;
+    void visit(DoWhileStatement *stm) override;
+    void visit(ForStatement *stm) override;
+    void visit(VarDec *stm) override;
+    void visit(VarDecList *stm) override;
+    void visit(StatementList *stm) override;
+    void visit(Block *stm) override;
+    void visit(RunBlock *stm) override;
+    void visit(FunctionDecl *stm) override;
+    void visit(ReturnStatement *stm) override;
+    void visit(BreakStatement *stm) override;
+    void visit(ContinueStatement *stm) override;
+};
+
+// Eliminacion de codigo muerto, despues del plegado de constantes: quita las
+// sentencias que siguen a return/break/continue, los if/while con condicion
+// constante, los `val` que nadie lee y cuyo inicializador no tiene efectos,
+// y las funciones que no se alcanzan desde main.
+class DeadCodeEliminator : public Visitor, private ExpWalker
+{
+private:
+    enum Phase
+    {
+        PRUNE,
+        COLLECT,
+        SWEEP
+    };
+    Phase phase = PRUNE;
+    std::unordered_map<string, int> uses;
+    std::unordered_set<string> calls;
+    bool impure = false;
+    int removed = 0;
+
+    void scan(Exp *exp);
+    bool isPure(Exp *exp);
+    void pruneUnreachable(StatementList *list);
+    void sweepUnusedVals(StatementList *list);
+    void removeUnreachableFunctions(Program *program);
+    void onLeaf(Exp *exp) override;
+    void onExit(Exp *exp) override;
+
+public:
+    void eliminar(Program *program);
+    int visit(BinaryExp *exp) override;
+    int visit(NumberExp *exp) override;
+    int visit(DecimalExp *exp) override;
+    int visit(BoolExp *exp) override;
+    int visit(IdentifierExp *exp) override;
+    int visit(RangeExp *exp) override;
+    int visit(StringExp *exp) override;
+    int visit(ParenthesizedExp *exp) override;
+    int visit(FunctionCallExp *exp) override;
+    int visit(UnaryExp *exp) override;
+    int visit(RunExp *exp) override;
+    void visit(AssignStatement *stm) override;
+    void visit(PrintStatement *stm) override;
+    void visit(ExpressionStatement *stm) override;
+    void visit(IfStatement *stm) override;
+    void visit(WhileStatement *stm) override;
+    void visit(DoWhileStatement *stm) override;
+    void visit(ForStatement *stm) override;
+    void visit(VarDec *stm) override;
+    void visit(VarDecList *stm) override;
+    void visit(StatementList *stm) override;
+    void visit(Block *stm) override;
+    void visit(RunBlock *stm) override;
+    void visit(FunctionDecl *stm) override;
+    void visit(ReturnStatement *stm) override;
+    void visit(BreakStatement *stm) override;
+    void visit(ContinueStatement *stm) override;
+};
+
+// Expansion en linea de funciones pequenas de la forma `return <expr>` que
+// solo usan sus parametros y no llaman a otras funciones. La llamada se
+// reemplaza por una copia de la expresion con cada parametro sustituido por
+// su argumento. Los tipos de los argumentos deben coincidir exactamente, y un
+// argumento compuesto debe ser puro y usarse a lo sumo una vez, para no
+// duplicar trabajo ni efectos.
+class Inliner : public Visitor, private ExpWalker
+{
+private:
+    enum Phase
+    {
+        ANALYZE,
+        CLONE,
+        REWRITE
+    };
+    struct Summary
+    {
+        int type;
+        int size;
+        bool hasCall;
+        bool hasEffect;
+        bool mayFail;
+        bool foreign;
+    };
+    struct Candidate
+    {
+        Exp *body;
+        std::unordered_map<string, int> paramUses;
+    };
+    static const int BUDGET = 20;
+
+    Phase phase = REWRITE;
+    std::unordered_map<FunctionDecl *, Candidate> candidates;
+    std::unordered_map<string, int> paramTypes;
+    std::unordered_map<string, int> paramUses;
+    std::unordered_map<string, Exp *> substitutions;
+    std::vector<int> typeStack;
+    std::vector<Exp *> cloneStack;
+    Summary summary;
+
+    Summary analyze(Exp *exp);
+    Exp *clone(Exp *exp);
+    Exp *expand(Exp *exp);
+    void inlineExp(Exp *&exp);
+    void analyzeLeaf(Exp *exp);
+    Exp *cloneLeaf(Exp *exp);
+    void onLeaf(Exp *exp) override;
+    void onExit(Exp *exp) override;
+
+public:
+    void expandir(Program *program);
+    int visit(BinaryExp *exp) override;
+    int visit(NumberExp *exp) override;
+    int visit(DecimalExp *exp) override;
+    int visit(BoolExp *exp) override;
+    int visit(IdentifierExp *exp) override;
+    int visit(RangeExp *exp) override;
+    int visit(StringExp *exp) override;
+    int visit(ParenthesizedExp *exp) override;
+    int visit(FunctionCallExp *exp) override;
+    int visit(UnaryExp *exp) override;
+    int visit(RunExp *exp) override;
+    void visit(AssignStatement *stm) override;
+    void visit(PrintStatement *stm) override;
+    void visit(ExpressionStatement *stm) override;
+    void visit(IfStatement *stm) override;
+    void visit(WhileStatement *stm) override;
+    void visit(DoWhileStatement *stm) override;
+    void visit(ForStatement *stm) override;
+    void visit(VarDec *stm) override;
+    void visit(VarDecList *stm) override;
+    void visit(StatementList *stm) override;
+    void visit(Block *stm) override;
+    void visit(RunBlock *stm) override;
+    void visit(FunctionDecl *stm) override;
+    void visit(ReturnStatement *stm) override;
+    void visit(BreakStatement *stm) override;
+    void visit(ContinueStatement *stm) override;
+};
+
+// Marca como puras (FunctionDecl::isPure) las funciones cuyo resultado solo
+// depende de sus argumentos: no imprimen, solo leen y escriben parametros o
+// variables locales (con alcance dinamico cualquier otro nombre puede ser del
+// llamador) y solo llaman a funciones puras. El interprete las memoiza.
+class PurityAnalyzer : public Visitor, private ExpWalker
+{
+private:
+    std::vector<std::unordered_set<string>> scopes;
+    std::unordered_set<FunctionDecl *> callees;
+    bool impure = false;
+
+    void scan(Exp *exp);
+    void use(const string &name);
+    void onLeaf(Exp *exp) override;
+    void onExit(Exp *exp) override {}
+
+public:
+    void analizar(Program *program);
+    int visit(BinaryExp *exp) override;
+    int visit(NumberExp *exp) override;
+    int visit(DecimalExp *exp) override;
+    int visit(BoolExp *exp) override;
+    int visit(IdentifierExp *exp) override;
+    int visit(RangeExp *exp) override;
+    int visit(StringExp *exp) override;
+    int visit(ParenthesizedExp *exp) override;
+    int visit(FunctionCallExp *exp) override;
+    int visit(UnaryExp *exp) override;
+    int visit(RunExp *exp) override;
+    void visit(AssignStatement *stm) override;
+    void visit(PrintStatement *stm) override;
+    void visit(ExpressionStatement *stm) override;
+    void visit(IfStatement *stm) override;
+    void visit(WhileStatement *stm) override;
+    void visit(DoWhileStatement *stm) override;
+    void visit(ForStatement *stm) override;
+    void visit(VarDec *stm) override;
+    void visit(VarDecList *stm) override;
+    void visit(StatementList *stm) override;
+    void visit(Block *stm) override;
+    void visit(RunBlock *stm) override;
+    void visit(FunctionDecl *stm) override;
+    void visit(ReturnStatement *stm) override;
+    void visit(BreakStatement *stm) override;
+    void visit(ContinueStatement *stm) override;
+};
+
+// Reconoce los patrones de bucle más frecuentes y los marca como
+// superinstrucciones (SuperOp) para el intérprete: comparar una variable con
+// otra o con una constante, incrementarla en una constante, acumular en ella
+// una expresión sin efectos, y el for cuyo cuerpo es una sola asignación.
+// Solo anota nodos; si en ejecución los tipos no son los esperados, el
+// intérprete usa el camino normal.
+class SuperinstructionFuser : public Visitor, private ExpWalker
+{
+private:
+    bool effects = false;
+
+    void scan(Exp *exp);
+    bool hasEffects(Exp *exp);
+    void fuseAssign(AssignStatement *stm);
+    void onLeaf(Exp *exp) override;
+    void onExit(Exp *exp) override;
+
+public:
+    void fusionar(Program *program);
+    int visit(BinaryExp *exp) override;
+    int visit(NumberExp *exp) override;
+    int visit(DecimalExp *exp) override;
+    int visit(BoolExp *exp) override;
+    int visit(IdentifierExp *exp) override;
+    int visit(RangeExp *exp) override;
+    int visit(StringExp *exp) override;
+    int visit(ParenthesizedExp *exp) override;
+    int visit(FunctionCallExp *exp) override;
+    int visit(UnaryExp *exp) override;
+    int visit(RunExp *exp) override;
+    void visit(AssignStatement *stm) override;
+    void visit(PrintStatement *stm) override;
+    void visit(ExpressionStatement *stm) override;
+    void visit(IfStatement *stm) override;
+    void visit(WhileStatement *stm) override;
+    void visit(DoWhileStatement *stm) override;
+    void visit(ForStatement *stm) override;
+    void visit(VarDec *stm) override;
+    void visit(VarDecList *stm) override;
+    void visit(StatementList *stm) override;
+    void visit(Block *stm) override;
+    void visit(RunBlock *stm) override;
+    void visit(FunctionDecl *stm) override;
+    void visit(ReturnStatement *stm) override;
+    void visit(BreakStatement *stm) override;
+    void visit(ContinueStatement *stm) override;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,332 @@
+#include "output.h"
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#define isatty _isatty
+#define fileno _fileno
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+ProgramOutput salidaPrograma;
+
+ProgramOutput::ProgramOutput() : lineas(isatty(fileno(stdout)) != 0) {}
+
+ProgramOutput::~ProgramOutput()
+{
+    vaciar();
+}
+
+void ProgramOutput::vaciar()
+{
+    if (used)
+        fwrite(buffer, 1, used, stdout);
+    used = 0;
+    fflush(stdout);
+}
+
+void ProgramOutput::escribir(const char *texto, size_t longitud)
+{
+    if (used + longitud > SIZE)
+    {
+        vaciar();
+        if (longitud > SIZE)
+        {
+            fwrite(texto, 1, longitud, stdout);
+            return;
+        }
+    }
+    memcpy(buffer + used, texto, longitud);
+    used += longitud;
+}
+
+void ProgramOutput::escribirEntero(long valor)
+{
+    char digits[24];
+    escribir(digits, to_chars(digits, digits + sizeof(digits), valor).ptr - digits);
+}
+
+void ProgramOutput::escribirFlotante(float valor)
+{
+    char digits[32];
+    escribir(digits, formatFloatTo(digits, valor) - digits);
+}
+
+void ProgramOutput::escribirBooleano(bool valor)
+{
+    if (valor)
+        escribir("true", 4);
+    else
+        escribir("false", 5);
+}
+
+void ProgramOutput::saltoDeLinea()
+{
+    escribir("\n", 1);
+    if (lineas)
+        vaciar();
+}
+
+// Tablas de Ryu (Ulf Adams) para Float: 2^k / 5^q redondeado hacia arriba
+// con 59 bits de precisión y 5^i / 2^k truncado a 61 bits
+const uint64_t RYU_POW5_INV_SPLIT[31] = {
+    576460752303423489u, 461168601842738791u, 368934881474191033u,
+    295147905179352826u, 472236648286964522u, 377789318629571618u,
+    302231454903657294u, 483570327845851670u, 386856262276681336u,
+    309485009821345069u, 495176015714152110u, 396140812571321688u,
+    316912650057057351u, 507060240091291761u, 405648192073033409u,
+    324518553658426727u, 519229685853482763u, 415383748682786211u,
+    332306998946228969u, 531691198313966350u, 425352958651173080u,
+    340282366920938464u, 544451787073501542u, 435561429658801234u,
+    348449143727040987u, 557518629963265579u, 446014903970612463u,
+    356811923176489971u, 570899077082383953u, 456719261665907162u,
+    365375409332725730u};
+
+const uint64_t RYU_POW5_SPLIT[48] = {
+    1152921504606846976u, 1441151880758558720u, 1801439850948198400u,
+    2251799813685248000u, 1407374883553280000u, 1759218604441600000u,
+    2199023255552000000u, 1374389534720000000u, 1717986918400000000u,
+    2147483648000000000u, 1342177280000000000u, 1677721600000000000u,
+    2097152000000000000u, 1310720000000000000u, 1638400000000000000u,
+    2048000000000000000u, 1280000000000000000u, 1600000000000000000u,
+    2000000000000000000u, 1250000000000000000u, 1562500000000000000u,
+    1953125000000000000u, 1220703125000000000u, 1525878906250000000u,
+    1907348632812500000u, 1192092895507812500u, 1490116119384765625u,
+    1862645149230957031u, 1164153218269348144u, 1455191522836685180u,
+    1818989403545856475u, 2273736754432320594u, 1421085471520200371u,
+    1776356839400250464u, 2220446049250313080u, 1387778780781445675u,
+    1734723475976807094u, 2168404344971008868u, 1355252715606880542u,
+    1694065894508600678u, 2117582368135750847u, 1323488980084844279u,
+    1654361225106055349u, 2067951531382569187u, 1292469707114105741u,
+    1615587133892632177u, 2019483917365790221u, 1262177448353618888u};
+
+static int pow5Bits(int e)
+{
+    return (int)(((uint32_t)e * 1217359) >> 19) + 1;
+}
+
+static bool multipleOfPow5(uint32_t value, uint32_t p)
+{
+    uint32_t count = 0;
+    for (; value % 5 == 0; value /= 5)
+        count++;
+    return count >= p;
+}
+
+static uint32_t mulShift(uint32_t m, uint64_t factor, int shift)
+{
+    uint64_t low = (uint64_t)m * (uint32_t)factor;
+    uint64_t high = (uint64_t)m * (uint32_t)(factor >> 32);
+    return (uint32_t)(((low >> 32) + high) >> (shift - 32));
+}
+
+// Decimal más corto que redondea otra vez al mismo Float (Ryu, f2s), como
+// dígitos y exponente en base 10. Si queda de un solo dígito se prefiere el
+// de dos dígitos más cercano, que es lo que hace Float.toString desde Java 19
+// (1.4E-45 y no 1.0E-45).
+static uint32_t shortestDecimal(uint32_t ieeeMantissa, uint32_t ieeeExponent, int &exponent)
+{
+    int e2;
+    uint32_t m2;
+    if (ieeeExponent == 0)
+    {
+        e2 = 1 - 127 - 23 - 2;
+        m2 = ieeeMantissa;
+    }
+    else
+    {
+        e2 = (int)ieeeExponent - 127 - 23 - 2;
+        m2 = (1u << 23) | ieeeMantissa;
+    }
+    bool acceptBounds = (m2 & 1) == 0;
+
+    uint32_t mv = 4 * m2;
+    uint32_t mp = 4 * m2 + 2;
+    uint32_t mmShift = ieeeMantissa != 0 || ieeeExponent <= 1;
+    uint32_t mm = 4 * m2 - 1 - mmShift;
+
+    uint32_t vr, vp, vm;
+    int e10;
+    bool vmIsTrailingZeros = false, vrIsTrailingZeros = false;
+    uint32_t lastRemovedDigit = 0;
+    if (e2 >= 0)
+    {
+        uint32_t q = ((uint32_t)e2 * 78913) >> 18;
+        e10 = (int)q;
+        int k = 59 + pow5Bits((int)q) - 1;
+        int i = -e2 + (int)q + k;
+        vr = mulShift(mv, RYU_POW5_INV_SPLIT[q], i);
+        vp = mulShift(mp, RYU_POW5_INV_SPLIT[q], i);
+        vm = mulShift(mm, RYU_POW5_INV_SPLIT[q], i);
+        if (q != 0 && (vp - 1) / 10 <= vm / 10)
+        {
+            int l = 59 + pow5Bits((int)q - 1) - 1;
+            lastRemovedDigit = mulShift(mv, RYU_POW5_INV_SPLIT[q - 1], -e2 + (int)q - 1 + l) % 10;
+        }
+        if (q <= 9)
+        {
+            if (mv % 5 == 0)
+                vrIsTrailingZeros = multipleOfPow5(mv, q);
+            else if (acceptBounds)
+                vmIsTrailingZeros = multipleOfPow5(mm, q);
+            else
+                vp -= multipleOfPow5(mp, q);
+        }
+    }
+    else
+    {
+        uint32_t q = ((uint32_t)-e2 * 732923) >> 20;
+        e10 = (int)q + e2;
+        int i = -e2 - (int)q;
+        int k = pow5Bits(i) - 61;
+        int j = (int)q - k;
+        vr = mulShift(mv, RYU_POW5_SPLIT[i], j);
+        vp = mulShift(mp, RYU_POW5_SPLIT[i], j);
+        vm = mulShift(mm, RYU_POW5_SPLIT[i], j);
+        if (q != 0 && (vp - 1) / 10 <= vm / 10)
+        {
+            j = (int)q - 1 - (pow5Bits(i + 1) - 61);
+            lastRemovedDigit = mulShift(mv, RYU_POW5_SPLIT[i + 1], j) % 10;
+        }
+        if (q <= 1)
+        {
+            vrIsTrailingZeros = true;
+            if (acceptBounds)
+                vmIsTrailingZeros = mmShift == 1;
+            else
+                vp--;
+        }
+        else if (q < 31)
+        {
+            vrIsTrailingZeros = (mv & ((1u << (q - 1)) - 1)) == 0;
+        }
+    }
+
+    // Se quitan dígitos mientras el intervalo siga conteniendo un decimal más
+    // corto; el estado con dos dígitos en vr sirve para la regla de Java
+    int removed = 0, twoRemoved = -1;
+    uint32_t twoVr = 0, twoVp = 0, twoVm = 0, twoDigit = 0;
+    bool twoVrZeros = false, twoVmZeros = false;
+    while (vp / 10 > vm / 10 || (vmIsTrailingZeros && vm % 10 == 0))
+    {
+        if (vr >= 10 && vr < 100)
+        {
+            twoRemoved = removed;
+            twoVr = vr;
+            twoVp = vp;
+            twoVm = vm;
+            twoDigit = lastRemovedDigit;
+            twoVrZeros = vrIsTrailingZeros;
+            twoVmZeros = vmIsTrailingZeros;
+        }
+        vmIsTrailingZeros &= vm % 10 == 0;
+        vrIsTrailingZeros &= lastRemovedDigit == 0;
+        lastRemovedDigit = vr % 10;
+        vr /= 10;
+        vp /= 10;
+        vm /= 10;
+        removed++;
+    }
+    if (vrIsTrailingZeros && lastRemovedDigit == 5 && vr % 2 == 0)
+        lastRemovedDigit = 4;
+    uint32_t output = vr + ((vr == vm && (!acceptBounds || !vmIsTrailingZeros)) || lastRemovedDigit >= 5);
+
+    if (vr < 10 && twoRemoved >= 0)
+    {
+        if (twoVrZeros && twoDigit == 5 && twoVr % 2 == 0)
+            twoDigit = 4;
+        uint32_t closest = twoVr + (twoDigit >= 5);
+        bool inside = closest <= twoVp && (closest > twoVm || (closest == twoVm && acceptBounds && twoVmZeros));
+        if (!inside)
+            closest = closest == twoVr ? twoVr + 1 : twoVr;
+        output = closest;
+        removed = twoRemoved;
+    }
+    exponent = e10 + removed;
+    return output;
+}
+
+// Float.toString de Kotlin (y de Java): el decimal más corto, en notación
+// normal entre 10^-3 y 10^7 y si no con exponente ("1.0E10")
+char *formatFloatTo(char *first, float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint32_t ieeeMantissa = bits & 0x7fffff;
+    uint32_t ieeeExponent = bits >> 23 & 0xff;
+    if (ieeeExponent == 0xff && ieeeMantissa != 0)
+    {
+        memcpy(first, "NaN", 3);
+        return first + 3;
+    }
+    char *p = first;
+    if (bits >> 31)
+        *p++ = '-';
+    if (ieeeExponent == 0xff)
+    {
+        memcpy(p, "Infinity", 8);
+        return p + 8;
+    }
+    if (ieeeExponent == 0 && ieeeMantissa == 0)
+    {
+        memcpy(p, "0.0", 3);
+        return p + 3;
+    }
+
+    int exponent;
+    uint32_t output = shortestDecimal(ieeeMantissa, ieeeExponent, exponent);
+    for (; output % 10 == 0; output /= 10)
+        exponent++;
+    char digits[10];
+    int length = 0;
+    for (; output; output /= 10)
+        digits[9 - length++] = (char)('0' + output % 10);
+    const char *text = digits + 10 - length;
+
+    // El valor es 0.<dígitos> x 10^point
+    int point = exponent + length;
+    if (point > -3 && point <= 7)
+    {
+        if (point <= 0)
+        {
+            *p++ = '0';
+            *p++ = '.';
+            for (int i = point; i < 0; i++)
+                *p++ = '0';
+            memcpy(p, text, length);
+            return p + length;
+        }
+        if (point >= length)
+        {
+            memcpy(p, text, length);
+            p += length;
+            for (int i = length; i < point; i++)
+                *p++ = '0';
+            memcpy(p, ".0", 2);
+            return p + 2;
+        }
+        memcpy(p, text, point);
+        p += point;
+        *p++ = '.';
+        memcpy(p, text + point, length - point);
+        return p + length - point;
+    }
+
+    *p++ = text[0];
+    *p++ = '.';
+    if (length > 1)
+    {
+        memcpy(p, text + 1, length - 1);
+        p += length - 1;
+    }
+    else
+        *p++ = '0';
+    *p++ = 'E';
+    return to_chars(p, p + 4, point - 1).ptr;
+}
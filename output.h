@@ -0,0 +1,44 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Salida de los programas que ejecutan EvalVisitor, el motor enhebrado y el
+// de clausuras. Se acumula en un buffer y se vuelca con fwrite sobre stdout
+// cuando se llena, en vaciar() y al terminar el proceso; si stdout es una
+// terminal también en cada salto de línea. Los motores vacían antes de que
+// el driver vuelva a escribir con cout.
+class ProgramOutput
+{
+    static const size_t SIZE = 1 << 16;
+    char buffer[SIZE];
+    size_t used = 0;
+    bool lineas;
+
+public:
+    ProgramOutput();
+    ~ProgramOutput();
+    void escribir(const char *texto, size_t longitud);
+    void escribir(const std::string &texto) { escribir(texto.data(), texto.size()); }
+    void escribirEntero(long valor);
+    void escribirFlotante(float valor);
+    void escribirBooleano(bool valor);
+    void saltoDeLinea();
+    void vaciar();
+    void porLineas(bool activar) { lineas = activar; }
+};
+
+extern ProgramOutput salidaPrograma;
+
+// Lo mismo que formatFloat, escrito en first sin reservar memoria; hacen
+// falta 32 caracteres. Devuelve el final del texto.
+char *formatFloatTo(char *first, float value);
+
+// Tablas de potencias de 5 de formatFloatTo; GenCodeVisitor las copia al
+// runtime de salida para formatear igual en el código compilado
+extern const uint64_t RYU_POW5_INV_SPLIT[31];
+extern const uint64_t RYU_POW5_SPLIT[48];
+
+#endif
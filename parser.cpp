@@ -1,6 +1,7 @@
 #include <iostream>
 #include <stdexcept>
 #include <cstdlib>
+#include <vector>
 #include "token.h"
 #include "scanner.h"
 #include "exp.h"
@@ -246,7 +247,7 @@ Stm *Parser::parseStatement()
         return parseVarDeclaration();
     }
 
-    else if (check(Token::FUN))
+    else if (check(Token::FUN) || check(Token::TAILREC))
     {
         return parseFunDeclaration();
     }
@@ -469,153 +470,173 @@ Stm *Parser::parseContinueStatement()
     return new ContinueStatement();
 }
 
-Exp *Parser::parseExpression()
-{
-    return parseOrExp();
-}
-
-Exp *Parser::parseOrExp()
-{
-    Exp *expr = parseAndExp();
-
-    while (match(Token::OR))
-    {
-        Exp *right = parseAndExp();
-        expr = new BinaryExp(expr, right, OR_OP);
-    }
-
-    return expr;
-}
-
-Exp *Parser::parseAndExp()
-{
-    Exp *expr = parseEqExp();
-
-    while (match(Token::AND))
-    {
-        Exp *right = parseEqExp();
-        expr = new BinaryExp(expr, right, AND_OP);
-    }
-
-    return expr;
-}
-
-Exp *Parser::parseEqExp()
-{
-    Exp *expr = parseRelExp();
-
-    while (check(Token::EQ) || check(Token::NE))
-    {
-        BinaryOp op = match(Token::EQ) ? EQ_OP : NE_OP;
-        if (op == NE_OP)
-            advance();
-        Exp *right = parseRelExp();
-        expr = new BinaryExp(expr, right, op);
-    }
+// Niveles de precedencia de la gramatica: || && (== !=) (< <= > >=) (+ -) (* / %).
+// Los operadores prefijos ligan mas fuerte que cualquier binario.
+static const int PREFIX_PRECEDENCE = 7;
 
-    return expr;
-}
-
-Exp *Parser::parseRelExp()
+bool Parser::matchBinaryOperator(BinaryOp &op, int &precedence)
 {
-    Exp *expr = parseAddExp();
-
-    while (check(Token::LT) || check(Token::LE) || check(Token::GT) || check(Token::GE))
+    static const struct
     {
+        Token::Type token;
         BinaryOp op;
-        if (match(Token::LT))
-            op = LT_OP;
-        else if (match(Token::LE))
-            op = LE_OP;
-        else if (match(Token::GT))
-            op = GT_OP;
-        else if (match(Token::GE))
-            op = GE_OP;
-
-        Exp *right = parseAddExp();
-        expr = new BinaryExp(expr, right, op);
+        int precedence;
+    } table[] = {
+        {Token::OR, OR_OP, 1},
+        {Token::AND, AND_OP, 2},
+        {Token::EQ, EQ_OP, 3},
+        {Token::NE, NE_OP, 3},
+        {Token::LT, LT_OP, 4},
+        {Token::LE, LE_OP, 4},
+        {Token::GT, GT_OP, 4},
+        {Token::GE, GE_OP, 4},
+        {Token::PLUS, PLUS_OP, 5},
+        {Token::MINUS, MINUS_OP, 5},
+        {Token::MUL, MUL_OP, 6},
+        {Token::DIV, DIV_OP, 6},
+        {Token::MOD, MOD_OP, 6},
+    };
+
+    for (const auto &entry : table)
+    {
+        if (match(entry.token))
+        {
+            op = entry.op;
+            precedence = entry.precedence;
+            return true;
+        }
     }
-
-    return expr;
+    return false;
 }
 
-Exp *Parser::parseAddExp()
+bool Parser::matchPrefixOperator(UnaryExp::UnaryOp &op)
 {
-    Exp *expr = parseMulExp();
-
-    while (check(Token::PLUS) || check(Token::MINUS))
-    {
-        BinaryOp op = match(Token::PLUS) ? PLUS_OP : MINUS_OP;
-        if (op == MINUS_OP)
-            advance();
-        Exp *right = parseMulExp();
-        expr = new BinaryExp(expr, right, op);
-    }
-
-    return expr;
+    if (match(Token::NOT))
+        op = UnaryExp::NOT_OP;
+    else if (match(Token::MINUS))
+        op = UnaryExp::NEG_OP;
+    else if (match(Token::PLUS))
+        op = UnaryExp::POS_OP;
+    else if (match(Token::INCREMENT))
+        op = UnaryExp::PRE_INC_OP;
+    else if (match(Token::DECREMENT))
+        op = UnaryExp::PRE_DEC_OP;
+    else
+        return false;
+    return true;
 }
 
-Exp *Parser::parseMulExp()
+// Analisis por precedencia de operadores con pilas explicitas de operandos y
+// operadores: las cadenas largas de operadores binarios, los prefijos y los
+// parentesis anidados no consumen pila nativa.
+Exp *Parser::parseExpression()
 {
-    Exp *expr = parseUnExp();
-
-    while (check(Token::MUL) || check(Token::DIV) || check(Token::MOD))
-    {
-        BinaryOp op;
-        if (match(Token::MUL))
-            op = MUL_OP;
-        else if (match(Token::DIV))
-            op = DIV_OP;
-        else if (match(Token::MOD))
-            op = MOD_OP;
-
-        Exp *right = parseUnExp();
-        expr = new BinaryExp(expr, right, op);
-    }
-
-    return expr;
-}
+    enum PendingKind
+    {
+        PENDING_PAREN,
+        PENDING_PREFIX,
+        PENDING_BINARY
+    };
+    struct PendingOp
+    {
+        PendingKind kind;
+        int precedence;
+        BinaryOp binaryOp;
+        UnaryExp::UnaryOp unaryOp;
+    };
+
+    vector<Exp *> operands;
+    vector<PendingOp> operators;
+    int openParens = 0;
+
+    auto reduce = [&]()
+    {
+        PendingOp pending = operators.back();
+        operators.pop_back();
+        Exp *right = operands.back();
+        operands.pop_back();
+        if (pending.kind == PENDING_PREFIX)
+        {
+            operands.push_back(new UnaryExp(pending.unaryOp, right));
+        }
+        else
+        {
+            Exp *left = operands.back();
+            operands.back() = new BinaryExp(left, right, pending.binaryOp);
+        }
+    };
 
-Exp *Parser::parseUnExp()
-{
-    if (check(Token::NOT) || check(Token::MINUS) || check(Token::PLUS) || check(Token::INCREMENT) || check(Token::DECREMENT))
+    while (true)
     {
-        UnaryExp::UnaryOp op;
-        if (match(Token::NOT))
-            op = UnaryExp::NOT_OP;
-        else if (match(Token::MINUS))
-            op = UnaryExp::NEG_OP;
-        else if (match(Token::PLUS))
-            op = UnaryExp::POS_OP;
-        else if (match(Token::INCREMENT))
-            op = UnaryExp::PRE_INC_OP;
-        else if (match(Token::DECREMENT))
-            op = UnaryExp::PRE_DEC_OP;
-
-        Exp *expr = parseUnExp();
-        return new UnaryExp(op, expr);
-    }
+        UnaryExp::UnaryOp prefixOp;
+        while (true)
+        {
+            if (matchPrefixOperator(prefixOp))
+            {
+                operators.push_back({PENDING_PREFIX, PREFIX_PRECEDENCE, PLUS_OP, prefixOp});
+            }
+            else if (match(Token::LEFT_PAREN))
+            {
+                operators.push_back({PENDING_PAREN, 0, PLUS_OP, UnaryExp::POS_OP});
+                openParens++;
+            }
+            else
+            {
+                break;
+            }
+        }
 
-    return parsePostExp();
-}
+        operands.push_back(parsePrimary());
+        if ((check(Token::INCREMENT) || check(Token::DECREMENT)) &&
+            dynamic_cast<IdentifierExp *>(operands.back()) != nullptr)
+        {
+            UnaryExp::UnaryOp op = UnaryExp::POST_INC_OP;
+            if (match(Token::INCREMENT))
+                op = UnaryExp::POST_INC_OP;
+            else if (match(Token::DECREMENT))
+                op = UnaryExp::POST_DEC_OP;
+            operands.back() = new UnaryExp(op, operands.back());
+        }
 
-Exp *Parser::parsePostExp()
-{
-    Exp *expr = parsePrimary();
+        while (true)
+        {
+            BinaryOp op;
+            int precedence;
+            if (matchBinaryOperator(op, precedence))
+            {
+                while (!operators.empty() && operators.back().kind != PENDING_PAREN &&
+                       operators.back().precedence >= precedence)
+                {
+                    reduce();
+                }
+                operators.push_back({PENDING_BINARY, precedence, op, UnaryExp::POS_OP});
+                break;
+            }
 
-    while ((check(Token::INCREMENT) || check(Token::DECREMENT)) &&
-           dynamic_cast<IdentifierExp *>(expr) != nullptr)
-    {
-        UnaryExp::UnaryOp op;
-        if (match(Token::INCREMENT))
-            op = UnaryExp::POST_INC_OP;
-        else if (match(Token::DECREMENT))
-            op = UnaryExp::POST_DEC_OP;
+            if (openParens > 0 && match(Token::RIGHT_PAREN))
+            {
+                while (operators.back().kind != PENDING_PAREN)
+                {
+                    reduce();
+                }
+                operators.pop_back();
+                openParens--;
+                operands.back() = new ParenthesizedExp(operands.back());
+                continue;
+            }
 
-        expr = new UnaryExp(op, expr);
+            if (openParens > 0)
+            {
+                cout << "Error: se esperaba ')' después de la expresión." << endl;
+                std::exit(1);
+            }
+            while (!operators.empty())
+            {
+                reduce();
+            }
+            return operands.back();
+        }
     }
-
-    return expr;
 }
 
 Exp *Parser::parsePrimary()
@@ -647,17 +668,6 @@ Exp *Parser::parsePrimary()
     {
         return new BoolExp(false);
     }
-    if (match(Token::LEFT_PAREN))
-    {
-        Exp *expr = parseExpression();
-        if (!match(Token::RIGHT_PAREN))
-        {
-            cout << "Error: se esperaba ')' después de la expresión." << endl;
-            std::exit(1);
-        }
-        return new ParenthesizedExp(expr);
-    }
-
     if (match(Token::ID))
     {
         string name = previous->text;
@@ -817,6 +827,7 @@ Stm *Parser::parsePrintStatement()
 
 Stm *Parser::parseFunDeclaration()
 {
+    bool isTailrec = match(Token::TAILREC);
     if (!match(Token::FUN))
     {
         cout << "Error: se esperaba 'fun'." << endl;
@@ -881,6 +892,7 @@ Stm *Parser::parseFunDeclaration()
     Block *body = parseBlock();
 
     FunctionDecl *funcDecl = new FunctionDecl(name, returnType, body);
+    funcDecl->isTailrec = isTailrec;
     for (auto &param : params)
     {
         funcDecl->addParam(param.first, param.second);
@@ -1108,7 +1120,7 @@ Stm *Parser::parseTopLevelStatement()
     {
         return parseVarDeclaration();
     }
-    else if (check(Token::FUN))
+    else if (check(Token::FUN) || check(Token::TAILREC))
     {
         return parseFunDeclaration();
     }
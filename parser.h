@@ -14,15 +14,9 @@ private:
     bool advance();
     bool isAtEnd();
 
+    bool matchBinaryOperator(BinaryOp &op, int &precedence);
+    bool matchPrefixOperator(UnaryExp::UnaryOp &op);
     Exp *parseExpression();
-    Exp *parseOrExp();
-    Exp *parseAndExp();
-    Exp *parseEqExp();
-    Exp *parseRelExp();
-    Exp *parseAddExp();
-    Exp *parseMulExp();
-    Exp *parseUnExp();
-    Exp *parsePostExp();
     Exp *parsePrimary();
     Stm *parseStatement();
     Stm *parseTopLevelStatement();
@@ -0,0 +1,642 @@
+#include "peephole.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <set>
+#include <sstream>
+#include <unordered_map>
+
+using namespace std;
+
+typedef vector<AsmLine> Code;
+
+// Los patrones son literales: se comparan como const char * para no crear un
+// string por cada intento
+static bool isInstruction(const Code &code, size_t i, const char *mnemonic)
+{
+    return i < code.size() && code[i].kind == AsmLine::INSTRUCTION && code[i].mnemonic == mnemonic &&
+           !code[i].operands.empty();
+}
+
+static bool isInstruction(const Code &code, size_t i, const char *mnemonic, const char *first, const char *second)
+{
+    return isInstruction(code, i, mnemonic) && code[i].operands.size() == 2 &&
+           (!*first || code[i].operands[0] == first) && (!*second || code[i].operands[1] == second);
+}
+
+static AsmLine instruction(const string &mnemonic, const vector<string> &operands)
+{
+    return {AsmLine::INSTRUCTION, mnemonic, operands, ""};
+}
+
+static bool isMemory(const string &operand)
+{
+    return operand.find('(') != string::npos;
+}
+
+static bool isRegister(const string &operand)
+{
+    return !operand.empty() && operand[0] == '%';
+}
+
+// Si el operando usa el registro de 64 bits reg (rax, r8, ...) con cualquiera
+// de sus nombres
+static bool mentions(const string &operand, const char *reg)
+{
+    static const vector<vector<string>> aliases = {
+        {"rax", "%rax", "%eax", "%ax", "%al"}, {"rbx", "%rbx", "%ebx", "%bx", "%bl"},
+        {"rcx", "%rcx", "%ecx", "%cx", "%cl"}, {"rdx", "%rdx", "%edx", "%dx", "%dl"},
+        {"rsi", "%rsi", "%esi", "%si", "%sil"}, {"rdi", "%rdi", "%edi", "%di", "%dil"},
+        {"rsp", "%rsp", "%esp", "%sp", "%spl"}, {"rbp", "%rbp", "%ebp", "%bp", "%bpl"}};
+    for (const auto &names : aliases)
+    {
+        if (names[0] != reg)
+            continue;
+        for (size_t i = 1; i < names.size(); i++)
+            if (operand.find(names[i]) != string::npos)
+                return true;
+        return false;
+    }
+    return operand.find(string("%") + reg) != string::npos;
+}
+
+static string registerName(const string &operand)
+{
+    return operand.size() > 1 ? operand.substr(1) : "";
+}
+
+// pushq A / popq B: nada si son el mismo registro, si no movq A, B
+static bool pushPop(Code &code, size_t i, const unordered_set<string> &)
+{
+    if (!isInstruction(code, i, "pushq") || !isInstruction(code, i + 1, "popq"))
+        return false;
+    string source = code[i].operands[0], target = code[i + 1].operands[0];
+    if (!isRegister(target) || mentions(source, "rsp"))
+        return false;
+    code.erase(code.begin() + i + 1);
+    if (source == target)
+        code.erase(code.begin() + i);
+    else
+        code[i] = instruction("movq", {source, target});
+    return true;
+}
+
+// Operando derecho simple de una operación entera: pushq %rax, movq S, %rax,
+// movq %rax, %rcx, popq %rax es movq S, %rcx
+static bool rightOperandRcx(Code &code, size_t i, const unordered_set<string> &)
+{
+    if (!isInstruction(code, i, "pushq") || code[i].operands[0] != "%rax" ||
+        !isInstruction(code, i + 1, "movq", "", "%rax") || !isInstruction(code, i + 2, "movq", "%rax", "%rcx") ||
+        !isInstruction(code, i + 3, "popq") || code[i + 3].operands[0] != "%rax")
+        return false;
+    string source = code[i + 1].operands[0];
+    if (mentions(source, "rsp") || mentions(source, "rcx"))
+        return false;
+    code[i] = instruction("movq", {source, "%rcx"});
+    code.erase(code.begin() + i + 1, code.begin() + i + 4);
+    return true;
+}
+
+// Lo mismo con Float: el izquierdo se queda en xmm0 y el derecho se carga
+// directamente en xmm1, sin pasar por la pila
+static bool rightOperandXmm1(Code &code, size_t i, const unordered_set<string> &)
+{
+    if (!isInstruction(code, i, "movss", "%xmm0", "-8(%rsp)") || !isInstruction(code, i + 1, "subq", "$8", "%rsp") ||
+        !isInstruction(code, i + 2, "movss", "", "%xmm0") || !isInstruction(code, i + 3, "movss", "%xmm0", "%xmm1") ||
+        !isInstruction(code, i + 4, "movss", "(%rsp)", "%xmm0") || !isInstruction(code, i + 5, "addq", "$8", "%rsp"))
+        return false;
+    string source = code[i + 2].operands[0];
+    if (mentions(source, "rsp") || source.find("%xmm1") != string::npos)
+        return false;
+    code[i] = instruction("movss", {source, "%xmm1"});
+    code.erase(code.begin() + i + 1, code.begin() + i + 6);
+    return true;
+}
+
+// Guardar un registro y volver a leerlo de la misma dirección
+static bool storeReload(Code &code, size_t i, const unordered_set<string> &)
+{
+    for (const char *mnemonic : {"movq", "movss"})
+    {
+        if (!isInstruction(code, i, mnemonic, "", "") || !isInstruction(code, i + 1, mnemonic, "", ""))
+            continue;
+        string value = code[i].operands[0], address = code[i].operands[1];
+        if (!isRegister(value) || !isMemory(address) || code[i + 1].operands[0] != address ||
+            !isRegister(code[i + 1].operands[1]))
+            return false;
+        if (code[i + 1].operands[1] == value)
+            code.erase(code.begin() + i + 1);
+        else
+            code[i + 1].operands[0] = value;
+        return true;
+    }
+    return false;
+}
+
+// setcc y movzbq ya dejan el resto de rax en cero
+static bool zeroBeforeSetcc(Code &code, size_t i, const unordered_set<string> &)
+{
+    if (!isInstruction(code, i, "movl", "$0", "%eax") || i + 2 >= code.size() ||
+        code[i + 1].kind != AsmLine::INSTRUCTION || code[i + 1].mnemonic.compare(0, 3, "set") != 0 ||
+        code[i + 1].operands.size() != 1 || code[i + 1].operands[0] != "%al" ||
+        !isInstruction(code, i + 2, "movzbq", "%al", "%rax"))
+        return false;
+    code.erase(code.begin() + i);
+    return true;
+}
+
+// Si la instrucción escribe rax sin leerlo antes
+static bool overwritesRax(const Code &code, size_t i)
+{
+    if (isInstruction(code, i, "xorl", "%eax", "%eax"))
+        return true;
+    if (!isInstruction(code, i, "movq", "", "%rax") && !isInstruction(code, i, "leaq", "", "%rax") &&
+        !isInstruction(code, i, "movl", "", "%eax"))
+        return false;
+    return !mentions(code[i].operands[0], "rax");
+}
+
+// movq $k, %rax y movq %rax, M con rax muerto después: movq $k, M, si k cabe
+// en 32 bits con signo
+static bool immediateToMemory(Code &code, size_t i, const unordered_set<string> &)
+{
+    if (!isInstruction(code, i, "movq", "", "%rax") || code[i].operands[0][0] != '$' ||
+        !isInstruction(code, i + 1, "movq", "%rax", "") || !isMemory(code[i + 1].operands[1]) ||
+        mentions(code[i + 1].operands[1], "rax") || !overwritesRax(code, i + 2))
+        return false;
+    char *end;
+    string digits = code[i].operands[0].substr(1);
+    long long value = strtoll(digits.c_str(), &end, 10);
+    if (digits.empty() || *end || value < INT32_MIN || value > INT32_MAX)
+        return false;
+    code[i].operands[1] = code[i + 1].operands[1];
+    code.erase(code.begin() + i + 1);
+    return true;
+}
+
+// El argumento de una llamada se carga directamente en su registro: la
+// llamada pisa rax de todos modos
+static bool directArgument(Code &code, size_t i, const unordered_set<string> &)
+{
+    if ((!isInstruction(code, i, "movq", "", "%rax") && !isInstruction(code, i, "leaq", "", "%rax")) ||
+        !isInstruction(code, i + 1, "movq", "%rax", "") || !isInstruction(code, i + 2, "call"))
+        return false;
+    string target = code[i + 1].operands[1];
+    if (!isRegister(target) || target == "%rax" || mentions(code[i].operands[0], registerName(target).c_str()))
+        return false;
+    code[i].operands[1] = target;
+    code.erase(code.begin() + i + 1);
+    return true;
+}
+
+// Las funciones del programa no son variádicas: no leen el número de
+// registros xmm que les deja movl $n, %eax
+static bool vectorCountOwnCall(Code &code, size_t i, const unordered_set<string> &internas)
+{
+    if (!isInstruction(code, i, "movl", "", "%eax") || code[i].operands[0][0] != '$' ||
+        !isInstruction(code, i + 1, "call") || !internas.count(code[i + 1].operands[0]))
+        return false;
+    code.erase(code.begin() + i);
+    return true;
+}
+
+// Salto (condicional o no) a una etiqueta que sigue inmediatamente. La
+// ventana termina en la etiqueta recién agregada; el salto está antes de
+// todas las etiquetas seguidas
+static bool jumpToNext(Code &code, size_t i, const unordered_set<string> &)
+{
+    size_t jump = i + 1;
+    while (jump > 0 && code[jump].kind == AsmLine::LABEL)
+        jump--;
+    if (jump == i + 1 || code[jump].kind != AsmLine::INSTRUCTION || code[jump].mnemonic[0] != 'j' ||
+        code[jump].operands.size() != 1)
+        return false;
+    const string &target = code[jump].operands[0];
+    for (size_t j = jump + 1; j < code.size(); j++)
+    {
+        const string &label = code[j].text;
+        if (label.size() == target.size() + 1 && label.compare(0, target.size(), target) == 0)
+        {
+            code.erase(code.begin() + jump);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Lo que sigue a jmp o ret hasta la próxima etiqueta no se ejecuta nunca
+static bool unreachable(Code &code, size_t i, const unordered_set<string> &)
+{
+    if (!isInstruction(code, i, "jmp") && !(i < code.size() && code[i].kind == AsmLine::INSTRUCTION &&
+                                            code[i].mnemonic == "ret"))
+        return false;
+    if (i + 1 >= code.size() || code[i + 1].kind != AsmLine::INSTRUCTION)
+        return false;
+    code.erase(code.begin() + i + 1);
+    return true;
+}
+
+// largo: líneas de la ventana. Cada regla se prueba solo con la ventana que
+// termina en la última línea de la salida
+struct Rule
+{
+    const char *nombre;
+    size_t largo;
+    bool (*aplicar)(Code &code, size_t i, const unordered_set<string> &internas);
+};
+
+static const Rule RULES[] = {
+    {"pushq/popq", 2, pushPop},
+    {"operando derecho en rcx", 4, rightOperandRcx},
+    {"operando derecho en xmm1", 6, rightOperandXmm1},
+    {"guardar y volver a leer", 2, storeReload},
+    {"movl $0 antes de setcc", 3, zeroBeforeSetcc},
+    {"inmediato a memoria", 3, immediateToMemory},
+    {"argumento directo", 3, directArgument},
+    {"movl %eax antes de call propio", 2, vectorCountOwnCall},
+    {"salto a la siguiente linea", 2, jumpToNext},
+    {"codigo inalcanzable", 2, unreachable},
+};
+static const size_t RULE_COUNT = sizeof(RULES) / sizeof(RULES[0]);
+
+PeepholeOptimizer::PeepholeOptimizer(const unordered_set<string> &funciones)
+    : internas(funciones), disparos(RULE_COUNT, 0) {}
+
+Code parseAssembly(const string &codigo)
+{
+    Code code;
+    istringstream input(codigo);
+    string line;
+    while (getline(input, line))
+    {
+        size_t start = line.find_first_not_of(" \t");
+        if (start == string::npos)
+            continue;
+        size_t end = line.find_last_not_of(" \t\r");
+        string text = line.substr(start, end - start + 1);
+        if (text.back() == ':' && text.find_first_of(" \t") == string::npos)
+        {
+            code.push_back({AsmLine::LABEL, "", {}, text});
+            continue;
+        }
+        if (text[0] == '.')
+        {
+            code.push_back({AsmLine::OTHER, "", {}, line});
+            continue;
+        }
+
+        AsmLine instr{AsmLine::INSTRUCTION, "", {}, ""};
+        size_t space = text.find_first_of(" \t");
+        instr.mnemonic = text.substr(0, space);
+        if (space != string::npos)
+        {
+            // Las comas entre paréntesis son de la dirección, no separan operandos
+            int depth = 0;
+            string operand;
+            for (char c : text.substr(space))
+            {
+                depth += c == '(' ? 1 : c == ')' ? -1 : 0;
+                if (c == ',' && depth == 0)
+                {
+                    instr.operands.push_back(operand);
+                    operand.clear();
+                }
+                else if (c != ' ' && c != '\t')
+                    operand += c;
+            }
+            instr.operands.push_back(operand);
+        }
+        code.push_back(instr);
+    }
+    return code;
+}
+
+void printAssembly(const Code &code, ostream &out)
+{
+    for (const AsmLine &line : code)
+    {
+        if (line.kind != AsmLine::INSTRUCTION)
+        {
+            out << line.text << "\n";
+            continue;
+        }
+        out << " " << line.mnemonic;
+        for (size_t i = 0; i < line.operands.size(); i++)
+            out << (i ? ", " : " ") << line.operands[i];
+        out << "\n";
+    }
+}
+
+static long countInstructions(const Code &code)
+{
+    long count = 0;
+    for (const AsmLine &line : code)
+        count += line.kind == AsmLine::INSTRUCTION;
+    return count;
+}
+
+void PeepholeOptimizer::optimizar(Code &input)
+{
+    antes += countInstructions(input);
+
+    // Cada línea se agrega al final de la salida y las reglas se prueban con
+    // la ventana que termina en ella; si una dispara, se vuelve a probar con
+    // el nuevo final. Un disparo no obliga a recorrer la función otra vez.
+    Code code;
+    for (AsmLine &line : input)
+    {
+        code.push_back(std::move(line));
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+            for (size_t rule = 0; rule < RULE_COUNT && !changed; rule++)
+            {
+                size_t largo = RULES[rule].largo;
+                if (code.size() >= largo && RULES[rule].aplicar(code, code.size() - largo, internas))
+                {
+                    disparos[rule]++;
+                    changed = true;
+                }
+            }
+        }
+    }
+    despues += countInstructions(code);
+    input = std::move(code);
+}
+
+void PeepholeOptimizer::imprimirPerfil(ostream &salida) const
+{
+    salida << "Mirilla: " << antes << " -> " << despues << " instrucciones";
+    if (antes)
+        salida << " (-" << fixed << setprecision(1) << 100.0 * (antes - despues) / antes << "%)" << defaultfloat;
+    salida << endl;
+    for (size_t rule = 0; rule < RULE_COUNT; rule++)
+        salida << "  " << RULES[rule].nombre << ": " << disparos[rule] << endl;
+}
+
+// Desplazamiento de una dirección N(base); false si el operando es otra cosa
+static bool displacement(const string &operand, const char *base, long &value)
+{
+    size_t length = strlen(base) + 2;
+    if (operand.size() < length || operand.back() != ')' || operand[operand.size() - length] != '(' ||
+        operand.compare(operand.size() - length + 1, length - 2, base) != 0)
+        return false;
+    char *end;
+    value = strtol(operand.c_str(), &end, 10);
+    return end == operand.c_str() + operand.size() - length;
+}
+
+static bool isInstruction(const AsmLine &line, const string &mnemonic, const vector<string> &operands)
+{
+    return line.kind == AsmLine::INSTRUCTION && line.mnemonic == mnemonic && line.operands == operands;
+}
+
+static bool isGeneralRegister(const string &operand)
+{
+    static const set<string> registers = {"%rax", "%rbx", "%rcx", "%rdx", "%rsi", "%rdi", "%r8", "%r9",
+                                          "%r10", "%r11", "%r12", "%r13", "%r14", "%r15"};
+    return registers.count(operand) != 0;
+}
+
+// Si la instrucción sigue siendo válida con el registro del parámetro en
+// lugar de su ranura como primer operando
+static bool readsWithRegister(const AsmLine &line, int size)
+{
+    static const set<string> integer = {"movq", "addq", "subq", "imulq", "cmpq", "andq", "orq", "xorq", "testq"};
+    static const set<string> integerToFloat = {"cvtsi2ssq", "cvtsi2sdq"};
+    static const set<string> single = {"movss", "addss", "subss", "mulss", "divss",
+                                       "sqrtss", "comiss", "ucomiss", "cvtss2sd"};
+    static const set<string> singleToInteger = {"cvttss2si", "cvtss2si"};
+
+    const string &target = line.operands[1];
+    bool xmm = target.compare(0, 4, "%xmm") == 0;
+    if (size == 8)
+        return (integer.count(line.mnemonic) && isGeneralRegister(target)) ||
+               (integerToFloat.count(line.mnemonic) && xmm);
+    return (single.count(line.mnemonic) && xmm) || (singleToInteger.count(line.mnemonic) && isGeneralRegister(target));
+}
+
+// Bytes que lee o escribe una instrucción en memoria: 4 las de Float
+static int accessSize(const AsmLine &line)
+{
+    const string &mnemonic = line.mnemonic;
+    return mnemonic.find("ss") != string::npos && mnemonic.compare(0, 6, "cvtsi2") != 0 ? 4 : 8;
+}
+
+// Un parámetro se queda en su registro si ninguna otra instrucción nombra el
+// registro y su ranura solo se lee, con instrucciones que aceptan el registro
+int LeafFrameElider::keepParameters(vector<AsmLine> &code, size_t stores, size_t body)
+{
+    int kept = 0;
+    for (size_t s = body; s-- > stores;)
+    {
+        string reg = code[s].operands[0];
+        int size = code[s].mnemonic == "movss" ? 4 : 8;
+        long offset;
+        displacement(code[s].operands[1], "%rbp", offset);
+
+        bool ok = true;
+        vector<pair<size_t, size_t>> reads;
+        for (size_t i = 0; i < code.size() && ok; i++)
+        {
+            if (i == s || code[i].kind != AsmLine::INSTRUCTION)
+                continue;
+            const vector<string> &operands = code[i].operands;
+            for (size_t k = 0; k < operands.size() && ok; k++)
+            {
+                long other;
+                if (mentions(operands[k], reg.c_str() + 1))
+                    ok = false;
+                else if (displacement(operands[k], "%rbp", other) && other < offset + size &&
+                         other + accessSize(code[i]) > offset)
+                {
+                    ok = other == offset && k == 0 && operands.size() == 2 && readsWithRegister(code[i], size);
+                    reads.push_back({i, k});
+                }
+            }
+        }
+        if (!ok)
+            continue;
+
+        for (auto &read : reads)
+            code[read.first].operands[read.second] = reg;
+        code.erase(code.begin() + s);
+        kept++;
+    }
+    return kept;
+}
+
+// Sin marco %rsp queda fijo: las locales N(%rbp) pasan a N(%rsp) y la pila de
+// operandos se cuenta en tiempo de compilación, debajo de las locales. En
+// cada etiqueta la profundidad tiene que ser la misma por cualquier camino.
+bool LeafFrameElider::moveToRedZone(vector<AsmLine> &code, int reserva)
+{
+    const long RED_ZONE = 128;
+    unordered_map<string, long> depthAt;
+    set<string> labels;
+    for (const AsmLine &line : code)
+        if (line.kind == AsmLine::LABEL)
+            labels.insert(line.text.substr(0, line.text.size() - 1));
+    long depth = 0;
+    bool reachable = true;
+    bool fits = true;
+
+    auto address = [&](long value) {
+        fits = fits && value < 0 && value >= -RED_ZONE;
+        return to_string(value) + "(%rsp)";
+    };
+
+    for (AsmLine &line : code)
+    {
+        if (line.kind == AsmLine::LABEL)
+        {
+            string name = line.text.substr(0, line.text.size() - 1);
+            auto found = depthAt.find(name);
+            if (!reachable)
+            {
+                if (found == depthAt.end())
+                    return false;
+                depth = found->second;
+                reachable = true;
+            }
+            else if (found != depthAt.end() && found->second != depth)
+                return false;
+            depthAt[name] = depth;
+            continue;
+        }
+        if (line.kind != AsmLine::INSTRUCTION)
+            continue;
+        if (!reachable)
+            return false;
+
+        const string mnemonic = line.mnemonic;
+        vector<string> &operands = line.operands;
+        if (mnemonic == "call" || mnemonic == "leave" || mnemonic == "enter")
+            return false;
+        if (mnemonic == "ret")
+        {
+            if (depth != 0)
+                return false;
+            reachable = false;
+            continue;
+        }
+        if (mnemonic[0] == 'j')
+        {
+            if (operands.size() != 1 || !labels.count(operands[0]))
+                return false;
+            auto found = depthAt.find(operands[0]);
+            if (found != depthAt.end() && found->second != depth)
+                return false;
+            depthAt[operands[0]] = depth;
+            reachable = mnemonic != "jmp";
+            continue;
+        }
+
+        if ((mnemonic == "subq" || mnemonic == "addq") && operands.size() == 2 && operands[1] == "%rsp")
+        {
+            char *end;
+            long amount = operands[0][0] == '$' ? strtol(operands[0].c_str() + 1, &end, 10) : -1;
+            if (amount < 0 || *end)
+                return false;
+            depth += mnemonic == "subq" ? amount : -amount;
+            line = {AsmLine::OTHER, "", {}, ""};
+        }
+        else if (mnemonic == "pushq" || mnemonic == "popq")
+        {
+            if (operands.size() != 1 || operands[0].find('(') != string::npos || mentions(operands[0], "rsp") ||
+                mentions(operands[0], "rbp"))
+                return false;
+            if (mnemonic == "pushq")
+            {
+                depth += 8;
+                line = {AsmLine::INSTRUCTION, "movq", {operands[0], address(-reserva - depth)}, ""};
+            }
+            else
+            {
+                if (operands[0][0] != '%')
+                    return false;
+                line = {AsmLine::INSTRUCTION, "movq", {address(-reserva - depth), operands[0]}, ""};
+                depth -= 8;
+            }
+        }
+        else
+        {
+            for (string &operand : operands)
+            {
+                long value;
+                if (displacement(operand, "%rbp", value))
+                    operand = address(value);
+                else if (displacement(operand, "%rsp", value))
+                    operand = address(value - reserva - depth);
+                else if (mentions(operand, "rsp") || mentions(operand, "rbp"))
+                    return false;
+            }
+        }
+        if (depth < 0 || !fits)
+            return false;
+    }
+    code.erase(remove_if(code.begin(), code.end(),
+                         [](const AsmLine &line) { return line.kind == AsmLine::OTHER && line.text.empty(); }),
+               code.end());
+    return true;
+}
+
+bool LeafFrameElider::omitir(vector<AsmLine> &lineas, int reserva)
+{
+    funciones++;
+
+    // pushq %rbp / movq %rsp, %rbp al principio y leave / ret al final
+    size_t first = 0, last = lineas.size();
+    while (first < lineas.size() && lineas[first].kind != AsmLine::INSTRUCTION)
+        first++;
+    while (last > 0 && lineas[last - 1].kind != AsmLine::INSTRUCTION)
+        last--;
+    if (first + 2 > last || last < 2 || !isInstruction(lineas[first], "pushq", {"%rbp"}) ||
+        !isInstruction(lineas[first + 1], "movq", {"%rsp", "%rbp"}) || !isInstruction(lineas[last - 1], "ret", {}) ||
+        !isInstruction(lineas[last - 2], "leave", {}))
+        return false;
+    // Una llamada es lo que más a menudo la descarta: se mira antes de copiar
+    for (const AsmLine &line : lineas)
+        if (line.kind == AsmLine::INSTRUCTION && line.mnemonic == "call")
+            return false;
+
+    // Los pasos siguientes pueden rendirse a mitad de camino
+    vector<AsmLine> code = lineas;
+    code.erase(code.begin() + last - 2);
+    code.erase(code.begin() + first, code.begin() + first + 2);
+
+    // Después vienen los parámetros guardados en sus ranuras y la reserva
+    size_t stores = first;
+    while (stores < code.size() && code[stores].kind == AsmLine::LABEL)
+        stores++;
+    size_t body = stores;
+    long offset;
+    while (body < code.size() && code[body].kind == AsmLine::INSTRUCTION &&
+           (code[body].mnemonic == "movq" || code[body].mnemonic == "movss") && code[body].operands.size() == 2 &&
+           code[body].operands[0][0] == '%' && displacement(code[body].operands[1], "%rbp", offset))
+        body++;
+    if (reserva > 0)
+    {
+        if (body >= code.size() || !isInstruction(code[body], "subq", {"$" + to_string(reserva), "%rsp"}))
+            return false;
+        code.erase(code.begin() + body);
+    }
+
+    int kept = keepParameters(code, stores, body);
+    if (!moveToRedZone(code, reserva))
+        return false;
+
+    hojas++;
+    parametros += kept;
+    lineas = std::move(code);
+    return true;
+}
+
+void LeafFrameElider::imprimirPerfil(ostream &salida) const
+{
+    salida << "Hojas sin marco: " << hojas << " de " << funciones << " funciones, " << parametros
+           << " parametros en registro" << endl;
+}
@@ -0,0 +1,73 @@
+#ifndef PEEPHOLE_H
+#define PEEPHOLE_H
+
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using std::string;
+
+// Una línea del assembly de una función: instrucción con sus operandos ya
+// separados, etiqueta o cualquier otra cosa (directivas), que se copia tal cual
+struct AsmLine
+{
+    enum Kind
+    {
+        INSTRUCTION,
+        LABEL,
+        OTHER
+    };
+    Kind kind;
+    string mnemonic;
+    std::vector<string> operands;
+    string text;
+};
+
+// Texto de una función a AsmLine y de vuelta. GenCodeVisitor lee cada función
+// una vez y la mirilla y LeafFrameElider trabajan sobre la misma lista.
+std::vector<AsmLine> parseAssembly(const string &codigo);
+void printAssembly(const std::vector<AsmLine> &code, std::ostream &out);
+
+// Optimizador de mirilla sobre el código de cada función de GenCodeVisitor,
+// ya convertido en una lista de AsmLine. Cada regla de la tabla
+// reescribe una ventana de instrucciones consecutivas, hasta que ninguna
+// aplica. Las etiquetas cortan las ventanas, salvo en las reglas de saltos.
+// Los runtimes escritos a mano no pasan por aquí. --perfil muestra cuántas
+// veces disparó cada regla y --sin-mirilla la desactiva.
+class PeepholeOptimizer
+{
+    std::unordered_set<string> internas;
+    std::vector<long> disparos;
+    long antes = 0, despues = 0;
+
+public:
+    // funciones: las del programa, que no leen %al como las variádicas
+    explicit PeepholeOptimizer(const std::unordered_set<string> &funciones = {});
+    void optimizar(std::vector<AsmLine> &code);
+    void imprimirPerfil(std::ostream &salida) const;
+};
+
+// Funciones hoja sin marco. Trabaja sobre las líneas de la función ya
+// generada (y pasada por la mirilla, si está activa): si no hay llamadas y %rbp solo se usa para direccionar
+// locales, se quitan pushq %rbp, movq %rsp, %rbp, la reserva y leave. Las
+// locales quedan en la zona roja (los 128 bytes bajo %rsp que la ABI
+// garantiza a quien no llama a nadie) y la pila de operandos, justo debajo,
+// pasa a ser movs a direcciones fijas porque %rsp ya no se mueve. Los
+// parámetros que el cuerpo solo lee se quedan en su registro si el cuerpo no
+// lo toca. Ante cualquier cosa que no entienda deja la función como estaba.
+// --con-marco lo desactiva, para perfiladores que siguen la cadena de %rbp.
+class LeafFrameElider
+{
+    long hojas = 0, funciones = 0, parametros = 0;
+
+    int keepParameters(std::vector<AsmLine> &code, size_t stores, size_t body);
+    bool moveToRedZone(std::vector<AsmLine> &code, int reserva);
+
+public:
+    // false si la función se deja como estaba
+    bool omitir(std::vector<AsmLine> &code, int reserva);
+    void imprimirPerfil(std::ostream &salida) const;
+};
+
+#endif
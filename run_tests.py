@@ -11,6 +11,19 @@ def natural_sort_key(text):
     return [convert(c) for c in re.split('([0-9]+)', text)]
 
 def main():
+    # --jit [compilador]: ejecuta cada .s en memoria con "compilador --run"
+    # en lugar de enlazarlo con gcc
+    # --objeto [compilador]: genera el .o con "compilador --objeto" y gcc
+    # solo enlaza, sin pasar por el ensamblador
+    jit = None
+    objeto = None
+    if len(sys.argv) > 1 and sys.argv[1] in ('--jit', '--objeto'):
+        compilador = sys.argv[2] if len(sys.argv) > 2 else ("main.exe" if os.name == 'nt' else "./main")
+        if sys.argv[1] == '--jit':
+            jit = compilador
+        else:
+            objeto = compilador
+
     print("🔧 EJECUTOR DE ARCHIVOS ASSEMBLY (.s)")
     print("="*60)
     
@@ -33,20 +46,40 @@ def main():
         print("-" * 40)
 
         try:
-            compile_result = subprocess.run(['gcc', s_file], 
-                                          capture_output=True, text=True, timeout=10)
-            
-            if compile_result.returncode != 0:
-                print(f"❌ Error compilando: {compile_result.stderr.strip()}")
-                failed += 1
-                continue
-            
-            run_result = subprocess.run(['./a.out'], 
-                                      capture_output=True, text=True, timeout=5)
+            if jit:
+                run_result = subprocess.run([jit, '--run', s_file],
+                                          capture_output=True, text=True, timeout=5)
+            else:
+                entrada = s_file
+                if objeto:
+                    objeto_result = subprocess.run([objeto, '--objeto', s_file],
+                                                  capture_output=True, text=True, timeout=10)
+                    if objeto_result.returncode != 0:
+                        print(f"❌ Error generando el objeto: {objeto_result.stdout.strip()}")
+                        failed += 1
+                        continue
+                    entrada = s_file[:-2] + '.o'
+
+                compile_result = subprocess.run(['gcc', entrada], 
+                                              capture_output=True, text=True, timeout=10)
+                
+                if compile_result.returncode != 0:
+                    print(f"❌ Error compilando: {compile_result.stderr.strip()}")
+                    failed += 1
+                    continue
+                
+                run_result = subprocess.run(['./a.out'], 
+                                          capture_output=True, text=True, timeout=5)
             
             output = run_result.stdout.strip()
             
-            if output:
+            if run_result.returncode != 0:
+                detalle = f"señal {-run_result.returncode}" if run_result.returncode < 0 else f"código {run_result.returncode}"
+                print(f"❌ Terminó con {detalle}: {run_result.stderr.strip()}")
+                for line in output.split('\n') if output else []:
+                    print(f"📄 {line}")
+                failed += 1
+            elif output:
                 print(f"✅ Ejecución exitosa (código: {run_result.returncode})")
                 for line in output.split('\n'):
                     print(f"📄 {line}")
@@ -66,6 +99,8 @@ def main():
             print(f"❌ Error: {e}")
             failed += 1
         finally:
+            if objeto and os.path.exists(s_file[:-2] + '.o'):
+                os.remove(s_file[:-2] + '.o')
             if os.path.exists('a.out'):
                 try:
                     os.remove('a.out')
@@ -151,6 +151,10 @@ Token *Scanner::nextToken()
         {
             token = new Token(Token::FUN, word, 0, word.length());
         }
+        else if (word == "tailrec")
+        {
+            token = new Token(Token::TAILREC, word, 0, word.length());
+        }
         else if (word == "return")
         {
             token = new Token(Token::RETURN, word, 0, word.length());
@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+import subprocess
+import os
+import sys
+import shutil
+import tempfile
+
+DEPTH = 100000
+
+
+def programas():
+    n = DEPTH
+    return [
+        ("suma_encadenada",
+         "fun main(): Unit {\n    var x: Int = " + " + ".join(["1"] * n) + "\n    println(x)\n}\n",
+         str(n)),
+        ("suma_parametro",
+         "fun f(g: Int): Int {\n    return " + " + ".join(["g"] * n) + "\n}\n"
+         "fun main(): Unit {\n    println(f(1))\n}\n",
+         str(n)),
+        ("parentesis_anidados",
+         "fun main(): Unit {\n    println(" + "(" * n + "7" + ")" * n + ")\n}\n",
+         "7"),
+        ("suma_anidada_derecha",
+         "fun main(): Unit {\n    println(" + "1 + (" * (n - 1) + "1" + ")" * (n - 1) + ")\n}\n",
+         str(n)),
+        ("negaciones_logicas",
+         "fun f(b: Boolean): Int {\n    if (" + "!" * n + "b) {\n        return 1\n    }\n    return 0\n}\n"
+         "fun main(): Unit {\n    println(f(true))\n}\n",
+         "1" if n % 2 == 0 else "0"),
+        ("negaciones_aritmeticas",
+         "fun f(g: Int): Int {\n    return " + "-(" * n + "g" + ")" * n + "\n}\n"
+         "fun main(): Unit {\n    println(f(1))\n}\n",
+         "1" if n % 2 == 0 else "-1"),
+    ]
+
+
+def salida_eval(stdout):
+    lineas = stdout.split("\n")
+    if "EJECUTAR:" not in lineas:
+        return []
+    inicio = lineas.index("EJECUTAR:") + 1
+    fin = lineas.index("GENERAR CODIGO ASSEMBLY:") if "GENERAR CODIGO ASSEMBLY:" in lineas else len(lineas)
+    return [l for l in lineas[inicio:fin] if l.strip()]
+
+
+def main():
+    compiler = sys.argv[1] if len(sys.argv) > 1 else ("main.exe" if os.name == 'nt' else "./main")
+    compiler = os.path.abspath(compiler)
+    print("🧱 PRUEBAS DE ESTRES - ANIDAMIENTO PROFUNDO")
+    print("=" * 60)
+
+    tmp_dir = tempfile.mkdtemp(prefix="stress_")
+    fallidas = 0
+    try:
+        for nombre, codigo, esperado in programas():
+            fuente = os.path.join(tmp_dir, nombre + ".txt")
+            with open(fuente, "w") as f:
+                f.write(codigo)
+
+            print(f"📁 {nombre} (profundidad {DEPTH})")
+            result = subprocess.run([compiler, fuente], capture_output=True, text=True, timeout=120)
+            salida = salida_eval(result.stdout)
+            if result.returncode != 0 or salida != [esperado]:
+                print(f"❌ Interprete: código {result.returncode}, salida {salida[:3]}, esperado {esperado}")
+                fallidas += 1
+                continue
+            print(f"✅ Interprete: {esperado}")
+
+            if shutil.which("gcc") is None:
+                continue
+            ejecutable = os.path.join(tmp_dir, nombre + ".out")
+            gcc = subprocess.run(["gcc", "-o", ejecutable, os.path.join(tmp_dir, nombre + ".s")],
+                                 capture_output=True, text=True)
+            if gcc.returncode != 0:
+                print(f"❌ Error ensamblando: {gcc.stderr.strip()[:200]}")
+                fallidas += 1
+                continue
+            run = subprocess.run([ejecutable], capture_output=True, text=True, timeout=10)
+            if run.stdout.strip() != esperado:
+                print(f"❌ Ensamblador: salida {run.stdout.strip()[:40]}, esperado {esperado}")
+                fallidas += 1
+                continue
+            print(f"✅ Ensamblador: {esperado}")
+    finally:
+        shutil.rmtree(tmp_dir, ignore_errors=True)
+
+    print("=" * 60)
+    if fallidas == 0:
+        print("🎉 ¡Todas las pruebas de estrés pasaron!")
+    else:
+        print(f"⚠️  {fallidas} prueba(s) de estrés fallaron")
+    sys.exit(1 if fallidas else 0)
+
+
+if __name__ == "__main__":
+    main()
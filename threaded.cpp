@@ -0,0 +1,1194 @@
+#include "threaded.h"
+#include "output.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+int ThreadedCompiler::emit(int op, int a, int b, int c, float f)
+{
+    ThreadedInstr instr;
+    instr.op = op;
+    instr.a = a;
+    instr.b = b;
+    instr.c = c;
+    instr.f = f;
+    out.code.push_back(instr);
+    return out.code.size() - 1;
+}
+
+// El tamaño del marco sale de la altura máxima de la pila de tipos; frameCells
+// y frameStrings guardan esa altura hasta terminar la función.
+void ThreadedCompiler::push(int type)
+{
+    types.push_back(type);
+    if (type == 5)
+        current->frameStrings = max(current->frameStrings, ++stringDepth);
+    else
+        current->frameCells = max(current->frameCells, ++cellDepth);
+}
+
+int ThreadedCompiler::pop()
+{
+    int type = types.back();
+    types.pop_back();
+    if (type == 5)
+        stringDepth--;
+    else
+        cellDepth--;
+    return type;
+}
+
+void ThreadedCompiler::load(const Slot &slot)
+{
+    if (slot.type == 5)
+        emit(slot.global ? OP_LOAD_GLOBAL_S : OP_LOAD_S, slot.index);
+    else
+        emit(slot.global ? OP_LOAD_GLOBAL : OP_LOAD, slot.index);
+    push(slot.type);
+}
+
+void ThreadedCompiler::store(const Slot &slot)
+{
+    pop();
+    if (slot.type == 5)
+        emit(slot.global ? OP_STORE_GLOBAL_S : OP_STORE_S, slot.index);
+    else
+        emit(slot.global ? OP_STORE_GLOBAL : OP_STORE, slot.index);
+}
+
+int ThreadedCompiler::compileExp(Exp *exp)
+{
+    walk(exp);
+    return types.back();
+}
+
+void ThreadedCompiler::compileCondition(Exp *exp)
+{
+    checkCondition(compileExp(exp));
+    pop();
+}
+
+// Conversión del valor en la cima a otro tipo numérico o Boolean, con las
+// mismas reglas que bindArguments.
+void ThreadedCompiler::convert(int from, int to)
+{
+    checkConversion(from, to);
+    if (from == to || (to == 1 && from == 3))
+    {
+        types.back() = to;
+        return;
+    }
+    if (to == 1 && from == 2)
+        emit(OP_F2I);
+    else if (to == 2 && (from == 1 || from == 3))
+        emit(OP_I2F);
+    else
+        emit(OP_TO_BOOL);
+    types.back() = to;
+}
+
+void ThreadedCompiler::toString(int type)
+{
+    if (type == 1)
+        emit(OP_STR_I);
+    else if (type == 2)
+        emit(OP_STR_F);
+    else
+        emit(OP_STR_B);
+    pop();
+    push(5);
+}
+
+void ThreadedCompiler::compileArguments(FunctionCallExp *call)
+{
+    FunctionDecl *func = call->decl;
+    if (!func || !functionIndex.count(func) || call->args.size() != func->paramTypes.size())
+        fail("llamada sin resolver a '" + call->name + "'");
+    size_t i = 0;
+    for (auto arg : call->args)
+    {
+        int type = compileExp(arg);
+        convert(type, func->paramTypes[i++]);
+    }
+    for (i = 0; i < call->args.size(); i++)
+        pop();
+}
+
+void ThreadedCompiler::compilar(Program *program)
+{
+    vector<FunctionDecl *> functions;
+    vector<VarDec *> globalDecs;
+    FunctionDecl *mainFunc = prepare(program, functions, globalDecs);
+    out.functions.assign(1, ThreadedFunction());
+    for (auto func : functions)
+    {
+        functionIndex[func] = out.functions.size();
+        ThreadedFunction compiled;
+        compiled.decl = func;
+        out.functions.push_back(compiled);
+    }
+
+    // Inicialización de globales, llamada a main y fin del programa
+    current = &out.functions[0];
+    for (auto dec : globalDecs)
+        dec->accept(this);
+    emit(OP_CALL, functionIndex[mainFunc]);
+    emit(mainFunc->returnTypeCode == 5 ? OP_POP_S : OP_POP);
+    emit(OP_HALT);
+    current->frameCells += 2;
+    current->frameStrings += 2;
+    out.globalCells = globalCells;
+    out.globalStrings = globalStrings;
+
+    for (size_t i = 1; i < out.functions.size(); i++)
+        compileFunction(out.functions[i].decl);
+}
+
+void ThreadedCompiler::compileFunction(FunctionDecl *func)
+{
+    current = &out.functions[functionIndex[func]];
+    current->entry = out.code.size();
+    beginFunction(func);
+    current->paramCells = localCells;
+    current->paramStrings = localStrings;
+
+    for (auto stmt : func->body->statements->stms)
+        stmt->accept(this);
+    if (func->returnTypeCode == 0)
+    {
+        emit(OP_PUSH_INT, 0);
+        emit(OP_RETURN);
+    }
+    endFunction(func);
+
+    // Holgura para los valores intermedios de concatenaciones y conversiones
+    current->localCells = localCells;
+    current->localStrings = localStrings;
+    current->frameCells += localCells + 2;
+    current->frameStrings += localStrings + 2;
+}
+
+void ThreadedCompiler::onLeaf(Exp *exp)
+{
+    exp->accept(this);
+}
+
+bool ThreadedCompiler::onOperand(BinaryExp *exp)
+{
+    if (exp->op != AND_OP && exp->op != OR_OP)
+        return true;
+    convert(types.back(), 3);
+    pop();
+    shortCircuit.push_back(emit(exp->op == AND_OP ? OP_JUMP_IF_FALSE_KEEP : OP_JUMP_IF_TRUE_KEEP));
+    return true;
+}
+
+void ThreadedCompiler::onExit(Exp *exp)
+{
+    int kind = nodeKind(exp);
+    if (kind == UNARY_NODE)
+    {
+        UnaryExp *unary = static_cast<UnaryExp *>(exp);
+        int type = types.back();
+        types.back() = unaryType(unary->op, type);
+        if (unary->op == UnaryExp::NOT_OP)
+            emit(OP_NOT);
+        else
+            emit(type == 1 ? OP_NEG_I : OP_NEG_F);
+        return;
+    }
+    if (kind != BINARY_NODE)
+        return;
+
+    BinaryExp *bin = static_cast<BinaryExp *>(exp);
+    if (bin->op == AND_OP || bin->op == OR_OP)
+    {
+        binaryType(bin->op, 3, types.back());
+        convert(types.back(), 3);
+        patch(shortCircuit.back());
+        shortCircuit.pop_back();
+        return;
+    }
+
+    int right = pop();
+    int left = pop();
+    int result = binaryType(bin->op, left, right);
+    switch (bin->op)
+    {
+    case PLUS_OP:
+    case MINUS_OP:
+    case MUL_OP:
+    case DIV_OP:
+    case MOD_OP:
+        if (bin->op == PLUS_OP && (left == 5 || right == 5))
+        {
+            // Las concatenaciones se arman en la pila de String
+            if (left == 5 && right == 5)
+                emit(OP_CONCAT);
+            else if (left == 5)
+            {
+                push(right);
+                toString(right);
+                pop();
+                emit(OP_CONCAT);
+            }
+            else
+            {
+                push(left);
+                toString(left);
+                pop();
+                emit(OP_CONCAT_INV);
+            }
+            break;
+        }
+        if (result == 1)
+        {
+            static const int intOps[] = {OP_ADD_I, OP_SUB_I, OP_MUL_I, OP_DIV_I, OP_MOD_I};
+            emit(intOps[bin->op - PLUS_OP]);
+        }
+        else
+        {
+            static const int floatOps[] = {OP_ADD_F, OP_SUB_F, OP_MUL_F, OP_DIV_F, OP_MOD_F};
+            if (left == 1)
+                emit(OP_I2F_UNDER);
+            if (right == 1)
+                emit(OP_I2F);
+            emit(floatOps[bin->op - PLUS_OP]);
+        }
+        break;
+    default:
+        if (left == 5)
+        {
+            emit(bin->op == EQ_OP ? OP_EQ_S : OP_NE_S);
+        }
+        else if (left == 2 || right == 2)
+        {
+            static const int floatOps[] = {OP_LT_F, OP_LE_F, OP_GT_F, OP_GE_F, OP_EQ_F, OP_NE_F};
+            if (left == 1)
+                emit(OP_I2F_UNDER);
+            if (right == 1)
+                emit(OP_I2F);
+            emit(floatOps[bin->op - LT_OP]);
+        }
+        else
+        {
+            static const int intOps[] = {OP_LT_I, OP_LE_I, OP_GT_I, OP_GE_I, OP_EQ_I, OP_NE_I};
+            emit(intOps[bin->op - LT_OP]);
+        }
+        break;
+    }
+    push(result);
+}
+
+int ThreadedCompiler::visit(BinaryExp *exp) { return compileExp(exp); }
+int ThreadedCompiler::visit(ParenthesizedExp *exp) { return compileExp(exp); }
+
+int ThreadedCompiler::visit(NumberExp *exp)
+{
+    emit(OP_PUSH_INT, exp->value);
+    push(1);
+    return 1;
+}
+
+int ThreadedCompiler::visit(DecimalExp *exp)
+{
+    emit(OP_PUSH_FLOAT, 0, 0, 0, exp->value);
+    push(2);
+    return 2;
+}
+
+int ThreadedCompiler::visit(BoolExp *exp)
+{
+    emit(OP_PUSH_INT, exp->value ? 1 : 0);
+    push(3);
+    return 3;
+}
+
+int ThreadedCompiler::visit(StringExp *exp)
+{
+    emit(OP_PUSH_STR, out.strings.size());
+    out.strings.push_back(exp->value);
+    push(5);
+    return 5;
+}
+
+int ThreadedCompiler::visit(IdentifierExp *exp)
+{
+    Slot slot = lookup(exp->name);
+    load(slot);
+    return slot.type;
+}
+
+int ThreadedCompiler::visit(RangeExp *exp)
+{
+    fail("rango fuera de un for");
+    return -1;
+}
+
+int ThreadedCompiler::visit(RunExp *exp)
+{
+    fail("expresion run");
+    return -1;
+}
+
+int ThreadedCompiler::visit(FunctionCallExp *exp)
+{
+    // Las globales todavía no están todas declaradas mientras se inicializan
+    if (!function)
+        fail("llamada en el inicializador de una global");
+    compileArguments(exp);
+    bool memo = exp->decl->isPure && exp->decl->returnTypeCode > 0;
+    emit(memo ? OP_CALL_MEMO : OP_CALL, functionIndex[exp->decl]);
+    int type = exp->decl->returnTypeCode > 0 ? exp->decl->returnTypeCode : 1;
+    push(type);
+    return type;
+}
+
+int ThreadedCompiler::visit(UnaryExp *exp)
+{
+    if (isOperatorNode(exp))
+        return compileExp(exp);
+
+    IdentifierExp *id = dynamic_cast<IdentifierExp *>(exp->expr);
+    if (!id)
+        fail("incremento sobre algo que no es una variable");
+    Slot slot = lookup(id->name);
+    if (slot.type != 1 && slot.type != 2)
+        fail("incremento de una variable que no es Int ni Float");
+
+    int delta = (exp->op == UnaryExp::PRE_INC_OP || exp->op == UnaryExp::POST_INC_OP) ? 1 : -1;
+    bool post = exp->op == UnaryExp::POST_INC_OP || exp->op == UnaryExp::POST_DEC_OP;
+    if (post)
+        load(slot);
+    compileUpdate(id->name, delta > 0 ? AssignStatement::INCREMENT_OP : AssignStatement::DECREMENT_OP, nullptr);
+    if (!post)
+        load(slot);
+    return slot.type;
+}
+
+// Asignación compuesta con la semántica de EvalVisitor: primero se evalúa el
+// lado derecho y después se lee el valor actual de la variable.
+void ThreadedCompiler::compileUpdate(const string &id, int op, Exp *rhs)
+{
+    Slot slot = lookup(id);
+    int type = slot.type;
+
+    if (op == AssignStatement::INCREMENT_OP || op == AssignStatement::DECREMENT_OP ||
+        op == AssignStatement::POST_INCREMENT_OP || op == AssignStatement::POST_DECREMENT_OP)
+    {
+        int delta = (op == AssignStatement::INCREMENT_OP || op == AssignStatement::POST_INCREMENT_OP) ? 1 : -1;
+        if (type == 1 && !slot.global)
+        {
+            emit(OP_INC_LOCAL, slot.index, delta);
+        }
+        else if (type == 1 || type == 2)
+        {
+            load(slot);
+            if (type == 1)
+                emit(OP_PUSH_INT, delta);
+            else
+                emit(OP_PUSH_FLOAT, 0, 0, 0, (float)delta);
+            emit(type == 1 ? OP_ADD_I : OP_ADD_F);
+            store(slot);
+        }
+        return;
+    }
+
+    int value = compileExp(rhs);
+    if (!checkCompound(slot, op, value))
+    {
+        // Las demás combinaciones no cambian la variable
+        emit(pop() == 5 ? OP_POP_S : OP_POP);
+        return;
+    }
+    if (type == 5)
+    {
+        if (value != 5)
+            toString(value);
+        load(slot);
+        emit(OP_CONCAT_INV);
+        pop();
+        store(slot);
+        return;
+    }
+
+    convert(value, type);
+    load(slot);
+    int opIndex = 0;
+    switch (op)
+    {
+    case AssignStatement::PLUS_ASSIGN_OP:
+        opIndex = 0;
+        break;
+    case AssignStatement::MINUS_ASSIGN_OP:
+        opIndex = 1;
+        break;
+    case AssignStatement::MUL_ASSIGN_OP:
+        opIndex = 2;
+        break;
+    case AssignStatement::DIV_ASSIGN_OP:
+        opIndex = 3;
+        break;
+    default:
+        opIndex = 4;
+        break;
+    }
+    static const int intOps[] = {OP_ADD_I, OP_SUB_I, OP_MUL_I, OP_DIV_I, OP_MOD_I};
+    static const int floatOps[] = {OP_ADD_F, OP_SUB_F, OP_MUL_F, OP_DIV_F, OP_MOD_F};
+    if (opIndex != 0 && opIndex != 2)
+        emit(OP_SWAP);
+    emit(type == 1 ? intOps[opIndex] : floatOps[opIndex]);
+    pop();
+    store(slot);
+}
+
+void ThreadedCompiler::visit(AssignStatement *stm)
+{
+    if (stm->op != AssignStatement::ASSIGN_OP)
+    {
+        compileUpdate(stm->id, stm->op, stm->rhs);
+        return;
+    }
+
+    Slot slot = lookup(stm->id);
+    int value = compileExp(stm->rhs);
+    checkAssign(stm->id, slot, value);
+    convert(value, slot.type);
+    store(slot);
+}
+
+void ThreadedCompiler::visit(PrintStatement *stm)
+{
+    int type = compileExp(stm->e);
+    static const int printOps[] = {-1, OP_PRINT_I, OP_PRINT_F, OP_PRINT_B, -1, OP_PRINT_S};
+    if (type <= 0 || type > 5 || printOps[type] < 0)
+        fail("print de un valor no soportado");
+    pop();
+    emit(printOps[type], stm->newline ? 1 : 0);
+}
+
+void ThreadedCompiler::visit(ExpressionStatement *stm)
+{
+    compileExp(stm->expr);
+    emit(pop() == 5 ? OP_POP_S : OP_POP);
+}
+
+void ThreadedCompiler::compileBody(Stm *stm)
+{
+    if (Block *block = dynamic_cast<Block *>(stm))
+    {
+        scopes.push_back(unordered_map<string, Slot>());
+        for (auto s : block->statements->stms)
+            s->accept(this);
+        scopes.pop_back();
+    }
+    else
+    {
+        stm->accept(this);
+    }
+}
+
+void ThreadedCompiler::visit(IfStatement *stm)
+{
+    compileCondition(stm->condition);
+    int skipThen = emit(OP_JUMP_IF_FALSE);
+    compileBody(stm->thenStmt);
+    if (stm->elseStmt)
+    {
+        int skipElse = emit(OP_JUMP);
+        patch(skipThen);
+        compileBody(stm->elseStmt);
+        patch(skipElse);
+    }
+    else
+    {
+        patch(skipThen);
+    }
+}
+
+void ThreadedCompiler::visit(WhileStatement *stm)
+{
+    int toCondition = emit(OP_JUMP);
+    int body = out.code.size();
+    loops.push_back(Loop());
+    compileBody(stm->stmt);
+    int condition = out.code.size();
+    patch(toCondition);
+    compileCondition(stm->condition);
+    emit(OP_JUMP_IF_TRUE, body);
+
+    for (int at : loops.back().breaks)
+        patch(at);
+    for (int at : loops.back().continues)
+        out.code[at].a = condition;
+    loops.pop_back();
+}
+
+void ThreadedCompiler::visit(DoWhileStatement *stm)
+{
+    int body = out.code.size();
+    loops.push_back(Loop());
+    compileBody(stm->stmt);
+    int condition = out.code.size();
+    compileCondition(stm->condition);
+    emit(OP_JUMP_IF_TRUE, body);
+
+    for (int at : loops.back().breaks)
+        patch(at);
+    for (int at : loops.back().continues)
+        out.code[at].a = condition;
+    loops.pop_back();
+}
+
+// El contador, el límite y el paso viven en tres ranuras ocultas; la variable
+// del for se declara en el nivel actual y recibe el contador en cada vuelta,
+// como env.update en el intérprete.
+void ThreadedCompiler::visit(ForStatement *stm)
+{
+    RangeExp *range = dynamic_cast<RangeExp *>(stm->range);
+    if (!range || scopes.empty())
+        fail("for que no recorre un rango");
+
+    Exp *bounds[] = {range->start, range->end, range->step};
+    for (Exp *bound : bounds)
+    {
+        if (!bound)
+        {
+            emit(OP_PUSH_INT, 1);
+            push(1);
+            continue;
+        }
+        int type = compileExp(bound);
+        if (type != 1 && type != 3)
+            fail("limite de rango que no es Int");
+    }
+    pop();
+    pop();
+    pop();
+
+    int hidden = localCells;
+    localCells += 3;
+    int init = emit(range->downTo ? OP_FOR_INIT_DOWN : OP_FOR_INIT_UP, hidden, range->until ? 1 : 0);
+    Slot var = declare(stm->id, 1);
+    emit(OP_LOAD, hidden);
+    push(1);
+    store(var);
+    int test = emit(range->downTo ? OP_FOR_TEST_DOWN : OP_FOR_TEST_UP, hidden, var.index);
+
+    int body = out.code.size();
+    loops.push_back(Loop());
+    compileBody(stm->stmt);
+    int step = emit(range->downTo ? OP_FOR_STEP_DOWN : OP_FOR_STEP_UP, hidden, var.index, body);
+
+    int exit = out.code.size();
+    out.code[init].c = exit;
+    out.code[test].c = exit;
+    for (int at : loops.back().breaks)
+        patch(at);
+    for (int at : loops.back().continues)
+        out.code[at].a = step;
+    loops.pop_back();
+}
+
+void ThreadedCompiler::visit(VarDec *stm)
+{
+    int type = typeCode(stm->type);
+    if (stm->value)
+    {
+        int value = compileExp(stm->value);
+        checkVarDec(stm, value);
+        convert(value, type);
+    }
+    else if (type == 5)
+    {
+        emit(OP_PUSH_STR, out.strings.size());
+        out.strings.push_back("");
+        push(5);
+    }
+    else if (type == 2)
+    {
+        emit(OP_PUSH_FLOAT, 0, 0, 0, 0.0f);
+        push(2);
+    }
+    else
+    {
+        emit(OP_PUSH_INT, 0);
+        push(type);
+    }
+    store(declare(stm->id, type));
+}
+
+void ThreadedCompiler::visit(VarDecList *stm)
+{
+    for (auto dec : stm->decls)
+        dec->accept(this);
+}
+
+void ThreadedCompiler::visit(StatementList *stm)
+{
+    for (auto s : stm->stms)
+        s->accept(this);
+}
+
+// Un bloque suelto solo se ejecuta dentro de un if o un bucle del llamador
+void ThreadedCompiler::visit(Block *stm)
+{
+    fail("bloque suelto");
+}
+
+void ThreadedCompiler::visit(RunBlock *stm)
+{
+    fail("bloque run");
+}
+
+void ThreadedCompiler::visit(FunctionDecl *stm)
+{
+    fail("funcion anidada");
+}
+
+void ThreadedCompiler::visit(ReturnStatement *stm)
+{
+    FunctionDecl *func = function;
+    if (!func)
+        fail("return fuera de una funcion");
+
+    FunctionCallExp *call = dynamic_cast<FunctionCallExp *>(stm->expr);
+    if (call && call->decl == func)
+    {
+        compileArguments(call);
+        emit(OP_TAIL_CALL, functionIndex[func]);
+        return;
+    }
+
+    int returnType = func->returnTypeCode;
+    if (returnType == 0)
+    {
+        if (stm->expr)
+        {
+            compileExp(stm->expr);
+            emit(pop() == 5 ? OP_POP_S : OP_POP);
+        }
+        emit(OP_PUSH_INT, 0);
+        emit(OP_RETURN);
+        return;
+    }
+
+    if (!stm->expr)
+        fail("return sin valor en '" + func->name + "'");
+    checkReturn(compileExp(stm->expr));
+    pop();
+    emit(returnType == 5 ? OP_RETURN_S : OP_RETURN);
+}
+
+void ThreadedCompiler::visit(BreakStatement *stm)
+{
+    if (loops.empty())
+        fail("break fuera de un bucle");
+    loops.back().breaks.push_back(emit(OP_JUMP));
+}
+
+void ThreadedCompiler::visit(ContinueStatement *stm)
+{
+    if (loops.empty())
+        fail("continue fuera de un bucle");
+    loops.back().continues.push_back(emit(OP_JUMP));
+}
+
+bool ThreadedEngine::compilar(Program *programa)
+{
+    program = ThreadedCode();
+    ThreadedCompiler compiler(program);
+    try
+    {
+        compiler.compilar(programa);
+    }
+    catch (const runtime_error &e)
+    {
+        motivo = e.what();
+        compilado = false;
+        return false;
+    }
+    compilado = true;
+    return true;
+}
+
+void ThreadedEngine::imprimirPerfil()
+{
+    if (!compilado)
+    {
+        cout << "Motor enhebrado: no disponible (" << motivo << ")" << endl;
+        return;
+    }
+    cout << "Motor enhebrado: " << program.code.size() << " instrucciones, despacho por "
+#ifdef THREADED_COMPUTED_GOTO
+         << "goto calculado"
+#else
+         << "switch"
+#endif
+         << endl;
+    cout << "Memoizacion (" << MemoTable::SIZE << " entradas): " << memo.hits << " aciertos, "
+         << memo.misses << " fallos" << endl;
+}
+
+void ThreadedEngine::ejecutar()
+{
+    cout << endl;
+
+    vector<SlotCell> cells(1 << 16);
+    vector<string> strings(1 << 10);
+    vector<SlotCell> globalCells(program.globalCells);
+    vector<string> globalStrings(program.globalStrings);
+    vector<Frame> frames;
+    vector<MemoCall> memoCalls;
+    bool memoCall = false;
+    memo.reset();
+    const vector<ThreadedFunction> &functions = program.functions;
+    const vector<string> &constants = program.strings;
+
+    ThreadedInstr *code = program.code.data();
+    ThreadedInstr *pc = code;
+    SlotCell *fp = cells.data();
+    SlotCell *sp = fp;
+    string *sfp = strings.data();
+    string *ssp = sfp;
+    if ((size_t)functions[0].frameCells > cells.size())
+        cells.resize(functions[0].frameCells);
+    if ((size_t)functions[0].frameStrings > strings.size())
+        strings.resize(functions[0].frameStrings);
+    fp = sp = cells.data();
+    sfp = ssp = strings.data();
+    SlotCell *globals = globalCells.data();
+    string *sglobals = globalStrings.data();
+
+#ifdef THREADED_COMPUTED_GOTO
+#define THREADED_LABEL(name) &&L_##name,
+    static const void *const labels[OP_COUNT] = {THREADED_OPS(THREADED_LABEL)};
+#undef THREADED_LABEL
+    for (auto &instr : program.code)
+        instr.handler = labels[instr.op];
+#define TARGET(name) L_##name:
+#define DISPATCH() goto *pc->handler
+#else
+#define TARGET(name) case OP_##name:
+#define DISPATCH() goto dispatch
+#endif
+#define NEXT()    \
+    do            \
+    {             \
+        pc++;     \
+        DISPATCH(); \
+    } while (0)
+#define JUMP_TO(target)      \
+    do                       \
+    {                        \
+        pc = code + (target); \
+        DISPATCH();          \
+    } while (0)
+#define INT_BINARY(expr)         \
+    do                           \
+    {                            \
+        int r = sp[-1].i;        \
+        int l = sp[-2].i;        \
+        sp[-2].i = (expr);       \
+        sp--;                    \
+        NEXT();                  \
+    } while (0)
+#define FLOAT_BINARY(expr)   \
+    do                       \
+    {                        \
+        float r = sp[-1].f;  \
+        float l = sp[-2].f;  \
+        sp[-2].f = (expr);   \
+        sp--;                \
+        NEXT();              \
+    } while (0)
+#define FLOAT_COMPARE(expr)  \
+    do                       \
+    {                        \
+        float r = sp[-1].f;  \
+        float l = sp[-2].f;  \
+        sp[-2].i = (expr);   \
+        sp--;                \
+        NEXT();              \
+    } while (0)
+
+#ifdef THREADED_COMPUTED_GOTO
+    DISPATCH();
+#else
+dispatch:
+    switch (pc->op)
+    {
+#endif
+    TARGET(PUSH_INT)
+    sp->i = pc->a;
+    sp++;
+    NEXT();
+    TARGET(PUSH_FLOAT)
+    sp->f = pc->f;
+    sp++;
+    NEXT();
+    TARGET(PUSH_STR)
+    *ssp++ = constants[pc->a];
+    NEXT();
+    TARGET(POP)
+    sp--;
+    NEXT();
+    TARGET(POP_S)
+    ssp--;
+    NEXT();
+    TARGET(SWAP)
+    swap(sp[-1], sp[-2]);
+    NEXT();
+    TARGET(LOAD)
+    *sp++ = fp[pc->a];
+    NEXT();
+    TARGET(STORE)
+    fp[pc->a] = *--sp;
+    NEXT();
+    TARGET(LOAD_S)
+    *ssp++ = sfp[pc->a];
+    NEXT();
+    TARGET(STORE_S)
+    sfp[pc->a] = std::move(*--ssp);
+    NEXT();
+    TARGET(LOAD_GLOBAL)
+    *sp++ = globals[pc->a];
+    NEXT();
+    TARGET(STORE_GLOBAL)
+    globals[pc->a] = *--sp;
+    NEXT();
+    TARGET(LOAD_GLOBAL_S)
+    *ssp++ = sglobals[pc->a];
+    NEXT();
+    TARGET(STORE_GLOBAL_S)
+    sglobals[pc->a] = std::move(*--ssp);
+    NEXT();
+    TARGET(INC_LOCAL)
+    fp[pc->a].i += pc->b;
+    NEXT();
+    TARGET(I2F)
+    sp[-1].f = (float)sp[-1].i;
+    NEXT();
+    TARGET(I2F_UNDER)
+    sp[-2].f = (float)sp[-2].i;
+    NEXT();
+    TARGET(F2I)
+    sp[-1].i = (int)sp[-1].f;
+    NEXT();
+    TARGET(TO_BOOL)
+    sp[-1].i = sp[-1].i != 0;
+    NEXT();
+    TARGET(ADD_I)
+    INT_BINARY(l + r);
+    TARGET(SUB_I)
+    INT_BINARY(l - r);
+    TARGET(MUL_I)
+    INT_BINARY(l * r);
+    TARGET(DIV_I)
+    INT_BINARY(l / r);
+    TARGET(MOD_I)
+    INT_BINARY(l % r);
+    TARGET(NEG_I)
+    sp[-1].i = -sp[-1].i;
+    NEXT();
+    TARGET(ADD_F)
+    FLOAT_BINARY(l + r);
+    TARGET(SUB_F)
+    FLOAT_BINARY(l - r);
+    TARGET(MUL_F)
+    FLOAT_BINARY(l * r);
+    TARGET(DIV_F)
+    FLOAT_BINARY(l / r);
+    TARGET(MOD_F)
+    FLOAT_BINARY(fmod(l, r));
+    TARGET(NEG_F)
+    sp[-1].f = -sp[-1].f;
+    NEXT();
+    TARGET(LT_I)
+    INT_BINARY(l < r);
+    TARGET(LE_I)
+    INT_BINARY(l <= r);
+    TARGET(GT_I)
+    INT_BINARY(l > r);
+    TARGET(GE_I)
+    INT_BINARY(l >= r);
+    TARGET(EQ_I)
+    INT_BINARY(l == r);
+    TARGET(NE_I)
+    INT_BINARY(l != r);
+    TARGET(LT_F)
+    FLOAT_COMPARE(l < r);
+    TARGET(LE_F)
+    FLOAT_COMPARE(l <= r);
+    TARGET(GT_F)
+    FLOAT_COMPARE(l > r);
+    TARGET(GE_F)
+    FLOAT_COMPARE(l >= r);
+    TARGET(EQ_F)
+    FLOAT_COMPARE(l == r);
+    TARGET(NE_F)
+    FLOAT_COMPARE(l != r);
+    TARGET(EQ_S)
+    sp->i = ssp[-2] == ssp[-1];
+    sp++;
+    ssp -= 2;
+    NEXT();
+    TARGET(NE_S)
+    sp->i = ssp[-2] != ssp[-1];
+    sp++;
+    ssp -= 2;
+    NEXT();
+    TARGET(NOT)
+    sp[-1].i = !sp[-1].i;
+    NEXT();
+    TARGET(STR_I)
+    *ssp++ = to_string((--sp)->i);
+    NEXT();
+    TARGET(STR_F)
+    *ssp++ = formatFloat((--sp)->f);
+    NEXT();
+    TARGET(STR_B)
+    *ssp++ = (--sp)->i ? "true" : "false";
+    NEXT();
+    TARGET(CONCAT)
+    ssp[-2] += ssp[-1];
+    ssp--;
+    NEXT();
+    TARGET(CONCAT_INV)
+    ssp[-2].insert(0, ssp[-1]);
+    ssp--;
+    NEXT();
+    TARGET(JUMP)
+    JUMP_TO(pc->a);
+    TARGET(JUMP_IF_FALSE)
+    if (!(--sp)->i)
+        JUMP_TO(pc->a);
+    NEXT();
+    TARGET(JUMP_IF_TRUE)
+    if ((--sp)->i)
+        JUMP_TO(pc->a);
+    NEXT();
+    TARGET(JUMP_IF_FALSE_KEEP)
+    if (!sp[-1].i)
+        JUMP_TO(pc->a);
+    sp--;
+    NEXT();
+    TARGET(JUMP_IF_TRUE_KEEP)
+    if (sp[-1].i)
+        JUMP_TO(pc->a);
+    sp--;
+    NEXT();
+    TARGET(FOR_INIT_UP)
+    TARGET(FOR_INIT_DOWN)
+    {
+        int start = sp[-3].i;
+        int end = sp[-2].i;
+        int step = sp[-1].i;
+        sp -= 3;
+        if (step == 0)
+        {
+            salidaPrograma.escribir("Error: step no puede ser 0 en un rango\n");
+            JUMP_TO(pc->c);
+        }
+        SlotCell *loop = fp + pc->a;
+        loop[0].i = start;
+        if (pc->op == OP_FOR_INIT_DOWN)
+        {
+            loop[1].i = pc->b ? end : end - 1;
+            loop[2].i = step > 0 ? -step : step;
+        }
+        else
+        {
+            loop[1].i = pc->b ? end : end + 1;
+            loop[2].i = step;
+        }
+        NEXT();
+    }
+    TARGET(FOR_TEST_UP)
+    if (fp[pc->a].i < fp[pc->a + 1].i)
+    {
+        fp[pc->b].i = fp[pc->a].i;
+        NEXT();
+    }
+    JUMP_TO(pc->c);
+    TARGET(FOR_TEST_DOWN)
+    if (fp[pc->a].i > fp[pc->a + 1].i)
+    {
+        fp[pc->b].i = fp[pc->a].i;
+        NEXT();
+    }
+    JUMP_TO(pc->c);
+    TARGET(FOR_STEP_UP)
+    {
+        SlotCell *loop = fp + pc->a;
+        loop[0].i += loop[2].i;
+        if (loop[0].i < loop[1].i)
+        {
+            fp[pc->b].i = loop[0].i;
+            JUMP_TO(pc->c);
+        }
+        NEXT();
+    }
+    TARGET(FOR_STEP_DOWN)
+    {
+        SlotCell *loop = fp + pc->a;
+        loop[0].i += loop[2].i;
+        if (loop[0].i > loop[1].i)
+        {
+            fp[pc->b].i = loop[0].i;
+            JUMP_TO(pc->c);
+        }
+        NEXT();
+    }
+    TARGET(CALL)
+    memoCall = false;
+call:
+    {
+        const ThreadedFunction &func = functions[pc->a];
+        size_t newFp = (sp - cells.data()) - func.paramCells;
+        size_t newSfp = (ssp - strings.data()) - func.paramStrings;
+        // La pila crece en el llamado: se recalculan los punteros al nuevo bloque
+        if (newFp + func.frameCells > cells.size())
+        {
+            size_t fpOffset = fp - cells.data();
+            cells.resize(max(cells.size() * 2, newFp + func.frameCells));
+            fp = cells.data() + fpOffset;
+        }
+        if (newSfp + func.frameStrings > strings.size())
+        {
+            size_t sfpOffset = sfp - strings.data();
+            strings.resize(max(strings.size() * 2, newSfp + func.frameStrings));
+            sfp = strings.data() + sfpOffset;
+        }
+        frames.push_back({pc + 1, (size_t)(fp - cells.data()), (size_t)(sfp - strings.data()), memoCall});
+        fp = cells.data() + newFp;
+        sp = fp + func.localCells;
+        sfp = strings.data() + newSfp;
+        ssp = sfp + func.localStrings;
+        JUMP_TO(func.entry);
+    }
+    TARGET(CALL_MEMO)
+    {
+        const ThreadedFunction &func = functions[pc->a];
+        SlotCell *args = sp - func.paramCells;
+        string *sargs = ssp - func.paramStrings;
+        size_t slot = memo.slot(pc->a, args, func.paramCells, sargs, func.paramStrings);
+        if (memo.matches(slot, pc->a, args, func.paramCells, sargs, func.paramStrings))
+        {
+            MemoTable::Entry &entry = memo[slot];
+            memo.hits++;
+            sp = args;
+            ssp = sargs;
+            if (func.decl->returnTypeCode == 5)
+                *ssp++ = entry.stringResult;
+            else
+                *sp++ = entry.result;
+            NEXT();
+        }
+        memo.misses++;
+        memoCalls.push_back({slot, pc->a, vector<SlotCell>(args, sp), vector<string>(sargs, ssp)});
+        memoCall = true;
+        goto call;
+    }
+    TARGET(TAIL_CALL)
+    {
+        const ThreadedFunction &func = functions[pc->a];
+        SlotCell *args = sp - func.paramCells;
+        for (int i = 0; i < func.paramCells; i++)
+            fp[i] = args[i];
+        string *sargs = ssp - func.paramStrings;
+        for (int i = 0; i < func.paramStrings; i++)
+            sfp[i] = std::move(sargs[i]);
+        sp = fp + func.localCells;
+        ssp = sfp + func.localStrings;
+        JUMP_TO(func.entry);
+    }
+    TARGET(RETURN)
+    {
+        SlotCell value = sp[-1];
+        const Frame &frame = frames.back();
+        if (frame.memo)
+        {
+            MemoCall &pending = memoCalls.back();
+            MemoTable::Entry &entry = memo[pending.slot];
+            entry.func = pending.func;
+            entry.cells.swap(pending.cells);
+            entry.strings.swap(pending.strings);
+            entry.result = value;
+            memoCalls.pop_back();
+        }
+        pc = frame.ret;
+        sp = fp;
+        *sp++ = value;
+        ssp = sfp;
+        fp = cells.data() + frame.fp;
+        sfp = strings.data() + frame.sfp;
+        frames.pop_back();
+        DISPATCH();
+    }
+    TARGET(RETURN_S)
+    {
+        string value = std::move(ssp[-1]);
+        const Frame &frame = frames.back();
+        if (frame.memo)
+        {
+            MemoCall &pending = memoCalls.back();
+            MemoTable::Entry &entry = memo[pending.slot];
+            entry.func = pending.func;
+            entry.cells.swap(pending.cells);
+            entry.strings.swap(pending.strings);
+            entry.stringResult = value;
+            memoCalls.pop_back();
+        }
+        pc = frame.ret;
+        sp = fp;
+        ssp = sfp;
+        *ssp++ = std::move(value);
+        fp = cells.data() + frame.fp;
+        sfp = strings.data() + frame.sfp;
+        frames.pop_back();
+        DISPATCH();
+    }
+    TARGET(PRINT_I)
+    salidaPrograma.escribirEntero((--sp)->i);
+    if (pc->a)
+        salidaPrograma.saltoDeLinea();
+    NEXT();
+    TARGET(PRINT_F)
+    salidaPrograma.escribirFlotante((--sp)->f);
+    if (pc->a)
+        salidaPrograma.saltoDeLinea();
+    NEXT();
+    TARGET(PRINT_B)
+    salidaPrograma.escribirBooleano((--sp)->i);
+    if (pc->a)
+        salidaPrograma.saltoDeLinea();
+    NEXT();
+    TARGET(PRINT_S)
+    salidaPrograma.escribir(*--ssp);
+    if (pc->a)
+        salidaPrograma.saltoDeLinea();
+    NEXT();
+    TARGET(HALT)
+    goto halt;
+#ifndef THREADED_COMPUTED_GOTO
+    default:
+        goto halt;
+    }
+#endif
+
+halt:
+#undef TARGET
+#undef DISPATCH
+#undef NEXT
+#undef JUMP_TO
+#undef INT_BINARY
+#undef FLOAT_BINARY
+#undef FLOAT_COMPARE
+    salidaPrograma.vaciar();
+    cout << endl;
+}
@@ -0,0 +1,166 @@
+#ifndef THREADED_H
+#define THREADED_H
+
+#include "lowering.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Motor enhebrado: el AST se baja a un arreglo de instrucciones con la
+// dirección de su manejador y se despacha con goto calculado (etiquetas
+// como valores de GCC/Clang). En otros compiladores, o con
+// -DTHREADED_SWITCH, se usa un switch dentro de un bucle.
+#if defined(__GNUC__) && !defined(THREADED_SWITCH)
+#define THREADED_COMPUTED_GOTO 1
+#endif
+
+#define THREADED_OPS(X)                                                           \
+    X(PUSH_INT) X(PUSH_FLOAT) X(PUSH_STR) X(POP) X(POP_S) X(SWAP)                 \
+    X(LOAD) X(STORE) X(LOAD_S) X(STORE_S)                                         \
+    X(LOAD_GLOBAL) X(STORE_GLOBAL) X(LOAD_GLOBAL_S) X(STORE_GLOBAL_S) X(INC_LOCAL) \
+    X(I2F) X(I2F_UNDER) X(F2I) X(TO_BOOL)                                         \
+    X(ADD_I) X(SUB_I) X(MUL_I) X(DIV_I) X(MOD_I) X(NEG_I)                         \
+    X(ADD_F) X(SUB_F) X(MUL_F) X(DIV_F) X(MOD_F) X(NEG_F)                         \
+    X(LT_I) X(LE_I) X(GT_I) X(GE_I) X(EQ_I) X(NE_I)                               \
+    X(LT_F) X(LE_F) X(GT_F) X(GE_F) X(EQ_F) X(NE_F)                               \
+    X(EQ_S) X(NE_S) X(NOT)                                                        \
+    X(STR_I) X(STR_F) X(STR_B) X(CONCAT) X(CONCAT_INV)                            \
+    X(JUMP) X(JUMP_IF_FALSE) X(JUMP_IF_TRUE)                                      \
+    X(JUMP_IF_FALSE_KEEP) X(JUMP_IF_TRUE_KEEP)                                    \
+    X(FOR_INIT_UP) X(FOR_INIT_DOWN) X(FOR_TEST_UP) X(FOR_TEST_DOWN)               \
+    X(FOR_STEP_UP) X(FOR_STEP_DOWN)                                               \
+    X(CALL) X(CALL_MEMO) X(TAIL_CALL) X(RETURN) X(RETURN_S)                       \
+    X(PRINT_I) X(PRINT_F) X(PRINT_B) X(PRINT_S) X(HALT)
+
+enum ThreadedOp
+{
+#define THREADED_ENUM(name) OP_##name,
+    THREADED_OPS(THREADED_ENUM)
+#undef THREADED_ENUM
+    OP_COUNT
+};
+
+struct ThreadedInstr
+{
+    const void *handler = nullptr; // se completa al enlazar, antes de ejecutar
+    int op;
+    int a = 0, b = 0, c = 0;
+    float f = 0.0f;
+};
+
+struct ThreadedFunction
+{
+    FunctionDecl *decl = nullptr;
+    int entry = 0;
+    int paramCells = 0, paramStrings = 0;
+    int localCells = 0, localStrings = 0; // incluye parámetros
+    int frameCells = 0, frameStrings = 0; // locales más la pila de operandos máxima
+};
+
+struct ThreadedCode
+{
+    std::vector<ThreadedInstr> code;
+    std::vector<string> strings;
+    std::vector<ThreadedFunction> functions; // la 0 es la inicialización de globales
+    int globalCells = 0, globalStrings = 0;
+};
+
+// Baja el programa a ThreadedCode. La pila de operandos usa las mismas
+// celdas que los locales, encima de ellos.
+class ThreadedCompiler : public StaticLowering
+{
+    struct Loop
+    {
+        std::vector<int> breaks;
+        std::vector<int> continues;
+    };
+
+    ThreadedCode &out;
+    std::unordered_map<FunctionDecl *, int> functionIndex;
+    std::vector<Loop> loops;
+    std::vector<int> types;
+    std::vector<int> shortCircuit;
+    ThreadedFunction *current = nullptr;
+    int cellDepth = 0, stringDepth = 0;
+
+    int emit(int op, int a = 0, int b = 0, int c = 0, float f = 0.0f);
+    void patch(int at) { out.code[at].a = out.code.size(); }
+    void push(int type);
+    int pop();
+    void load(const Slot &slot);
+    void store(const Slot &slot);
+    int compileExp(Exp *exp);
+    void compileCondition(Exp *exp);
+    void compileBody(Stm *stm);
+    void compileFunction(FunctionDecl *func);
+    void convert(int from, int to);
+    void toString(int type);
+    void compileArguments(FunctionCallExp *call);
+    void compileUpdate(const string &id, int op, Exp *rhs);
+    void onLeaf(Exp *exp) override;
+    bool onOperand(BinaryExp *exp) override;
+    void onExit(Exp *exp) override;
+
+public:
+    ThreadedCompiler(ThreadedCode &code) : out(code) {}
+    void compilar(Program *program);
+    int visit(BinaryExp *exp) override;
+    int visit(NumberExp *exp) override;
+    int visit(DecimalExp *exp) override;
+    int visit(BoolExp *exp) override;
+    int visit(IdentifierExp *exp) override;
+    int visit(RangeExp *exp) override;
+    int visit(StringExp *exp) override;
+    int visit(ParenthesizedExp *exp) override;
+    int visit(FunctionCallExp *exp) override;
+    int visit(UnaryExp *exp) override;
+    int visit(RunExp *exp) override;
+    void visit(AssignStatement *stm) override;
+    void visit(PrintStatement *stm) override;
+    void visit(ExpressionStatement *stm) override;
+    void visit(IfStatement *stm) override;
+    void visit(WhileStatement *stm) override;
+    void visit(DoWhileStatement *stm) override;
+    void visit(ForStatement *stm) override;
+    void visit(VarDec *stm) override;
+    void visit(VarDecList *stm) override;
+    void visit(StatementList *stm) override;
+    void visit(Block *stm) override;
+    void visit(RunBlock *stm) override;
+    void visit(FunctionDecl *stm) override;
+    void visit(ReturnStatement *stm) override;
+    void visit(BreakStatement *stm) override;
+    void visit(ContinueStatement *stm) override;
+};
+
+class ThreadedEngine
+{
+    ThreadedCode program;
+    string motivo;
+    bool compilado = false;
+
+    struct Frame
+    {
+        ThreadedInstr *ret;
+        size_t fp, sfp;
+        bool memo; // al volver se guarda el resultado en memo
+    };
+
+    // Llamada memoizada en curso; al volver se guarda en memo
+    struct MemoCall
+    {
+        size_t slot;
+        int func;
+        std::vector<SlotCell> cells;
+        std::vector<string> strings;
+    };
+    MemoTable memo;
+
+public:
+    bool compilar(Program *program);
+    const string &motivoFallo() const { return motivo; }
+    void ejecutar();
+    void imprimirPerfil();
+};
+
+#endif
@@ -186,6 +186,9 @@ std::ostream &operator<<(std::ostream &outs, const Token &tok)
     case Token::FUN:
         outs << "TOKEN(FUN)";
         break;
+    case Token::TAILREC:
+        outs << "TOKEN(TAILREC)";
+        break;
     case Token::RETURN:
         outs << "TOKEN(RETURN)";
         break;
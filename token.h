@@ -58,6 +58,7 @@ public:
         FOR,
         IN,
         FUN,
+        TAILREC,
         RETURN,
         BREAK,
         CONTINUE,
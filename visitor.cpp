@@ -1,26 +1,23 @@
 #include <iostream>
 #include "exp.h"
 #include "visitor.h"
+#include "frame.h"
+#include "output.h"
 #include <iomanip>
 #include <unordered_map>
 #include <typeinfo>
 #include <cmath>
 #include <sstream>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
 using namespace std;
 
 string formatFloat(float value)
 {
-    if (value == floor(value))
-    {
-        return to_string((int)value);
-    }
-
-    string result = to_string(value);
-
-    result.erase(result.find_last_not_of('0') + 1, string::npos);
-    result.erase(result.find_last_not_of('.') + 1, string::npos);
-
-    return result;
+    char text[32];
+    return string(text, formatFloatTo(text, value));
 }
 
 int getOperatorPrecedence(BinaryOp op)
@@ -69,6 +66,96 @@ bool needsParentheses(Exp *expr, BinaryOp parentOp, bool isRightOperand)
     return false;
 }
 
+// La clase de un nodo no cambia: se resuelve con dynamic_cast una sola vez y
+// se guarda en el nodo, así los recorridos siguientes no vuelven a preguntar.
+int ExpWalker::nodeKind(Exp *exp)
+{
+    if (exp->walkKind >= 0)
+        return exp->walkKind;
+
+    int kind = LEAF_NODE;
+    if (dynamic_cast<BinaryExp *>(exp))
+        kind = BINARY_NODE;
+    else if (dynamic_cast<ParenthesizedExp *>(exp))
+        kind = PAREN_NODE;
+    else if (UnaryExp *unary = dynamic_cast<UnaryExp *>(exp))
+    {
+        if (unary->op == UnaryExp::NOT_OP || unary->op == UnaryExp::NEG_OP ||
+            unary->op == UnaryExp::POS_OP)
+            kind = UNARY_NODE;
+    }
+    exp->walkKind = kind;
+    return kind;
+}
+
+bool ExpWalker::isOperatorNode(Exp *exp)
+{
+    return nodeKind(exp) != LEAF_NODE;
+}
+
+void ExpWalker::walk(Exp *root)
+{
+    struct Frame
+    {
+        Exp *exp;
+        int kind;
+        int stage;
+    };
+
+    int rootKind = nodeKind(root);
+    if (rootKind == LEAF_NODE)
+    {
+        onLeaf(root);
+        return;
+    }
+
+    vector<Frame> frames;
+    onEnter(root);
+    frames.push_back({root, rootKind, 0});
+
+    while (!frames.empty())
+    {
+        Frame &top = frames.back();
+        Exp *child = nullptr;
+
+        if (top.kind == BINARY_NODE)
+        {
+            BinaryExp *bin = static_cast<BinaryExp *>(top.exp);
+            if (top.stage == 0)
+                child = bin->left;
+            else if (top.stage == 1 && onOperand(bin))
+                child = bin->right;
+        }
+        else if (top.stage == 0)
+        {
+            if (top.kind == PAREN_NODE)
+                child = static_cast<ParenthesizedExp *>(top.exp)->expr;
+            else
+                child = static_cast<UnaryExp *>(top.exp)->expr;
+        }
+        top.stage++;
+
+        if (child == nullptr)
+        {
+            Exp *done = top.exp;
+            frames.pop_back();
+            onExit(done);
+            continue;
+        }
+
+        int childKind = nodeKind(child);
+        if (childKind != LEAF_NODE)
+        {
+            onEnter(child);
+            frames.push_back({child, childKind, 0});
+        }
+        else
+        {
+            onLeaf(child);
+        }
+    }
+}
+
 int BinaryExp::accept(Visitor *visitor)
 {
     return visitor->visit(this);
@@ -198,33 +285,64 @@ int ContinueStatement::accept(Visitor *visitor)
 
 int PrintVisitor::visit(BinaryExp *exp)
 {
-    bool leftNeedsParens = needsParentheses(exp->left, exp->op, false);
-    if (leftNeedsParens && !dynamic_cast<ParenthesizedExp *>(exp->left))
+    walk(exp);
+    return 0;
+}
+
+void PrintVisitor::onLeaf(Exp *exp)
+{
+    exp->accept(this);
+}
+
+void PrintVisitor::onEnter(Exp *exp)
+{
+    if (BinaryExp *bin = dynamic_cast<BinaryExp *>(exp))
+    {
+        bool leftNeedsParens = needsParentheses(bin->left, bin->op, false);
+        if (leftNeedsParens && !dynamic_cast<ParenthesizedExp *>(bin->left))
+            cout << "(";
+    }
+    else if (dynamic_cast<ParenthesizedExp *>(exp))
     {
         cout << "(";
-        exp->left->accept(this);
-        cout << ")";
     }
-    else
+    else if (UnaryExp *unary = dynamic_cast<UnaryExp *>(exp))
     {
-        exp->left->accept(this);
+        if (unary->op == UnaryExp::NOT_OP)
+            cout << "!";
+        else if (unary->op == UnaryExp::NEG_OP)
+            cout << "-";
+        else if (unary->op == UnaryExp::POS_OP)
+            cout << "+";
     }
+}
+
+bool PrintVisitor::onOperand(BinaryExp *exp)
+{
+    bool leftNeedsParens = needsParentheses(exp->left, exp->op, false);
+    if (leftNeedsParens && !dynamic_cast<ParenthesizedExp *>(exp->left))
+        cout << ")";
 
     cout << ' ' << Exp::binopToChar(exp->op) << ' ';
 
     bool rightNeedsParens = needsParentheses(exp->right, exp->op, true);
     if (rightNeedsParens && !dynamic_cast<ParenthesizedExp *>(exp->right))
-    {
         cout << "(";
-        exp->right->accept(this);
-        cout << ")";
+    return true;
+}
+
+void PrintVisitor::onExit(Exp *exp)
+{
+    if (BinaryExp *bin = dynamic_cast<BinaryExp *>(exp))
+    {
+        bool rightNeedsParens = needsParentheses(bin->right, bin->op, true);
+        if (rightNeedsParens && !dynamic_cast<ParenthesizedExp *>(bin->right))
+            cout << ")";
     }
-    else
+    else if (dynamic_cast<ParenthesizedExp *>(exp))
     {
-        exp->right->accept(this);
+        cout << ")";
     }
-
-    return 0;
 }
 
 int PrintVisitor::visit(NumberExp *exp)
@@ -283,9 +401,7 @@ int PrintVisitor::visit(StringExp *exp)
 
 int PrintVisitor::visit(ParenthesizedExp *exp)
 {
-    cout << "(";
-    exp->expr->accept(this);
-    cout << ")";
+    walk(exp);
     return 0;
 }
 
@@ -309,16 +425,9 @@ int PrintVisitor::visit(UnaryExp *exp)
     switch (exp->op)
     {
     case UnaryExp::NOT_OP:
-        cout << "!";
-        exp->expr->accept(this);
-        break;
     case UnaryExp::NEG_OP:
-        cout << "-";
-        exp->expr->accept(this);
-        break;
     case UnaryExp::POS_OP:
-        cout << "+";
-        exp->expr->accept(this);
+        walk(exp);
         break;
     case UnaryExp::PRE_INC_OP:
         cout << "++";
@@ -557,6 +666,8 @@ void PrintVisitor::visit(RunBlock *stm)
 void PrintVisitor::visit(FunctionDecl *stm)
 {
     imprimirIndentacion();
+    if (stm->isTailrec)
+        cout << "tailrec ";
     cout << "fun " << stm->name << "(";
 
     bool first = true;
@@ -603,195 +714,546 @@ void PrintVisitor::visit(ContinueStatement *stm)
 
 static int evalTypeFromEnv(Environment &env, string name)
 {
-    string strtype = env.lookup_type(name);
-    if (strtype == "Int")
-        return 1;
-    if (strtype == "Float")
-        return 2;
-    if (strtype == "Boolean")
-        return 3;
-    if (strtype == "String")
-        return 5;
-    return -1;
+    return typeCode(env.lookup_type(name));
 }
 
-int EvalVisitor::visit(BinaryExp *exp)
+EvalValue evalBinaryOp(int op, const EvalValue &left, const EvalValue &right)
 {
-    int leftType = exp->left->accept(this);
-    int leftInt = lastInt;
-    float leftFloat = lastFloat;
-    string leftString = lastString;
+    EvalValue result = right;
 
-    int rightType = exp->right->accept(this);
-    int rightInt = lastInt;
-    float rightFloat = lastFloat;
-    string rightString = lastString;
-
-    switch (exp->op)
+    switch (op)
     {
     case PLUS_OP:
-        if (leftType == 5 || rightType == 5)
+        if (left.type == 5 || right.type == 5)
         {
-            lastType = 5;
+            result.type = 5;
             string left_str;
             string right_str;
 
-            if (leftType == 5)
+            if (left.type == 5)
             {
-                left_str = leftString;
+                left_str = left.stringValue;
             }
-            else if (leftType == 3)
+            else if (left.type == 3)
             {
-                left_str = leftInt ? "true" : "false";
+                left_str = left.intValue ? "true" : "false";
             }
-            else if (leftType == 2)
+            else if (left.type == 2)
             {
-                left_str = formatFloat(leftFloat);
+                left_str = formatFloat(left.floatValue);
             }
             else
             {
-                left_str = to_string(leftInt);
+                left_str = to_string(left.intValue);
             }
 
-            if (rightType == 5)
+            if (right.type == 5)
             {
-                right_str = rightString;
+                right_str = right.stringValue;
             }
-            else if (rightType == 3)
+            else if (right.type == 3)
             {
-                right_str = rightInt ? "true" : "false";
+                right_str = right.intValue ? "true" : "false";
             }
-            else if (rightType == 2)
+            else if (right.type == 2)
             {
-                right_str = formatFloat(rightFloat);
+                right_str = formatFloat(right.floatValue);
             }
             else
             {
-                right_str = to_string(rightInt);
+                right_str = to_string(right.intValue);
             }
 
-            lastString = left_str + right_str;
+            result.stringValue = left_str + right_str;
         }
-        else if (leftType == 1 && rightType == 1)
+        else if (left.type == 1 && right.type == 1)
         {
-            lastType = 1;
-            lastInt = leftInt + rightInt;
+            result.type = 1;
+            result.intValue = left.intValue + right.intValue;
         }
-        else if (leftType == 2 || rightType == 2)
+        else if (left.type == 2 || right.type == 2)
         {
-            lastType = 2;
-            lastFloat = (leftType == 2 ? leftFloat : leftInt) + (rightType == 2 ? rightFloat : rightInt);
+            result.type = 2;
+            result.floatValue = (left.type == 2 ? left.floatValue : left.intValue) + (right.type == 2 ? right.floatValue : right.intValue);
         }
         break;
     case MINUS_OP:
-        if (leftType == 1 && rightType == 1)
+        if (left.type == 1 && right.type == 1)
         {
-            lastType = 1;
-            lastInt = leftInt - rightInt;
+            result.type = 1;
+            result.intValue = left.intValue - right.intValue;
         }
-        else if (leftType == 2 || rightType == 2)
+        else if (left.type == 2 || right.type == 2)
         {
-            lastType = 2;
-            lastFloat = (leftType == 2 ? leftFloat : leftInt) - (rightType == 2 ? rightFloat : rightInt);
+            result.type = 2;
+            result.floatValue = (left.type == 2 ? left.floatValue : left.intValue) - (right.type == 2 ? right.floatValue : right.intValue);
         }
         break;
     case MUL_OP:
-        if (leftType == 1 && rightType == 1)
+        if (left.type == 1 && right.type == 1)
         {
-            lastType = 1;
-            lastInt = leftInt * rightInt;
+            result.type = 1;
+            result.intValue = left.intValue * right.intValue;
         }
-        else if (leftType == 2 || rightType == 2)
+        else if (left.type == 2 || right.type == 2)
         {
-            lastType = 2;
-            lastFloat = (leftType == 2 ? leftFloat : leftInt) * (rightType == 2 ? rightFloat : rightInt);
+            result.type = 2;
+            result.floatValue = (left.type == 2 ? left.floatValue : left.intValue) * (right.type == 2 ? right.floatValue : right.intValue);
         }
         break;
     case DIV_OP:
-        if (leftType == 1 && rightType == 1)
+        if (left.type == 1 && right.type == 1)
         {
-            lastType = 1;
-            lastInt = leftInt / rightInt;
+            result.type = 1;
+            result.intValue = left.intValue / right.intValue;
         }
         else
         {
-            lastType = 2;
-            lastFloat = (leftType == 2 ? leftFloat : leftInt) / (rightType == 2 ? rightFloat : rightInt);
+            result.type = 2;
+            result.floatValue = (left.type == 2 ? left.floatValue : left.intValue) / (right.type == 2 ? right.floatValue : right.intValue);
         }
         break;
     case MOD_OP:
-        if (leftType == 2 || rightType == 2)
+        if (left.type == 2 || right.type == 2)
         {
-            lastType = 2;
-            lastFloat = fmod((leftType == 2 ? leftFloat : leftInt), (rightType == 2 ? rightFloat : rightInt));
+            result.type = 2;
+            result.floatValue = fmod((left.type == 2 ? left.floatValue : left.intValue), (right.type == 2 ? right.floatValue : right.intValue));
         }
         else
         {
-            lastType = 1;
-            lastInt = leftInt % rightInt;
+            result.type = 1;
+            result.intValue = left.intValue % right.intValue;
         }
         break;
     case LT_OP:
-        lastType = 3;
-        if (leftType == 2 || rightType == 2)
-            lastInt = ((leftType == 2 ? leftFloat : leftInt) < (rightType == 2 ? rightFloat : rightInt)) ? 1 : 0;
+        result.type = 3;
+        if (left.type == 2 || right.type == 2)
+            result.intValue = ((left.type == 2 ? left.floatValue : left.intValue) < (right.type == 2 ? right.floatValue : right.intValue)) ? 1 : 0;
         else
-            lastInt = (leftInt < rightInt) ? 1 : 0;
+            result.intValue = (left.intValue < right.intValue) ? 1 : 0;
         break;
     case LE_OP:
-        lastType = 3;
-        if (leftType == 2 || rightType == 2)
-            lastInt = ((leftType == 2 ? leftFloat : leftInt) <= (rightType == 2 ? rightFloat : rightInt)) ? 1 : 0;
+        result.type = 3;
+        if (left.type == 2 || right.type == 2)
+            result.intValue = ((left.type == 2 ? left.floatValue : left.intValue) <= (right.type == 2 ? right.floatValue : right.intValue)) ? 1 : 0;
         else
-            lastInt = (leftInt <= rightInt) ? 1 : 0;
+            result.intValue = (left.intValue <= right.intValue) ? 1 : 0;
         break;
     case GT_OP:
-        lastType = 3;
-        if (leftType == 2 || rightType == 2)
-            lastInt = ((leftType == 2 ? leftFloat : leftInt) > (rightType == 2 ? rightFloat : rightInt)) ? 1 : 0;
+        result.type = 3;
+        if (left.type == 2 || right.type == 2)
+            result.intValue = ((left.type == 2 ? left.floatValue : left.intValue) > (right.type == 2 ? right.floatValue : right.intValue)) ? 1 : 0;
         else
-            lastInt = (leftInt > rightInt) ? 1 : 0;
+            result.intValue = (left.intValue > right.intValue) ? 1 : 0;
         break;
     case GE_OP:
-        lastType = 3;
-        if (leftType == 2 || rightType == 2)
-            lastInt = ((leftType == 2 ? leftFloat : leftInt) >= (rightType == 2 ? rightFloat : rightInt)) ? 1 : 0;
+        result.type = 3;
+        if (left.type == 2 || right.type == 2)
+            result.intValue = ((left.type == 2 ? left.floatValue : left.intValue) >= (right.type == 2 ? right.floatValue : right.intValue)) ? 1 : 0;
         else
-            lastInt = (leftInt >= rightInt) ? 1 : 0;
+            result.intValue = (left.intValue >= right.intValue) ? 1 : 0;
         break;
     case EQ_OP:
-        lastType = 3;
-        if (leftType == 5 && rightType == 5)
-            lastInt = (leftString == rightString) ? 1 : 0;
-        else if (leftType == 2 || rightType == 2)
-            lastInt = ((leftType == 2 ? leftFloat : leftInt) == (rightType == 2 ? rightFloat : rightInt)) ? 1 : 0;
+        result.type = 3;
+        if (left.type == 5 && right.type == 5)
+            result.intValue = (left.stringValue == right.stringValue) ? 1 : 0;
+        else if (left.type == 2 || right.type == 2)
+            result.intValue = ((left.type == 2 ? left.floatValue : left.intValue) == (right.type == 2 ? right.floatValue : right.intValue)) ? 1 : 0;
         else
-            lastInt = (leftInt == rightInt) ? 1 : 0;
+            result.intValue = (left.intValue == right.intValue) ? 1 : 0;
         break;
     case NE_OP:
-        lastType = 3;
-        if (leftType == 5 && rightType == 5)
-            lastInt = (leftString != rightString) ? 1 : 0;
-        else if (leftType == 2 || rightType == 2)
-            lastInt = ((leftType == 2 ? leftFloat : leftInt) != (rightType == 2 ? rightFloat : rightInt)) ? 1 : 0;
+        result.type = 3;
+        if (left.type == 5 && right.type == 5)
+            result.intValue = (left.stringValue != right.stringValue) ? 1 : 0;
+        else if (left.type == 2 || right.type == 2)
+            result.intValue = ((left.type == 2 ? left.floatValue : left.intValue) != (right.type == 2 ? right.floatValue : right.intValue)) ? 1 : 0;
         else
-            lastInt = (leftInt != rightInt) ? 1 : 0;
+            result.intValue = (left.intValue != right.intValue) ? 1 : 0;
         break;
     case AND_OP:
-        lastType = 3;
-        lastInt = (leftInt && rightInt) ? 1 : 0;
+        result.type = 3;
+        result.intValue = (left.intValue && right.intValue) ? 1 : 0;
         break;
     case OR_OP:
-        lastType = 3;
-        lastInt = (leftInt || rightInt) ? 1 : 0;
+        result.type = 3;
+        result.intValue = (left.intValue || right.intValue) ? 1 : 0;
         break;
     default:
-        cout << "Error: operador binario no soportado." << endl;
+        salidaPrograma.escribir("Error: operador binario no soportado.\n");
         exit(1);
     }
+    return result;
+}
+
+EvalValue evalUnaryOp(int op, const EvalValue &operand)
+{
+    EvalValue result = operand;
+    switch (op)
+    {
+    case UnaryExp::NOT_OP:
+        result.type = 3;
+        result.intValue = !operand.intValue;
+        break;
+    case UnaryExp::NEG_OP:
+        if (operand.type == 1)
+            result.intValue = -operand.intValue;
+        else if (operand.type == 2)
+            result.floatValue = -operand.floatValue;
+        break;
+    default:
+        break;
+    }
+    return result;
+}
+
+// Manejadores especializados: suponen los tipos de operandos con los que se
+// especializó el nodo y escriben el resultado sobre el operando izquierdo.
+enum QuickHandler
+{
+    QUICK_NONE,
+    QUICK_INT_ADD,
+    QUICK_INT_SUB,
+    QUICK_INT_MUL,
+    QUICK_INT_DIV,
+    QUICK_INT_MOD,
+    QUICK_INT_LT,
+    QUICK_INT_LE,
+    QUICK_INT_GT,
+    QUICK_INT_GE,
+    QUICK_INT_EQ,
+    QUICK_INT_NE,
+    QUICK_FLOAT_ADD,
+    QUICK_FLOAT_SUB,
+    QUICK_FLOAT_MUL,
+    QUICK_FLOAT_DIV,
+    QUICK_FLOAT_LT,
+    QUICK_FLOAT_LE,
+    QUICK_FLOAT_GT,
+    QUICK_FLOAT_GE,
+    QUICK_FLOAT_EQ,
+    QUICK_FLOAT_NE,
+    QUICK_BOOL_AND,
+    QUICK_BOOL_OR,
+    QUICK_STRING_CONCAT,
+    QUICK_STRING_EQ,
+    QUICK_STRING_NE,
+    QUICK_BOOL_NOT,
+    QUICK_INT_NEG,
+    QUICK_FLOAT_NEG
+};
+
+// Solo se especializan operandos del mismo tipo; las mezclas (Int con Float,
+// concatenación con números) quedan en el camino genérico.
+static int chooseBinaryHandler(int op, int leftType, int rightType)
+{
+    if (leftType != rightType)
+        return QUICK_NONE;
+
+    if (leftType == 1)
+    {
+        switch (op)
+        {
+        case PLUS_OP: return QUICK_INT_ADD;
+        case MINUS_OP: return QUICK_INT_SUB;
+        case MUL_OP: return QUICK_INT_MUL;
+        case DIV_OP: return QUICK_INT_DIV;
+        case MOD_OP: return QUICK_INT_MOD;
+        case LT_OP: return QUICK_INT_LT;
+        case LE_OP: return QUICK_INT_LE;
+        case GT_OP: return QUICK_INT_GT;
+        case GE_OP: return QUICK_INT_GE;
+        case EQ_OP: return QUICK_INT_EQ;
+        case NE_OP: return QUICK_INT_NE;
+        default: return QUICK_NONE;
+        }
+    }
+    if (leftType == 2)
+    {
+        switch (op)
+        {
+        case PLUS_OP: return QUICK_FLOAT_ADD;
+        case MINUS_OP: return QUICK_FLOAT_SUB;
+        case MUL_OP: return QUICK_FLOAT_MUL;
+        case DIV_OP: return QUICK_FLOAT_DIV;
+        case LT_OP: return QUICK_FLOAT_LT;
+        case LE_OP: return QUICK_FLOAT_LE;
+        case GT_OP: return QUICK_FLOAT_GT;
+        case GE_OP: return QUICK_FLOAT_GE;
+        case EQ_OP: return QUICK_FLOAT_EQ;
+        case NE_OP: return QUICK_FLOAT_NE;
+        default: return QUICK_NONE;
+        }
+    }
+    if (leftType == 3)
+    {
+        switch (op)
+        {
+        case AND_OP: return QUICK_BOOL_AND;
+        case OR_OP: return QUICK_BOOL_OR;
+        case EQ_OP: return QUICK_INT_EQ;
+        case NE_OP: return QUICK_INT_NE;
+        default: return QUICK_NONE;
+        }
+    }
+    if (leftType == 5)
+    {
+        switch (op)
+        {
+        case PLUS_OP: return QUICK_STRING_CONCAT;
+        case EQ_OP: return QUICK_STRING_EQ;
+        case NE_OP: return QUICK_STRING_NE;
+        default: return QUICK_NONE;
+        }
+    }
+    return QUICK_NONE;
+}
+
+static int chooseUnaryHandler(int op, int type)
+{
+    if (op == UnaryExp::NOT_OP && type == 3)
+        return QUICK_BOOL_NOT;
+    if (op == UnaryExp::NEG_OP && type == 1)
+        return QUICK_INT_NEG;
+    if (op == UnaryExp::NEG_OP && type == 2)
+        return QUICK_FLOAT_NEG;
+    return QUICK_NONE;
+}
+
+static void applyQuickHandler(int handler, EvalValue &left, const EvalValue &right)
+{
+    switch (handler)
+    {
+    case QUICK_INT_ADD: left.intValue = left.intValue + right.intValue; break;
+    case QUICK_INT_SUB: left.intValue = left.intValue - right.intValue; break;
+    case QUICK_INT_MUL: left.intValue = left.intValue * right.intValue; break;
+    case QUICK_INT_DIV: left.intValue = left.intValue / right.intValue; break;
+    case QUICK_INT_MOD: left.intValue = left.intValue % right.intValue; break;
+    case QUICK_INT_LT: left.type = 3; left.intValue = left.intValue < right.intValue; break;
+    case QUICK_INT_LE: left.type = 3; left.intValue = left.intValue <= right.intValue; break;
+    case QUICK_INT_GT: left.type = 3; left.intValue = left.intValue > right.intValue; break;
+    case QUICK_INT_GE: left.type = 3; left.intValue = left.intValue >= right.intValue; break;
+    case QUICK_INT_EQ: left.type = 3; left.intValue = left.intValue == right.intValue; break;
+    case QUICK_INT_NE: left.type = 3; left.intValue = left.intValue != right.intValue; break;
+    case QUICK_FLOAT_ADD: left.floatValue = left.floatValue + right.floatValue; break;
+    case QUICK_FLOAT_SUB: left.floatValue = left.floatValue - right.floatValue; break;
+    case QUICK_FLOAT_MUL: left.floatValue = left.floatValue * right.floatValue; break;
+    case QUICK_FLOAT_DIV: left.floatValue = left.floatValue / right.floatValue; break;
+    case QUICK_FLOAT_LT: left.type = 3; left.intValue = left.floatValue < right.floatValue; break;
+    case QUICK_FLOAT_LE: left.type = 3; left.intValue = left.floatValue <= right.floatValue; break;
+    case QUICK_FLOAT_GT: left.type = 3; left.intValue = left.floatValue > right.floatValue; break;
+    case QUICK_FLOAT_GE: left.type = 3; left.intValue = left.floatValue >= right.floatValue; break;
+    case QUICK_FLOAT_EQ: left.type = 3; left.intValue = left.floatValue == right.floatValue; break;
+    case QUICK_FLOAT_NE: left.type = 3; left.intValue = left.floatValue != right.floatValue; break;
+    case QUICK_BOOL_AND: left.intValue = left.intValue && right.intValue; break;
+    case QUICK_BOOL_OR: left.intValue = left.intValue || right.intValue; break;
+    case QUICK_STRING_CONCAT: left.stringValue += right.stringValue; break;
+    case QUICK_STRING_EQ: left.type = 3; left.intValue = left.stringValue == right.stringValue; break;
+    case QUICK_STRING_NE: left.type = 3; left.intValue = left.stringValue != right.stringValue; break;
+    case QUICK_BOOL_NOT: left.intValue = !left.intValue; break;
+    case QUICK_INT_NEG: left.intValue = -left.intValue; break;
+    case QUICK_FLOAT_NEG: left.floatValue = -left.floatValue; break;
+    }
+}
+
+int EvalVisitor::visit(BinaryExp *exp)
+{
+    if (exp->superOp != SUPER_NONE && compareLocal(exp))
+        return lastType;
+    return evalOperators(exp);
+}
+
+// Superinstrucciones (SuperinstructionFuser): cada una lee y escribe la celda
+// de la variable directamente. Si la variable no es Int/Float en este momento
+// devuelven false antes de evaluar nada y se sigue por el camino normal.
+bool EvalVisitor::compareLocal(BinaryExp *exp)
+{
+    int *left = env.int_slot(static_cast<IdentifierExp *>(exp->left)->name);
+    if (!left)
+        return false;
+    int right;
+    if (exp->superOp == SUPER_COMPARE_CONST)
+    {
+        right = static_cast<NumberExp *>(exp->right)->value;
+    }
+    else
+    {
+        int *slot = env.int_slot(static_cast<IdentifierExp *>(exp->right)->name);
+        if (!slot)
+            return false;
+        right = *slot;
+    }
+
+    bool result = false;
+    switch (exp->op)
+    {
+    case LT_OP: result = *left < right; break;
+    case LE_OP: result = *left <= right; break;
+    case GT_OP: result = *left > right; break;
+    case GE_OP: result = *left >= right; break;
+    case EQ_OP: result = *left == right; break;
+    case NE_OP: result = *left != right; break;
+    default: return false;
+    }
+    lastType = 3;
+    lastInt = result ? 1 : 0;
+    superHits[exp->superOp]++;
+    return true;
+}
+
+bool EvalVisitor::incrementLocal(AssignStatement *stm)
+{
+    if (int *slot = env.int_slot(stm->id))
+        *slot += stm->superStep;
+    else if (float *slot = env.float_slot(stm->id))
+        *slot += (float)stm->superStep;
+    else
+        return false;
+    superHits[SUPER_INCREMENT_LOCAL]++;
+    return true;
+}
+
+// El sumando no tiene efectos (ni llamadas ni ++/--), así que da igual leer
+// la variable antes o después de evaluarlo y la celda sigue siendo válida.
+bool EvalVisitor::accumulateLocal(AssignStatement *stm)
+{
+    int *intSlot = env.int_slot(stm->id);
+    float *floatSlot = intSlot ? nullptr : env.float_slot(stm->id);
+    if (!intSlot && !floatSlot)
+        return false;
+
+    int t = stm->superOperand->accept(this);
+    if (stm->op == AssignStatement::PLUS_ASSIGN_OP || t == 1 || (floatSlot && t == 2))
+    {
+        // Mismas conversiones que += y que la suma Int/Float del caso general
+        if (intSlot)
+            *intSlot += lastInt;
+        else
+            *floatSlot += (t == 2 ? lastFloat : (float)lastInt);
+    }
+    else
+    {
+        EvalValue current = intSlot ? EvalValue{1, *intSlot, 0.0f, ""} : EvalValue{2, 0, *floatSlot, ""};
+        EvalValue sum = evalBinaryOp(PLUS_OP, current, {t, lastInt, lastFloat, lastString});
+        lastInt = sum.intValue;
+        lastFloat = sum.floatValue;
+        lastString = sum.stringValue;
+        storeLast(stm->id, sum.type);
+    }
+    superHits[SUPER_ACCUMULATE_LOCAL]++;
+    return true;
+}
+
+// Quickening: la primera evaluación fija el manejador según los tipos vistos.
+// Si después llega otra combinación, el nodo vuelve para siempre al camino
+// genérico (desoptimización).
+bool EvalVisitor::quickBinary(BinaryExp *exp, EvalValue &left, const EvalValue &right)
+{
+    if (exp->quickState == 0)
+    {
+        exp->quickHandler = chooseBinaryHandler(exp->op, left.type, right.type);
+        exp->quickLeft = left.type;
+        exp->quickRight = right.type;
+        exp->quickState = exp->quickHandler == QUICK_NONE ? 2 : 1;
+        if (exp->quickState == 1)
+            quickStats.specialized++;
+        else
+            quickStats.generic++;
+    }
+    if (exp->quickState != 1)
+        return false;
+    if (left.type != exp->quickLeft || right.type != exp->quickRight)
+    {
+        exp->quickState = 2;
+        quickStats.deopts++;
+        return false;
+    }
+    applyQuickHandler(exp->quickHandler, left, right);
+    quickStats.hits++;
+    return true;
+}
+
+bool EvalVisitor::quickUnary(UnaryExp *exp, EvalValue &operand)
+{
+    if (exp->quickState == 0)
+    {
+        exp->quickHandler = chooseUnaryHandler(exp->op, operand.type);
+        exp->quickOperand = operand.type;
+        exp->quickState = exp->quickHandler == QUICK_NONE ? 2 : 1;
+        if (exp->quickState == 1)
+            quickStats.specialized++;
+        else
+            quickStats.generic++;
+    }
+    if (exp->quickState != 1)
+        return false;
+    if (operand.type != exp->quickOperand)
+    {
+        exp->quickState = 2;
+        quickStats.deopts++;
+        return false;
+    }
+    applyQuickHandler(exp->quickHandler, operand, operand);
+    quickStats.hits++;
+    return true;
+}
+
+int EvalVisitor::evalOperators(Exp *exp)
+{
+    walk(exp);
+    EvalValue value = valueStack.back();
+    valueStack.pop_back();
+    lastType = value.type;
+    lastInt = value.intValue;
+    lastFloat = value.floatValue;
+    lastString = value.stringValue;
     return lastType;
 }
 
+void EvalVisitor::onLeaf(Exp *exp)
+{
+    exp->accept(this);
+    valueStack.push_back({lastType, lastInt, lastFloat, lastString});
+}
+
+bool EvalVisitor::onOperand(BinaryExp *exp)
+{
+    // Cortocircuito: si el lado izquierdo ya decide && o ||, el derecho no se
+    // evalúa y se reutiliza el izquierdo como operando (false && false, true || true).
+    bool left = valueStack.back().intValue != 0;
+    if ((exp->op == AND_OP && !left) || (exp->op == OR_OP && left))
+    {
+        valueStack.push_back(valueStack.back());
+        return false;
+    }
+    return true;
+}
+
+void EvalVisitor::onExit(Exp *exp)
+{
+    int kind = nodeKind(exp);
+    if (kind == BINARY_NODE)
+    {
+        BinaryExp *bin = static_cast<BinaryExp *>(exp);
+        EvalValue &left = valueStack[valueStack.size() - 2];
+        if (especializar && quickBinary(bin, left, valueStack.back()))
+        {
+            valueStack.pop_back();
+            return;
+        }
+        EvalValue result = evalBinaryOp(bin->op, left, valueStack.back());
+        valueStack.pop_back();
+        valueStack.back() = result;
+    }
+    else if (kind == UNARY_NODE)
+    {
+        UnaryExp *unary = static_cast<UnaryExp *>(exp);
+        if (especializar && quickUnary(unary, valueStack.back()))
+            return;
+        valueStack.back() = evalUnaryOp(unary->op, valueStack.back());
+    }
+}
+
 int EvalVisitor::visit(NumberExp *exp)
 {
     lastType = 1;
@@ -849,78 +1311,127 @@ int EvalVisitor::visit(StringExp *exp)
 
 int EvalVisitor::visit(ParenthesizedExp *exp)
 {
-
-    return exp->expr->accept(this);
+    return evalOperators(exp);
 }
 
-int EvalVisitor::visit(FunctionCallExp *exp)
+// Solo cuenta el campo que corresponde al tipo: los demás pueden traer
+// restos de evaluaciones anteriores.
+static bool sameValue(const EvalValue &a, const EvalValue &b)
 {
+    if (a.type != b.type)
+        return false;
+    if (a.type == 2)
+        return a.floatValue == b.floatValue;
+    if (a.type == 5)
+        return a.stringValue == b.stringValue;
+    return a.intValue == b.intValue;
+}
 
-    auto it = functions.find(exp->name);
-    if (it == functions.end())
+size_t EvalVisitor::memoSlot(FunctionDecl *func, const vector<EvalValue> &args)
+{
+    size_t h = hash<FunctionDecl *>()(func);
+    for (const EvalValue &arg : args)
     {
-        cout << "Error: Function '" << exp->name << "' not declared" << endl;
-        lastType = 1;
-        lastInt = 0;
-        return lastType;
+        size_t v;
+        if (arg.type == 2)
+            v = hash<float>()(arg.floatValue);
+        else if (arg.type == 5)
+            v = hash<string>()(arg.stringValue);
+        else
+            v = hash<int>()(arg.intValue);
+        h ^= v + 0x9e3779b9 + (h << 6) + (h >> 2);
     }
+    return h % MEMO_SIZE;
+}
 
-    FunctionDecl *func = it->second;
+void EvalVisitor::imprimirPerfil()
+{
+    if (especializar)
+        cout << "Especializacion: " << quickStats.specialized << " nodos especializados, "
+             << quickStats.generic << " genericos, " << quickStats.deopts << " desoptimizaciones, "
+             << quickStats.hits << " evaluaciones rapidas" << endl;
+    else
+        cout << "Especializacion: desactivada" << endl;
+    cout << "Superinstrucciones:" << endl;
+    cout << "  comparar local con local: " << superHits[SUPER_COMPARE_LOCALS] << endl;
+    cout << "  comparar local con constante: " << superHits[SUPER_COMPARE_CONST] << endl;
+    cout << "  incrementar local: " << superHits[SUPER_INCREMENT_LOCAL] << endl;
+    cout << "  acumular en local: " << superHits[SUPER_ACCUMULATE_LOCAL] << endl;
+    cout << "  for con una asignacion: " << superHits[SUPER_FOR_ASSIGN] << endl;
+    cout << "Memoizacion (" << MEMO_SIZE << " entradas):" << endl;
+    if (memoStats.empty())
+        cout << "  ninguna funcion pura llamada" << endl;
+    map<string, MemoStats> byName;
+    for (const auto &entry : memoStats)
+        byName[entry.first->name] = entry.second;
+    for (const auto &entry : byName)
+    {
+        cout << "  " << entry.first << ": " << entry.second.hits << " aciertos, "
+             << entry.second.misses << " fallos" << endl;
+    }
+}
 
-    if (exp->args.size() != func->params.size())
+int EvalVisitor::visit(FunctionCallExp *exp)
+{
+    // CallResolver ya enlazo la llamada y verifico aridad y tipos.
+    FunctionDecl *func = exp->decl;
+    if (func == nullptr)
     {
-        cout << "Error: Function '" << exp->name << "' expects " << func->params.size()
-             << " arguments, got " << exp->args.size() << endl;
+        salidaPrograma.escribir("Error: Function '" + exp->name + "' not declared\n");
         lastType = 1;
         lastInt = 0;
         return lastType;
     }
 
-    env.add_level();
+    vector<EvalValue> args = evalArguments(exp);
 
-    auto param_it = func->params.begin();
-    for (auto arg : exp->args)
+    MemoEntry *memo = nullptr;
+    if (func->isPure && func->returnTypeCode > 0)
     {
-        int arg_type = arg->accept(this);
-        string param_name = param_it->first;
-        string param_type = param_it->second;
-        if (param_type == "Int" && arg_type == 1)
-        {
-            env.add_var(param_name, lastInt, "Int");
-        }
-        else if (param_type == "Float" && (arg_type == 1 || arg_type == 2))
-        {
-            env.add_var(param_name, arg_type == 1 ? (float)lastInt : lastFloat, "Float");
-        }
-        else if (param_type == "String" && arg_type == 5)
+        memo = &memoTable[memoSlot(func, args)];
+        if (memo->func == func && memo->args.size() == args.size() &&
+            equal(args.begin(), args.end(), memo->args.begin(), sameValue))
         {
-            env.add_var(param_name, lastString, "String");
+            if (perfilar)
+                memoStats[func].hits++;
+            lastType = memo->result.type;
+            lastInt = memo->result.intValue;
+            lastFloat = memo->result.floatValue;
+            lastString = memo->result.stringValue;
+            return lastType;
         }
-
-        param_it++;
+        if (perfilar)
+            memoStats[func].misses++;
     }
+
+    env.add_level();
+    bindArguments(func, args);
+
     bool previousReturnState = returnExecuted;
+    FunctionDecl *previousFunction = currentFunction;
+    currentFunction = func;
 
-    returnExecuted = false;
-    executeBlock(func->body);
+    // Una llamada propia en posición de cola deja sus argumentos en
+    // tailCallArgs: se reasignan los parámetros en el mismo nivel y se vuelve
+    // a ejecutar el cuerpo, sin crecer la pila nativa.
+    do
+    {
+        tailCallPending = false;
+        returnExecuted = false;
+        executeBlock(func->body);
+        if (tailCallPending)
+        {
+            vector<EvalValue> nextArgs = std::move(tailCallArgs);
+            bindArguments(func, nextArgs);
+        }
+    } while (tailCallPending);
 
+    currentFunction = previousFunction;
     returnExecuted = previousReturnState;
 
-    if (func->returnType == "Int")
+    if (func->returnTypeCode > 0)
     {
-        lastType = 1;
-    }
-    else if (func->returnType == "Float")
-    {
-        lastType = 2;
-    }
-    else if (func->returnType == "String")
-    {
-        lastType = 5;
-    }
-    else if (func->returnType == "Boolean")
-    {
-        lastType = 3;
+        lastType = func->returnTypeCode;
     }
     else
     {
@@ -928,6 +1439,13 @@ int EvalVisitor::visit(FunctionCallExp *exp)
         lastInt = 0;
     }
 
+    if (memo)
+    {
+        memo->func = func;
+        memo->args = std::move(args);
+        memo->result = {lastType, lastInt, lastFloat, lastString};
+    }
+
     env.remove_level();
 
     return lastType;
@@ -935,38 +1453,11 @@ int EvalVisitor::visit(FunctionCallExp *exp)
 
 int EvalVisitor::visit(UnaryExp *exp)
 {
-    int operand_t = exp->expr->accept(this);
+    if (isOperatorNode(exp))
+        return evalOperators(exp);
 
     switch (exp->op)
     {
-    case UnaryExp::NOT_OP:
-        lastType = 3;
-        lastInt = !lastInt;
-        break;
-    case UnaryExp::NEG_OP:
-        if (operand_t == 1)
-        {
-            lastType = 1;
-            lastInt = -lastInt;
-        }
-        else if (operand_t == 2)
-        {
-            lastType = 2;
-            lastFloat = -lastFloat;
-        }
-        break;
-    case UnaryExp::POS_OP:
-        if (operand_t == 1)
-        {
-            lastType = 1;
-            lastInt = +lastInt;
-        }
-        else if (operand_t == 2)
-        {
-            lastType = 2;
-            lastFloat = +lastFloat;
-        }
-        break;
     case UnaryExp::PRE_INC_OP:
     {
         IdentifierExp *id_exp = dynamic_cast<IdentifierExp *>(exp->expr);
@@ -1067,6 +1558,8 @@ int EvalVisitor::visit(UnaryExp *exp)
         }
         break;
     }
+    default:
+        throw runtime_error("operador unario desconocido");
     }
 
     return lastType;
@@ -1120,19 +1613,29 @@ int EvalVisitor::visit(RunExp *exp)
     return lastType;
 }
 
+void EvalVisitor::storeLast(const string &id, int type)
+{
+    if (type == 2)
+        env.update(id, lastFloat);
+    else if (type == 5)
+        env.update(id, lastString);
+    else if (type == 3)
+        env.update(id, (bool)lastInt);
+    else
+        env.update(id, lastInt);
+}
+
 void EvalVisitor::visit(AssignStatement *stm)
 {
+    if (stm->superOp == SUPER_INCREMENT_LOCAL && incrementLocal(stm))
+        return;
+    if (stm->superOp == SUPER_ACCUMULATE_LOCAL && accumulateLocal(stm))
+        return;
+
     if (stm->op == AssignStatement::ASSIGN_OP)
     {
         int t = stm->rhs->accept(this);
-        if (t == 2)
-            env.update(stm->id, lastFloat);
-        else if (t == 5)
-            env.update(stm->id, lastString);
-        else if (t == 3)
-            env.update(stm->id, (bool)lastInt);
-        else
-            env.update(stm->id, lastInt);
+        storeLast(stm->id, t);
     }
     else if (stm->op == AssignStatement::INCREMENT_OP)
     {
@@ -1292,28 +1795,85 @@ void EvalVisitor::visit(AssignStatement *stm)
 void EvalVisitor::visit(PrintStatement *stm)
 {
     int t = stm->e->accept(this);
+    char number[32];
+    const char *text = number;
+    size_t length = 0;
     if (t == 2)
     {
-        cout << formatFloat(lastFloat);
+        length = formatFloatTo(number, lastFloat) - number;
     }
     else if (t == 1)
     {
-        cout << lastInt;
+        length = to_chars(number, number + sizeof(number), lastInt).ptr - number;
     }
     else if (t == 3)
     {
-        cout << (lastInt ? "true" : "false");
+        text = lastInt ? "true" : "false";
+        length = lastInt ? 4 : 5;
     }
     else if (t == 4)
     {
-        cout << lastInt << ".." << (int)lastFloat;
+        // Dos Int de hasta 11 caracteres y "..": caben, pero se comprueba
+        char *limit = number + sizeof(number);
+        auto first = to_chars(number, limit, lastInt);
+        if (first.ec == errc() && first.ptr + 2 <= limit)
+        {
+            char *end = first.ptr;
+            *end++ = '.';
+            *end++ = '.';
+            auto last = to_chars(end, limit, (int)lastFloat);
+            if (last.ec == errc())
+                length = last.ptr - number;
+        }
     }
     else if (t == 5)
     {
-        cout << lastString;
+        text = lastString.data();
+        length = lastString.size();
     }
+    salidaPrograma.escribir(text, length);
     if (stm->newline)
-        cout << endl;
+        salidaPrograma.saltoDeLinea();
+
+    if (captureOutput)
+    {
+        capturedOutput.append(text, length);
+        if (stm->newline)
+            capturedOutput += '\n';
+        if (capturedOutput.size() > AOT_MAX_OUTPUT)
+            cancelCapture();
+    }
+}
+
+void EvalVisitor::capturarSalida(long presupuesto)
+{
+    captureOutput = true;
+    captureValid = true;
+    stepBudget = presupuesto;
+    steps = 0;
+    capturedOutput.clear();
+}
+
+// Devuelve la salida solo si main terminó sin pasarse de los límites.
+bool EvalVisitor::salidaCapturada(string &salida) const
+{
+    if (!captureValid)
+        return false;
+    salida = capturedOutput;
+    return true;
+}
+
+void EvalVisitor::countStep()
+{
+    if (captureOutput && ++steps > stepBudget)
+        cancelCapture();
+}
+
+void EvalVisitor::cancelCapture()
+{
+    captureOutput = false;
+    captureValid = false;
+    capturedOutput.clear();
 }
 
 void EvalVisitor::visit(ExpressionStatement *stm)
@@ -1333,6 +1893,8 @@ void EvalVisitor::ejecutar(Program *program)
     continueExecuted = false;
     inBlockExecutionContext = false;
     inFunctionBody = false;
+    memoTable.assign(MEMO_SIZE, MemoEntry());
+    memoStats.clear();
     env.add_level();
 
     for (auto stmt : program->statements->stms)
@@ -1353,9 +1915,12 @@ void EvalVisitor::ejecutar(Program *program)
     }
     else
     {
-        cout << "Error: No se encontro la función main()" << endl;
+        salidaPrograma.escribir("Error: No se encontro la función main()\n");
+        cancelCapture();
     }
+    captureOutput = false;
 
+    salidaPrograma.vaciar();
     cout << endl;
 }
 
@@ -1391,6 +1956,7 @@ void EvalVisitor::visit(StatementList *stm)
 {
     for (auto i : stm->stms)
     {
+        countStep();
         i->accept(this);
         if (returnExecuted || breakExecuted || continueExecuted)
             break;
@@ -1453,12 +2019,15 @@ void EvalVisitor::visit(WhileStatement *stm)
         if (!res)
             break;
 
+        countStep();
         breakExecuted = false;
         continueExecuted = false;
         inBlockExecutionContext = true;
         stm->stmt->accept(this);
         inBlockExecutionContext = prevInBlockExecutionContext;
 
+        if (returnExecuted)
+            break;
         if (breakExecuted)
         {
             breakExecuted = false;
@@ -1478,6 +2047,7 @@ void EvalVisitor::visit(DoWhileStatement *stm)
 
     do
     {
+        countStep();
         breakExecuted = false;
         continueExecuted = false;
         inBlockExecutionContext = true;
@@ -1507,6 +2077,35 @@ void EvalVisitor::visit(DoWhileStatement *stm)
     } while (true);
 }
 
+// Una vuelta del for; false si el cuerpo cortó el bucle
+bool EvalVisitor::runForBody(ForStatement *stm, bool prevInBlockExecutionContext)
+{
+    countStep();
+    if (stm->superBody)
+    {
+        // Una sola asignación: no declara nada ni corta el bucle,
+        // no hace falta abrir nivel ni revisar banderas.
+        superHits[SUPER_FOR_ASSIGN]++;
+        stm->superBody->accept(this);
+        return true;
+    }
+    breakExecuted = false;
+    continueExecuted = false;
+    inBlockExecutionContext = true;
+    stm->stmt->accept(this);
+    inBlockExecutionContext = prevInBlockExecutionContext;
+
+    if (returnExecuted)
+        return false;
+    if (breakExecuted)
+    {
+        breakExecuted = false;
+        return false;
+    }
+    continueExecuted = false;
+    return true;
+}
+
 void EvalVisitor::visit(ForStatement *stm)
 {
     bool prevInBlockExecutionContext = inBlockExecutionContext;
@@ -1525,7 +2124,7 @@ void EvalVisitor::visit(ForStatement *stm)
             step_val = lastInt;
             if (step_val == 0)
             {
-                cout << "Error: step no puede ser 0 en un rango" << endl;
+                salidaPrograma.escribir("Error: step no puede ser 0 en un rango\n");
                 return;
             }
         }
@@ -1540,23 +2139,8 @@ void EvalVisitor::visit(ForStatement *stm)
             for (int i = start_val; i > limit; i += step_val)
             {
                 env.update(stm->id, i);
-
-                breakExecuted = false;
-                continueExecuted = false;
-                inBlockExecutionContext = true;
-                stm->stmt->accept(this);
-                inBlockExecutionContext = prevInBlockExecutionContext;
-
-                if (breakExecuted)
-                {
-                    breakExecuted = false;
+                if (!runForBody(stm, prevInBlockExecutionContext))
                     break;
-                }
-                if (continueExecuted)
-                {
-                    continueExecuted = false;
-                    continue;
-                }
             }
         }
         else
@@ -1565,29 +2149,14 @@ void EvalVisitor::visit(ForStatement *stm)
             for (int i = start_val; i < limit; i += step_val)
             {
                 env.update(stm->id, i);
-
-                breakExecuted = false;
-                continueExecuted = false;
-                inBlockExecutionContext = true;
-                stm->stmt->accept(this);
-                inBlockExecutionContext = prevInBlockExecutionContext;
-
-                if (breakExecuted)
-                {
-                    breakExecuted = false;
+                if (!runForBody(stm, prevInBlockExecutionContext))
                     break;
-                }
-                if (continueExecuted)
-                {
-                    continueExecuted = false;
-                    continue;
-                }
             }
         }
     }
     else
     {
-        cout << "Error: Solo se aceptan expresiones por rango" << endl;
+        salidaPrograma.escribir("Error: Solo se aceptan expresiones por rango\n");
     }
 }
 
@@ -1597,8 +2166,57 @@ void EvalVisitor::visit(FunctionDecl *stm)
     functions[stm->name] = stm;
 }
 
+vector<EvalValue> EvalVisitor::evalArguments(FunctionCallExp *call)
+{
+    vector<EvalValue> args;
+    args.reserve(call->args.size());
+    for (auto arg : call->args)
+    {
+        arg->accept(this);
+        args.push_back({lastType, lastInt, lastFloat, lastString});
+    }
+    return args;
+}
+
+// Los tipos de los parámetros vienen precalculados en la FunctionDecl, pero
+// el intérprete los sigue declarando por nombre en el Environment, porque todo
+// el cuerpo los busca por nombre. Las ranuras fijas por parámetro son de
+// --enhebrado y --clausuras (StaticLowering).
+void EvalVisitor::bindArguments(FunctionDecl *func, const vector<EvalValue> &args)
+{
+    auto param_it = func->params.begin();
+    for (size_t i = 0; i < args.size(); i++, param_it++)
+    {
+        const EvalValue &arg = args[i];
+        switch (func->paramTypes[i])
+        {
+        case 1:
+            env.add_var(param_it->first, arg.type == 2 ? (int)arg.floatValue : arg.intValue, "Int");
+            break;
+        case 2:
+            env.add_var(param_it->first, arg.type == 2 ? arg.floatValue : (float)arg.intValue, "Float");
+            break;
+        case 3:
+            env.add_var(param_it->first, arg.intValue != 0, "Boolean");
+            break;
+        case 5:
+            env.add_var(param_it->first, arg.stringValue, "String");
+            break;
+        }
+    }
+}
+
 void EvalVisitor::visit(ReturnStatement *stm)
 {
+    FunctionCallExp *call = dynamic_cast<FunctionCallExp *>(stm->expr);
+    if (call && call->decl && call->decl == currentFunction)
+    {
+        tailCallArgs = evalArguments(call);
+        tailCallPending = true;
+        returnExecuted = true;
+        return;
+    }
+
     if (stm->expr)
     {
         stm->expr->accept(this);
@@ -1622,6 +2240,45 @@ int DoWhileStatement::accept(Visitor *visitor)
     return 0;
 }
 
+// Programa ya evaluado en tiempo de compilación: main solo escribe la salida
+// precalculada con una llamada write(2) directa, sin libc.
+void GenCodeVisitor::generarSalidaFija(const string &salida)
+{
+    out << ".section .rodata\n";
+    out << "salida_aot:\n";
+    for (size_t start = 0; start < salida.size(); start += 64)
+    {
+        out << " .ascii \"";
+        for (size_t i = start; i < salida.size() && i < start + 64; i++)
+        {
+            unsigned char c = salida[i];
+            if (c == '"' || c == '\\')
+                out << '\\' << c;
+            else if (c == '\n')
+                out << "\\n";
+            else if (c < 32 || c >= 127)
+                out << '\\' << oct << setw(3) << setfill('0') << (int)c << dec << setfill(' ');
+            else
+                out << c;
+        }
+        out << "\"\n";
+    }
+
+    out << "\n.text\n";
+    out << ".globl main\n";
+    out << "main:\n";
+    out << " pushq %rbp\n";
+    out << " movq %rsp, %rbp\n";
+    out << " leaq salida_aot(%rip), %rsi\n";
+    out << " movq $" << salida.size() << ", %rdx\n";
+    out << " call salida_write\n";
+    out << " xorl %eax, %eax\n";
+    out << " leave\n";
+    out << " ret\n";
+    emitWriteRuntime();
+    out << ".section .note.GNU-stack,\"\",@progbits\n";
+}
+
 void GenCodeVisitor::generar(Program *program)
 {
     if (!program)
@@ -1629,45 +2286,54 @@ void GenCodeVisitor::generar(Program *program)
 
     if (program->statements)
     {
+        unordered_set<string> funciones;
         for (auto stmt : program->statements->stms)
         {
             if (VarDec *varDecl = dynamic_cast<VarDec *>(stmt))
             {
                 memoriaGlobal[varDecl->id] = true;
-                if (varDecl->value)
-                {
-                    processExpForFloatConstants(varDecl->value);
-                }
+                setVariableType(varDecl->id, typeCode(varDecl->type));
             }
             else if (FunctionDecl *funcDecl = dynamic_cast<FunctionDecl *>(stmt))
-            {
-                processForFloatConstants(funcDecl->body);
-            }
+                funciones.insert(funcDecl->name);
         }
+        mirilla = PeepholeOptimizer(funciones);
     }
 
     out << ".data\n";
-    out << "print_fmt: .string \"%ld\\n\"\n";
-    out << "print_str_fmt: .string \"%s\\n\"\n";
-    out << "print_float_fmt: .string \"%.6g\\n\"\n";
-    out << "string_buffer: .space 512\n";
-    out << "string_buffer2: .space 512\n";
-    out << "stringBufferCounter: .long 0\n";
-
-    for (auto it = memoriaGlobal.begin(); it != memoriaGlobal.end(); ++it)
-    {
-        out << it->first << ": .quad 0\n";
-    }
+    out << "salida_buffer: .quad 0\n";
+    out << "salida_pos: .quad 0\n";
 
-    out << "\n.section .rodata\n";
-    out << ".align 8\n";
-    out << ".L_zero: .double 0.0\n";
-    out << ".L_one: .double 1.0\n";
-    out << ".str_concat_fmt: .string \"%s%s\"\n";
-
-    for (auto it = floatConstants.begin(); it != floatConstants.end(); ++it)
+    // Un literal queda en .data; cualquier otro valor lo calcula main al empezar
+    unordered_set<string> emitidas;
+    if (program->statements)
     {
-        out << it->second << ": .double " << it->first << "\n";
+        for (auto stmt : program->statements->stms)
+        {
+            VarDec *varDecl = dynamic_cast<VarDec *>(stmt);
+            if (!varDecl || !emitidas.insert(varDecl->id).second)
+                continue;
+            int type = getVariableType(varDecl->id);
+            NumberExp *entero = dynamic_cast<NumberExp *>(varDecl->value);
+            DecimalExp *decimal = dynamic_cast<DecimalExp *>(varDecl->value);
+            BoolExp *booleano = dynamic_cast<BoolExp *>(varDecl->value);
+            out << varDecl->id << ":";
+            if (type == 2 && (decimal || entero))
+            {
+                float value = decimal ? decimal->value : (float)entero->value;
+                char text[32];
+                out << " .float " << string(text, to_chars(text, text + sizeof(text), value).ptr) << "\n";
+                out << " .zero 4\n";
+            }
+            else if ((type == 1 && entero) || (type == 3 && booleano))
+                out << " .quad " << (entero ? entero->value : booleano->value) << "\n";
+            else
+            {
+                out << " .quad 0\n";
+                if (varDecl->value)
+                    inicioGlobales.push_back(varDecl);
+            }
+        }
     }
 
     out << "\n.text\n";
@@ -1683,9 +2349,947 @@ void GenCodeVisitor::generar(Program *program)
         }
     }
 
+    emitOutputRuntime();
+    if (usaCadenas)
+        emitStringRuntime();
+    emitConstantPool();
     out << ".section .note.GNU-stack,\"\",@progbits\n";
 }
 
+// Runtime de cadenas: cada String lleva su longitud en los 8 bytes previos a
+// los caracteres, así que sigue siendo un char* para printf. Se reservan en
+// una arena de bloques de calloc que duplican su tamaño, sin liberar nunca,
+// por lo que el byte siguiente al último carácter ya es el terminador.
+// cadena_concatenar(n, piezas) junta n cadenas, con la primera en piezas[n-1]
+// como quedan tras apilarlas, en una sola reserva con memcpy.
+void GenCodeVisitor::emitStringRuntime()
+{
+    out << "\n.section .rodata\n";
+    out << ".align 8\n";
+    out << " .quad 4\n";
+    out << "cadena_verdadero: .string \"true\"\n";
+    out << " .quad 5\n";
+    out << "cadena_falso: .string \"false\"\n";
+    out << "\n.data\n";
+    out << "cadena_arena: .quad 0\n";
+    out << "cadena_arena_fin: .quad 0\n";
+    out << "cadena_bloque: .quad 65536\n";
+    out << "\n.text\n";
+    out << "cadena_reservar:\n";
+    out << " pushq %rbp\n";
+    out << " movq %rsp, %rbp\n";
+    out << " pushq %rbx\n";
+    out << " pushq %r12\n";
+    out << " andq $-16, %rsp\n";
+    out << " movq %rdi, %rbx\n";
+    out << " leaq 16(%rdi), %r12\n";
+    out << " andq $-8, %r12\n";
+    out << " movq cadena_arena(%rip), %rax\n";
+    out << " addq %r12, %rax\n";
+    out << " cmpq cadena_arena_fin(%rip), %rax\n";
+    out << " jbe .cadena_cabe\n";
+    out << " movq cadena_bloque(%rip), %rdi\n";
+    out << ".cadena_doblar:\n";
+    out << " cmpq %r12, %rdi\n";
+    out << " jae .cadena_pedir\n";
+    out << " addq %rdi, %rdi\n";
+    out << " jmp .cadena_doblar\n";
+    out << ".cadena_pedir:\n";
+    out << " movq %rdi, %rax\n";
+    out << " addq %rax, %rax\n";
+    out << " movq %rax, cadena_bloque(%rip)\n";
+    out << " pushq %rdi\n";
+    out << " pushq %rdi\n";
+    out << " movq $1, %rsi\n";
+    out << " call calloc@PLT\n";
+    out << " popq %rdi\n";
+    out << " popq %rdi\n";
+    out << " testq %rax, %rax\n";
+    out << " je .cadena_sin_memoria\n";
+    out << " movq %rax, cadena_arena(%rip)\n";
+    out << " addq %rdi, %rax\n";
+    out << " movq %rax, cadena_arena_fin(%rip)\n";
+    out << ".cadena_cabe:\n";
+    out << " movq cadena_arena(%rip), %rax\n";
+    out << " movq %rax, %rcx\n";
+    out << " addq %r12, %rcx\n";
+    out << " movq %rcx, cadena_arena(%rip)\n";
+    out << " movq %rbx, (%rax)\n";
+    out << " addq $8, %rax\n";
+    out << " leaq -16(%rbp), %rsp\n";
+    out << " popq %r12\n";
+    out << " popq %rbx\n";
+    out << " popq %rbp\n";
+    out << " ret\n";
+    out << ".cadena_sin_memoria:\n";
+    out << " call abort@PLT\n";
+
+    out << "cadena_concatenar:\n";
+    out << " pushq %rbp\n";
+    out << " movq %rsp, %rbp\n";
+    out << " pushq %rbx\n";
+    out << " pushq %r12\n";
+    out << " pushq %r13\n";
+    out << " pushq %r14\n";
+    out << " andq $-16, %rsp\n";
+    out << " movq %rdi, %r12\n";
+    out << " movq %rsi, %r13\n";
+    out << " xorq %rbx, %rbx\n";
+    out << " movq %r12, %rcx\n";
+    out << ".cadena_medir:\n";
+    out << " movq (%r13), %rax\n";
+    out << " addq -8(%rax), %rbx\n";
+    out << " addq $8, %r13\n";
+    out << " decq %rcx\n";
+    out << " jne .cadena_medir\n";
+    out << " movq %rbx, %rdi\n";
+    out << " call cadena_reservar\n";
+    out << " movq %rax, %r14\n";
+    out << " movq %rax, %rbx\n";
+    out << ".cadena_copiar:\n";
+    out << " subq $8, %r13\n";
+    out << " movq (%r13), %rsi\n";
+    out << " movq -8(%rsi), %rdx\n";
+    out << " movq %rbx, %rdi\n";
+    out << " addq %rdx, %rbx\n";
+    out << " call memcpy@PLT\n";
+    out << " decq %r12\n";
+    out << " jne .cadena_copiar\n";
+    out << " movq %r14, %rax\n";
+    out << " leaq -32(%rbp), %rsp\n";
+    out << " popq %r14\n";
+    out << " popq %r13\n";
+    out << " popq %r12\n";
+    out << " popq %rbx\n";
+    out << " popq %rbp\n";
+    out << " ret\n";
+
+    // cadena_igual(a, b): 1 si tienen la misma longitud y los mismos bytes
+    out << "cadena_igual:\n";
+    out << " pushq %rbp\n";
+    out << " movq %rsp, %rbp\n";
+    out << " movq -8(%rdi), %rdx\n";
+    out << " cmpq -8(%rsi), %rdx\n";
+    out << " jne .cadena_distintas\n";
+    out << " andq $-16, %rsp\n";
+    out << " call memcmp@PLT\n";
+    out << " cmpl $0, %eax\n";
+    out << " jne .cadena_distintas\n";
+    out << " movq $1, %rax\n";
+    out << " leave\n";
+    out << " ret\n";
+    out << ".cadena_distintas:\n";
+    out << " xorl %eax, %eax\n";
+    out << " leave\n";
+    out << " ret\n";
+
+    // Piezas que no son String: mismo formato que print, sin el salto
+    out << "cadena_copia:\n";
+    out << " pushq %rbp\n";
+    out << " movq %rsp, %rbp\n";
+    out << " pushq %rbx\n";
+    out << " pushq %r12\n";
+    out << " andq $-16, %rsp\n";
+    out << " movq %rdi, %rbx\n";
+    out << " movq %rsi, %r12\n";
+    out << " movq %rsi, %rdi\n";
+    out << " call cadena_reservar\n";
+    out << " movq %rax, %rdi\n";
+    out << " movq %rbx, %rsi\n";
+    out << " movq %r12, %rdx\n";
+    out << " call memcpy@PLT\n";
+    out << " leaq -16(%rbp), %rsp\n";
+    out << " popq %r12\n";
+    out << " popq %rbx\n";
+    out << " popq %rbp\n";
+    out << " ret\n";
+    out << "cadena_de_entero:\n";
+    out << " pushq %rbp\n";
+    out << " movq %rsp, %rbp\n";
+    out << " subq $32, %rsp\n";
+    out << " movq %rbp, %rsi\n";
+    out << " call formato_entero\n";
+    out << " movq %rax, %rdi\n";
+    out << " movq %rbp, %rsi\n";
+    out << " subq %rax, %rsi\n";
+    out << " call cadena_copia\n";
+    out << " leave\n";
+    out << " ret\n";
+    out << "cadena_de_flotante:\n";
+    out << " pushq %rbp\n";
+    out << " movq %rsp, %rbp\n";
+    out << " subq $32, %rsp\n";
+    out << " leaq -32(%rbp), %rdi\n";
+    out << " call formato_flotante\n";
+    out << " leaq -32(%rbp), %rdi\n";
+    out << " movq %rax, %rsi\n";
+    out << " subq %rdi, %rsi\n";
+    out << " call cadena_copia\n";
+    out << " leave\n";
+    out << " ret\n";
+    out << "cadena_de_booleano:\n";
+    out << " leaq cadena_falso(%rip), %rax\n";
+    out << " testq %rdi, %rdi\n";
+    out << " je .cadena_booleano_listo\n";
+    out << " leaq cadena_verdadero(%rip), %rax\n";
+    out << ".cadena_booleano_listo:\n";
+    out << " ret\n";
+}
+
+// salida_write(rsi = datos, rdx = bytes): write(2) a stdout hasta que sale
+// todo; si una señal la interrumpe (errno EINTR) vuelve a intentar. La usan
+// el runtime de salida y la salida fija de --aot.
+void GenCodeVisitor::emitWriteRuntime()
+{
+    out << "salida_write:\n";
+    out << " pushq %rbp\n";
+    out << " movq %rsp, %rbp\n";
+    out << " andq $-16, %rsp\n";
+    out << ".salida_write_resto:\n";
+    out << " testq %rdx, %rdx\n";
+    out << " jle .salida_write_fin\n";
+    out << " pushq %rsi\n";
+    out << " pushq %rdx\n";
+    out << " movq $1, %rdi\n";
+    out << " call write@PLT\n";
+    out << " testq %rax, %rax\n";
+    out << " jns .salida_write_escrito\n";
+    out << " call __errno_location@PLT\n";
+    out << " cmpl $4, (%rax)\n";
+    out << " popq %rdx\n";
+    out << " popq %rsi\n";
+    out << " je .salida_write_resto\n";
+    out << " jmp .salida_write_fin\n";
+    out << ".salida_write_escrito:\n";
+    out << " popq %rdx\n";
+    out << " popq %rsi\n";
+    out << " testq %rax, %rax\n";
+    out << " je .salida_write_fin\n";
+    out << " addq %rax, %rsi\n";
+    out << " subq %rax, %rdx\n";
+    out << " jmp .salida_write_resto\n";
+    out << ".salida_write_fin:\n";
+    out << " leave\n";
+    out << " ret\n";
+}
+
+// Runtime de salida: print y println escriben en un buffer de 64 KB (reservado
+// con malloc en la primera escritura) que se vuelca con write(2) cuando se
+// llena y al terminar main. Los enteros y los Float se formatean aquí mismo,
+// sin pasar por printf; salida_flotante es formatFloatTo traducido paso a
+// paso, así que imprime lo mismo que el intérprete.
+void GenCodeVisitor::emitOutputRuntime()
+{
+    out << "\n.section .rodata\n";
+    out << ".align 8\n";
+    out << "salida_ryu_inversas:";
+    for (int i = 0; i < 31; i++)
+        out << (i ? ", " : " .quad ") << RYU_POW5_INV_SPLIT[i];
+    out << "\n";
+    out << "salida_ryu_potencias:";
+    for (int i = 0; i < 48; i++)
+        out << (i ? ", " : " .quad ") << RYU_POW5_SPLIT[i];
+    out << "\n";
+    out << " .quad 6\n";
+    out << "salida_nulo: .string \"(null)\"\n";
+    out << " .quad 1\n";
+    out << "salida_salto: .string \"\\n\"\n";
+    out << "\n.text\n";
+    out << "salida_escribir:\n";
+    out << " pushq %rbp\n";
+    out << " movq %rsp, %rbp\n";
+    out << " pushq %rbx\n";
+    out << " pushq %r12\n";
+    out << " andq $-16, %rsp\n";
+    out << " movq %rdi, %rbx\n";
+    out << " movq %rsi, %r12\n";
+    out << " cmpq $0, salida_buffer(%rip)\n";
+    out << " jne .salida_hay_buffer\n";
+    out << " movq $65536, %rdi\n";
+    out << " call malloc@PLT\n";
+    out << " testq %rax, %rax\n";
+    out << " je .salida_sin_memoria\n";
+    out << " movq %rax, salida_buffer(%rip)\n";
+    out << ".salida_hay_buffer:\n";
+    out << " movq salida_pos(%rip), %rax\n";
+    out << " addq %r12, %rax\n";
+    out << " cmpq $65536, %rax\n";
+    out << " jbe .salida_copiar\n";
+    out << " call salida_vaciar\n";
+    out << " cmpq $65536, %r12\n";
+    out << " jbe .salida_copiar\n";
+    out << " movq %rbx, %rsi\n";
+    out << " movq %r12, %rdx\n";
+    out << " call salida_write\n";
+    out << " jmp .salida_escrito\n";
+    out << ".salida_copiar:\n";
+    out << " movq salida_buffer(%rip), %rdi\n";
+    out << " addq salida_pos(%rip), %rdi\n";
+    out << " movq %rbx, %rsi\n";
+    out << " movq %r12, %rdx\n";
+    out << " call memcpy@PLT\n";
+    out << " addq %r12, salida_pos(%rip)\n";
+    out << ".salida_escrito:\n";
+    out << " leaq -16(%rbp), %rsp\n";
+    out << " popq %r12\n";
+    out << " popq %rbx\n";
+    out << " popq %rbp\n";
+    out << " ret\n";
+    out << ".salida_sin_memoria:\n";
+    out << " call abort@PLT\n";
+    out << "salida_vaciar:\n";
+    out << " pushq %rbp\n";
+    out << " movq %rsp, %rbp\n";
+    out << " andq $-16, %rsp\n";
+    out << " movq salida_buffer(%rip), %rsi\n";
+    out << " movq salida_pos(%rip), %rdx\n";
+    out << " call salida_write\n";
+    out << " movq $0, salida_pos(%rip)\n";
+    out << " leave\n";
+    out << " ret\n";
+    emitWriteRuntime();
+    out << "salida_cadena:\n";
+    out << " pushq %rbp\n";
+    out << " movq %rsp, %rbp\n";
+    out << " testq %rdi, %rdi\n";
+    out << " jne .salida_cadena_valida\n";
+    out << " leaq salida_nulo(%rip), %rdi\n";
+    out << ".salida_cadena_valida:\n";
+    out << " movq -8(%rdi), %rsi\n";
+    out << " call salida_escribir\n";
+    out << " leaq salida_salto(%rip), %rdi\n";
+    out << " movq $1, %rsi\n";
+    out << " call salida_escribir\n";
+    out << " leave\n";
+    out << " ret\n";
+    out << "salida_entero:\n";
+    out << " pushq %rbp\n";
+    out << " movq %rsp, %rbp\n";
+    out << " subq $32, %rsp\n";
+    out << " leaq -1(%rbp), %rsi\n";
+    out << " movb $10, (%rsi)\n";
+    out << " call formato_entero\n";
+    out << " movq %rax, %rdi\n";
+    out << " movq %rbp, %rsi\n";
+    out << " subq %rdi, %rsi\n";
+    out << " call salida_escribir\n";
+    out << " leave\n";
+    out << " ret\n";
+    out << "salida_flotante:\n";
+    out << " pushq %rbp\n";
+    out << " movq %rsp, %rbp\n";
+    out << " subq $32, %rsp\n";
+    out << " leaq -32(%rbp), %rdi\n";
+    out << " call formato_flotante\n";
+    out << " movb $10, (%rax)\n";
+    out << " leaq 1(%rax), %rsi\n";
+    out << " leaq -32(%rbp), %rdi\n";
+    out << " subq %rdi, %rsi\n";
+    out << " call salida_escribir\n";
+    out << " leave\n";
+    out << " ret\n";
+    // formato_entero: rdi el valor, rsi el final del buffer; escribe hacia
+    // atrás y devuelve en rax dónde empieza
+    out << "formato_entero:\n";
+    out << " movq %rdi, %rax\n";
+    out << " movq %rdi, %r8\n";
+    out << " movq $10, %rcx\n";
+    out << " testq %rax, %rax\n";
+    out << " jns .formato_entero_digito\n";
+    out << " negq %rax\n";
+    out << ".formato_entero_digito:\n";
+    out << " xorl %edx, %edx\n";
+    out << " divq %rcx\n";
+    out << " addq $48, %rdx\n";
+    out << " decq %rsi\n";
+    out << " movb %dl, (%rsi)\n";
+    out << " testq %rax, %rax\n";
+    out << " jne .formato_entero_digito\n";
+    out << " testq %r8, %r8\n";
+    out << " jns .formato_entero_listo\n";
+    out << " decq %rsi\n";
+    out << " movb $45, (%rsi)\n";
+    out << ".formato_entero_listo:\n";
+    out << " movq %rsi, %rax\n";
+    out << " ret\n";
+    // formato_flotante: xmm0 el valor, rdi el buffer (32 bytes alcanzan);
+    // devuelve en rax el final de lo escrito
+    out << "formato_flotante:\n";
+    out << " pushq %rbp\n";
+    out << " movq %rsp, %rbp\n";
+    out << " subq $240, %rsp\n";
+    out << " movss %xmm0, -72(%rbp)\n";
+    out << " movl -72(%rbp), %eax\n";
+    out << " movq %rax, %rcx\n";
+    out << " shrq $23, %rcx\n";
+    out << " andq $255, %rcx\n";
+    out << " movq %rax, %rdx\n";
+    out << " andq $8388607, %rdx\n";
+    out << " cmpq $255, %rcx\n";
+    out << " jne .salida_signo\n";
+    out << " testq %rdx, %rdx\n";
+    out << " je .salida_signo\n";
+    out << " movb $78, (%rdi)\n";
+    out << " movb $97, 1(%rdi)\n";
+    out << " movb $78, 2(%rdi)\n";
+    out << " addq $3, %rdi\n";
+    out << " jmp .salida_flotante_fin\n";
+    out << ".salida_signo:\n";
+    out << " shrq $31, %rax\n";
+    out << " testq %rax, %rax\n";
+    out << " je .salida_positivo\n";
+    out << " movb $45, (%rdi)\n";
+    out << " incq %rdi\n";
+    out << ".salida_positivo:\n";
+    out << " cmpq $255, %rcx\n";
+    out << " jne .salida_finito\n";
+    out << " movb $73, (%rdi)\n";
+    out << " movb $110, 1(%rdi)\n";
+    out << " movb $102, 2(%rdi)\n";
+    out << " movb $105, 3(%rdi)\n";
+    out << " movb $110, 4(%rdi)\n";
+    out << " movb $105, 5(%rdi)\n";
+    out << " movb $116, 6(%rdi)\n";
+    out << " movb $121, 7(%rdi)\n";
+    out << " addq $8, %rdi\n";
+    out << " jmp .salida_flotante_fin\n";
+    out << ".salida_finito:\n";
+    out << " testq %rcx, %rcx\n";
+    out << " jne .salida_normal\n";
+    out << " testq %rdx, %rdx\n";
+    out << " jne .salida_subnormal\n";
+    out << " movb $48, (%rdi)\n";
+    out << " movb $46, 1(%rdi)\n";
+    out << " movb $48, 2(%rdi)\n";
+    out << " addq $3, %rdi\n";
+    out << " jmp .salida_flotante_fin\n";
+    out << ".salida_subnormal:\n";
+    out << " movq $-151, %r8\n";
+    out << " movq %rdx, %r9\n";
+    out << " jmp .salida_mantisa_lista\n";
+    out << ".salida_normal:\n";
+    out << " leaq -152(%rcx), %r8\n";
+    out << " movq %rdx, %r9\n";
+    out << " orq $8388608, %r9\n";
+    out << ".salida_mantisa_lista:\n";
+    out << " movq %rdi, -200(%rbp)\n";
+    out << " movq %r8, -184(%rbp)\n";
+    out << " movq %r9, %rax\n";
+    out << " andq $1, %rax\n";
+    out << " xorq $1, %rax\n";
+    out << " movq %rax, -88(%rbp)\n";
+    out << " shlq $2, %r9\n";
+    out << " movq %r9, -160(%rbp)\n";
+    out << " leaq 2(%r9), %rax\n";
+    out << " movq %rax, -168(%rbp)\n";
+    out << " movq $1, %rax\n";
+    out << " testq %rdx, %rdx\n";
+    out << " jne .salida_desplazamiento\n";
+    out << " cmpq $1, %rcx\n";
+    out << " jle .salida_desplazamiento\n";
+    out << " xorq %rax, %rax\n";
+    out << ".salida_desplazamiento:\n";
+    out << " movq %rax, -152(%rbp)\n";
+    out << " movq %r9, %r10\n";
+    out << " decq %r10\n";
+    out << " subq %rax, %r10\n";
+    out << " movq %r10, -176(%rbp)\n";
+    out << " xorq %rsi, %rsi\n";
+    out << " xorq %rdi, %rdi\n";
+    out << " movq $0, -224(%rbp)\n";
+    out << " testq %r8, %r8\n";
+    out << " js .salida_e2_negativo\n";
+    out << " movq $78913, %rax\n";
+    out << " imulq %r8, %rax\n";
+    out << " shrq $18, %rax\n";
+    out << " movq %rax, -192(%rbp)\n";
+    out << " movq %rax, -72(%rbp)\n";
+    out << " movq $1217359, %rcx\n";
+    out << " imulq %rax, %rcx\n";
+    out << " shrq $19, %rcx\n";
+    out << " addq $59, %rcx\n";
+    out << " addq %rax, %rcx\n";
+    out << " subq %r8, %rcx\n";
+    out << " movq %rcx, -208(%rbp)\n";
+    out << " leaq salida_ryu_inversas(%rip), %rdx\n";
+    out << " shlq $3, %rax\n";
+    out << " addq %rax, %rdx\n";
+    out << " movq (%rdx), %rdx\n";
+    out << " movq %rdx, -216(%rbp)\n";
+    out << " jmp .salida_multiplicar_tres\n";
+    out << ".salida_e2_negativo:\n";
+    out << " movq %r8, %rax\n";
+    out << " negq %rax\n";
+    out << " movq $732923, %rcx\n";
+    out << " imulq %rcx, %rax\n";
+    out << " shrq $20, %rax\n";
+    out << " movq %rax, -192(%rbp)\n";
+    out << " movq %rax, %rcx\n";
+    out << " addq %r8, %rcx\n";
+    out << " movq %rcx, -72(%rbp)\n";
+    out << " movq %r8, %rcx\n";
+    out << " negq %rcx\n";
+    out << " subq %rax, %rcx\n";
+    out << " movq %rcx, -232(%rbp)\n";
+    out << " movq $1217359, %rdx\n";
+    out << " imulq %rcx, %rdx\n";
+    out << " shrq $19, %rdx\n";
+    out << " addq $60, %rax\n";
+    out << " subq %rdx, %rax\n";
+    out << " movq %rax, -208(%rbp)\n";
+    out << " leaq salida_ryu_potencias(%rip), %rdx\n";
+    out << " shlq $3, %rcx\n";
+    out << " addq %rcx, %rdx\n";
+    out << " movq (%rdx), %rdx\n";
+    out << " movq %rdx, -216(%rbp)\n";
+    out << ".salida_multiplicar_tres:\n";
+    out << " movq -160(%rbp), %rax\n";
+    out << " movq -216(%rbp), %rdx\n";
+    out << " movq -208(%rbp), %rcx\n";
+    out << " call salida_multiplicar\n";
+    out << " movq %rax, %r8\n";
+    out << " movq -168(%rbp), %rax\n";
+    out << " movq -216(%rbp), %rdx\n";
+    out << " movq -208(%rbp), %rcx\n";
+    out << " call salida_multiplicar\n";
+    out << " movq %rax, %r9\n";
+    out << " movq -176(%rbp), %rax\n";
+    out << " movq -216(%rbp), %rdx\n";
+    out << " movq -208(%rbp), %rcx\n";
+    out << " call salida_multiplicar\n";
+    out << " movq %rax, %r10\n";
+    out << " cmpq $0, -192(%rbp)\n";
+    out << " je .salida_ceros_ryu\n";
+    out << " movq $10, %rcx\n";
+    out << " movq %r9, %rax\n";
+    out << " decq %rax\n";
+    out << " xorl %edx, %edx\n";
+    out << " divq %rcx\n";
+    out << " movq %rax, %r11\n";
+    out << " movq %r10, %rax\n";
+    out << " xorl %edx, %edx\n";
+    out << " divq %rcx\n";
+    out << " cmpq %rax, %r11\n";
+    out << " ja .salida_ceros_ryu\n";
+    out << " movq -192(%rbp), %rax\n";
+    out << " decq %rax\n";
+    out << " cmpq $0, -184(%rbp)\n";
+    out << " jl .salida_ultimo_negativo\n";
+    out << " movq $1217359, %rcx\n";
+    out << " imulq %rax, %rcx\n";
+    out << " shrq $19, %rcx\n";
+    out << " addq $59, %rcx\n";
+    out << " addq %rax, %rcx\n";
+    out << " subq -184(%rbp), %rcx\n";
+    out << " leaq salida_ryu_inversas(%rip), %rdx\n";
+    out << " jmp .salida_ultimo_factor\n";
+    out << ".salida_ultimo_negativo:\n";
+    out << " movq -232(%rbp), %rax\n";
+    out << " incq %rax\n";
+    out << " movq $1217359, %rcx\n";
+    out << " imulq %rax, %rcx\n";
+    out << " shrq $19, %rcx\n";
+    out << " movq -192(%rbp), %rdx\n";
+    out << " addq $59, %rdx\n";
+    out << " subq %rcx, %rdx\n";
+    out << " movq %rdx, %rcx\n";
+    out << " leaq salida_ryu_potencias(%rip), %rdx\n";
+    out << ".salida_ultimo_factor:\n";
+    out << " shlq $3, %rax\n";
+    out << " addq %rax, %rdx\n";
+    out << " movq (%rdx), %rdx\n";
+    out << " movq -160(%rbp), %rax\n";
+    out << " call salida_multiplicar\n";
+    out << " xorl %edx, %edx\n";
+    out << " movq $10, %rcx\n";
+    out << " divq %rcx\n";
+    out << " movq %rdx, -224(%rbp)\n";
+    out << ".salida_ceros_ryu:\n";
+    out << " cmpq $0, -184(%rbp)\n";
+    out << " jl .salida_ceros_negativo\n";
+    out << " cmpq $9, -192(%rbp)\n";
+    out << " ja .salida_quitar_inicio\n";
+    out << " movq -160(%rbp), %rax\n";
+    out << " xorl %edx, %edx\n";
+    out << " movq $5, %rcx\n";
+    out << " divq %rcx\n";
+    out << " testq %rdx, %rdx\n";
+    out << " jne .salida_mv_sin_cinco\n";
+    out << " movq -160(%rbp), %rax\n";
+    out << " movq -192(%rbp), %rcx\n";
+    out << " call salida_multiplo5\n";
+    out << " movq %rax, %rsi\n";
+    out << " jmp .salida_quitar_inicio\n";
+    out << ".salida_mv_sin_cinco:\n";
+    out << " cmpq $0, -88(%rbp)\n";
+    out << " je .salida_mp_cinco\n";
+    out << " movq -176(%rbp), %rax\n";
+    out << " movq -192(%rbp), %rcx\n";
+    out << " call salida_multiplo5\n";
+    out << " movq %rax, %rdi\n";
+    out << " jmp .salida_quitar_inicio\n";
+    out << ".salida_mp_cinco:\n";
+    out << " movq -168(%rbp), %rax\n";
+    out << " movq -192(%rbp), %rcx\n";
+    out << " call salida_multiplo5\n";
+    out << " subq %rax, %r9\n";
+    out << " jmp .salida_quitar_inicio\n";
+    out << ".salida_ceros_negativo:\n";
+    out << " cmpq $1, -192(%rbp)\n";
+    out << " ja .salida_q_mayor\n";
+    out << " movq $1, %rsi\n";
+    out << " cmpq $0, -88(%rbp)\n";
+    out << " je .salida_vp_menos\n";
+    out << " movq -152(%rbp), %rdi\n";
+    out << " jmp .salida_quitar_inicio\n";
+    out << ".salida_vp_menos:\n";
+    out << " decq %r9\n";
+    out << " jmp .salida_quitar_inicio\n";
+    out << ".salida_q_mayor:\n";
+    out << " cmpq $31, -192(%rbp)\n";
+    out << " jae .salida_quitar_inicio\n";
+    out << " movq $65, %rcx\n";
+    out << " subq -192(%rbp), %rcx\n";
+    out << " movq -160(%rbp), %rax\n";
+    out << " shlq %cl, %rax\n";
+    out << " testq %rax, %rax\n";
+    out << " jne .salida_quitar_inicio\n";
+    out << " movq $1, %rsi\n";
+    out << ".salida_quitar_inicio:\n";
+    out << " movq -224(%rbp), %r11\n";
+    out << " movq $0, -80(%rbp)\n";
+    out << " movq $-1, -96(%rbp)\n";
+    out << " movq $10, %rcx\n";
+    out << ".salida_quitar:\n";
+    out << " cmpq $10, %r8\n";
+    out << " jb .salida_sin_dos\n";
+    out << " cmpq $100, %r8\n";
+    out << " jae .salida_sin_dos\n";
+    out << " movq -80(%rbp), %rax\n";
+    out << " movq %rax, -96(%rbp)\n";
+    out << " movq %r8, -104(%rbp)\n";
+    out << " movq %r9, -112(%rbp)\n";
+    out << " movq %r10, -120(%rbp)\n";
+    out << " movq %r11, -128(%rbp)\n";
+    out << " movq %rsi, -136(%rbp)\n";
+    out << " movq %rdi, -144(%rbp)\n";
+    out << ".salida_sin_dos:\n";
+    out << " movq %r9, %rax\n";
+    out << " xorl %edx, %edx\n";
+    out << " divq %rcx\n";
+    out << " movq %rax, -240(%rbp)\n";
+    out << " movq %r10, %rax\n";
+    out << " xorl %edx, %edx\n";
+    out << " divq %rcx\n";
+    out << " cmpq %rax, -240(%rbp)\n";
+    out << " ja .salida_quitar_digito\n";
+    out << " testq %rdi, %rdi\n";
+    out << " je .salida_quitado\n";
+    out << " testq %rdx, %rdx\n";
+    out << " jne .salida_quitado\n";
+    out << ".salida_quitar_digito:\n";
+    out << " movq %rax, %r10\n";
+    out << " testq %rdx, %rdx\n";
+    out << " je .salida_vm_exacto\n";
+    out << " xorq %rdi, %rdi\n";
+    out << ".salida_vm_exacto:\n";
+    out << " testq %r11, %r11\n";
+    out << " je .salida_vr_exacto\n";
+    out << " xorq %rsi, %rsi\n";
+    out << ".salida_vr_exacto:\n";
+    out << " movq -240(%rbp), %r9\n";
+    out << " movq %r8, %rax\n";
+    out << " xorl %edx, %edx\n";
+    out << " divq %rcx\n";
+    out << " movq %rax, %r8\n";
+    out << " movq %rdx, %r11\n";
+    out << " incq -80(%rbp)\n";
+    out << " jmp .salida_quitar\n";
+    out << ".salida_quitado:\n";
+    out << " testq %rsi, %rsi\n";
+    out << " je .salida_redondear_ryu\n";
+    out << " cmpq $5, %r11\n";
+    out << " jne .salida_redondear_ryu\n";
+    out << " movq %r8, %rax\n";
+    out << " andq $1, %rax\n";
+    out << " jne .salida_redondear_ryu\n";
+    out << " movq $4, %r11\n";
+    out << ".salida_redondear_ryu:\n";
+    out << " movq %r8, %rax\n";
+    out << " cmpq $5, %r11\n";
+    out << " jae .salida_subir_ryu\n";
+    out << " cmpq %r10, %r8\n";
+    out << " jne .salida_redondeado\n";
+    out << " cmpq $0, -88(%rbp)\n";
+    out << " je .salida_subir_ryu\n";
+    out << " testq %rdi, %rdi\n";
+    out << " jne .salida_redondeado\n";
+    out << ".salida_subir_ryu:\n";
+    out << " incq %rax\n";
+    out << ".salida_redondeado:\n";
+    out << " cmpq $10, %r8\n";
+    out << " jae .salida_decimal\n";
+    out << " cmpq $0, -96(%rbp)\n";
+    out << " jl .salida_decimal\n";
+    out << " movq -104(%rbp), %rax\n";
+    out << " movq -128(%rbp), %rdx\n";
+    out << " cmpq $0, -136(%rbp)\n";
+    out << " je .salida_dos_redondear\n";
+    out << " cmpq $5, %rdx\n";
+    out << " jne .salida_dos_redondear\n";
+    out << " movq %rax, %rcx\n";
+    out << " andq $1, %rcx\n";
+    out << " jne .salida_dos_redondear\n";
+    out << " movq $4, %rdx\n";
+    out << ".salida_dos_redondear:\n";
+    out << " cmpq $5, %rdx\n";
+    out << " jb .salida_dos_cercano\n";
+    out << " incq %rax\n";
+    out << ".salida_dos_cercano:\n";
+    out << " cmpq -112(%rbp), %rax\n";
+    out << " ja .salida_dos_fuera\n";
+    out << " cmpq -120(%rbp), %rax\n";
+    out << " ja .salida_dos_dentro\n";
+    out << " jne .salida_dos_fuera\n";
+    out << " cmpq $0, -88(%rbp)\n";
+    out << " je .salida_dos_fuera\n";
+    out << " cmpq $0, -144(%rbp)\n";
+    out << " jne .salida_dos_dentro\n";
+    out << ".salida_dos_fuera:\n";
+    out << " cmpq -104(%rbp), %rax\n";
+    out << " jne .salida_dos_abajo\n";
+    out << " incq %rax\n";
+    out << " jmp .salida_dos_dentro\n";
+    out << ".salida_dos_abajo:\n";
+    out << " movq -104(%rbp), %rax\n";
+    out << ".salida_dos_dentro:\n";
+    out << " movq -96(%rbp), %rcx\n";
+    out << " movq %rcx, -80(%rbp)\n";
+    out << ".salida_decimal:\n";
+    out << " movq -72(%rbp), %r9\n";
+    out << " addq -80(%rbp), %r9\n";
+    out << " movq $10, %rcx\n";
+    out << ".salida_ceros_finales:\n";
+    out << " movq %rax, %r8\n";
+    out << " xorl %edx, %edx\n";
+    out << " divq %rcx\n";
+    out << " testq %rdx, %rdx\n";
+    out << " jne .salida_sin_ceros\n";
+    out << " incq %r9\n";
+    out << " jmp .salida_ceros_finales\n";
+    out << ".salida_sin_ceros:\n";
+    out << " movq %r8, %rax\n";
+    out << " leaq -20(%rbp), %rsi\n";
+    out << " movq %rsi, %r10\n";
+    out << ".salida_digito_ryu:\n";
+    out << " xorl %edx, %edx\n";
+    out << " divq %rcx\n";
+    out << " addq $48, %rdx\n";
+    out << " decq %rsi\n";
+    out << " movb %dl, (%rsi)\n";
+    out << " testq %rax, %rax\n";
+    out << " jne .salida_digito_ryu\n";
+    out << " subq %rsi, %r10\n";
+    out << " addq %r10, %r9\n";
+    out << " movq -200(%rbp), %rdi\n";
+    out << " cmpq $-3, %r9\n";
+    out << " jle .salida_cientifica\n";
+    out << " cmpq $7, %r9\n";
+    out << " jg .salida_cientifica\n";
+    out << " testq %r9, %r9\n";
+    out << " jg .salida_con_entera\n";
+    out << " movb $48, (%rdi)\n";
+    out << " movb $46, 1(%rdi)\n";
+    out << " addq $2, %rdi\n";
+    out << " movq %r9, %rcx\n";
+    out << " negq %rcx\n";
+    out << ".salida_ceros_iniciales:\n";
+    out << " testq %rcx, %rcx\n";
+    out << " je .salida_fraccion_ryu\n";
+    out << " movb $48, (%rdi)\n";
+    out << " incq %rdi\n";
+    out << " decq %rcx\n";
+    out << " jmp .salida_ceros_iniciales\n";
+    out << ".salida_fraccion_ryu:\n";
+    out << " movq %r10, %r11\n";
+    out << " jmp .salida_copiar_resto\n";
+    out << ".salida_con_entera:\n";
+    out << " movq %r9, %rcx\n";
+    out << " cmpq %r10, %r9\n";
+    out << " jl .salida_copiar_entera\n";
+    out << " movq %r10, %rcx\n";
+    out << ".salida_copiar_entera:\n";
+    out << " movzbq (%rsi), %rax\n";
+    out << " movb %al, (%rdi)\n";
+    out << " incq %rsi\n";
+    out << " incq %rdi\n";
+    out << " decq %rcx\n";
+    out << " jne .salida_copiar_entera\n";
+    out << " cmpq %r10, %r9\n";
+    out << " jl .salida_punto_medio\n";
+    out << " movq %r9, %rcx\n";
+    out << " subq %r10, %rcx\n";
+    out << ".salida_ceros_enteros:\n";
+    out << " testq %rcx, %rcx\n";
+    out << " je .salida_punto_cero\n";
+    out << " movb $48, (%rdi)\n";
+    out << " incq %rdi\n";
+    out << " decq %rcx\n";
+    out << " jmp .salida_ceros_enteros\n";
+    out << ".salida_punto_cero:\n";
+    out << " movb $46, (%rdi)\n";
+    out << " movb $48, 1(%rdi)\n";
+    out << " addq $2, %rdi\n";
+    out << " jmp .salida_flotante_fin\n";
+    out << ".salida_punto_medio:\n";
+    out << " movb $46, (%rdi)\n";
+    out << " incq %rdi\n";
+    out << " movq %r10, %r11\n";
+    out << " subq %r9, %r11\n";
+    out << ".salida_copiar_resto:\n";
+    out << " testq %r11, %r11\n";
+    out << " je .salida_flotante_fin\n";
+    out << " movzbq (%rsi), %rax\n";
+    out << " movb %al, (%rdi)\n";
+    out << " incq %rsi\n";
+    out << " incq %rdi\n";
+    out << " decq %r11\n";
+    out << " jmp .salida_copiar_resto\n";
+    out << ".salida_cientifica:\n";
+    out << " movzbq (%rsi), %rax\n";
+    out << " movb %al, (%rdi)\n";
+    out << " movb $46, 1(%rdi)\n";
+    out << " addq $2, %rdi\n";
+    out << " incq %rsi\n";
+    out << " movq %r10, %r11\n";
+    out << " decq %r11\n";
+    out << " jne .salida_mantisa_ryu\n";
+    out << " movb $48, (%rdi)\n";
+    out << " incq %rdi\n";
+    out << " jmp .salida_exponente_ryu\n";
+    out << ".salida_mantisa_ryu:\n";
+    out << " movzbq (%rsi), %rax\n";
+    out << " movb %al, (%rdi)\n";
+    out << " incq %rsi\n";
+    out << " incq %rdi\n";
+    out << " decq %r11\n";
+    out << " jne .salida_mantisa_ryu\n";
+    out << ".salida_exponente_ryu:\n";
+    out << " movb $69, (%rdi)\n";
+    out << " incq %rdi\n";
+    out << " movq %r9, %rax\n";
+    out << " decq %rax\n";
+    out << " jns .salida_exponente_positivo\n";
+    out << " movb $45, (%rdi)\n";
+    out << " incq %rdi\n";
+    out << " negq %rax\n";
+    out << ".salida_exponente_positivo:\n";
+    out << " cmpq $10, %rax\n";
+    out << " jb .salida_exponente_digito\n";
+    out << " xorl %edx, %edx\n";
+    out << " movq $10, %rcx\n";
+    out << " divq %rcx\n";
+    out << " addq $48, %rax\n";
+    out << " movb %al, (%rdi)\n";
+    out << " incq %rdi\n";
+    out << " movq %rdx, %rax\n";
+    out << ".salida_exponente_digito:\n";
+    out << " addq $48, %rax\n";
+    out << " movb %al, (%rdi)\n";
+    out << " incq %rdi\n";
+    out << ".salida_flotante_fin:\n";
+    out << " movq %rdi, %rax\n";
+    out << " leave\n";
+    out << " ret\n";
+    out << "salida_multiplicar:\n";
+    out << " movq %rdx, %r11\n";
+    out << " shrq $32, %r11\n";
+    out << " imulq %rax, %r11\n";
+    out << " shlq $32, %rdx\n";
+    out << " shrq $32, %rdx\n";
+    out << " imulq %rdx, %rax\n";
+    out << " shrq $32, %rax\n";
+    out << " addq %r11, %rax\n";
+    out << " subq $32, %rcx\n";
+    out << " shrq %cl, %rax\n";
+    out << " ret\n";
+    out << "salida_multiplo5:\n";
+    out << " movq %rcx, %r11\n";
+    out << " movq $5, %rcx\n";
+    out << ".salida_multiplo5_ciclo:\n";
+    out << " testq %r11, %r11\n";
+    out << " je .salida_multiplo5_si\n";
+    out << " xorl %edx, %edx\n";
+    out << " divq %rcx\n";
+    out << " testq %rdx, %rdx\n";
+    out << " jne .salida_multiplo5_no\n";
+    out << " decq %r11\n";
+    out << " jmp .salida_multiplo5_ciclo\n";
+    out << ".salida_multiplo5_si:\n";
+    out << " movq $1, %rax\n";
+    out << " ret\n";
+    out << ".salida_multiplo5_no:\n";
+    out << " xorq %rax, %rax\n";
+    out << " ret\n";
+}
+
+void GenCodeVisitor::emitPrint(int type)
+{
+    if (type == 5)
+    {
+        out << " movq %rax, %rdi\n";
+        out << " call salida_cadena\n";
+    }
+    else if (type == 2)
+    {
+        out << " call salida_flotante\n";
+    }
+    else
+    {
+        out << " movq %rax, %rdi\n";
+        out << " call salida_entero\n";
+    }
+}
+
+// Valor de tipo type (en rax o xmm0) a String en rax
+void GenCodeVisitor::emitToString(int type)
+{
+    usaCadenas = true;
+    if (type == 2)
+    {
+        out << " call cadena_de_flotante\n";
+        return;
+    }
+    out << " movq %rax, %rdi\n";
+    out << (type == 3 ? " call cadena_de_booleano\n" : " call cadena_de_entero\n");
+}
+
+void GenCodeVisitor::emitConcat(int pieces)
+{
+    usaCadenas = true;
+    out << " movq $" << pieces << ", %rdi\n";
+    out << " movq %rsp, %rsi\n";
+    out << " call cadena_concatenar\n";
+    out << " addq $" << 8 * pieces << ", %rsp\n";
+}
+
+// Bytes que ocupa el literal una vez que el ensamblador resuelve los escapes
+static size_t assembledLength(const string &value)
+{
+    size_t length = 0;
+    for (size_t i = 0; i < value.size(); i++, length++)
+    {
+        if (value[i] != '\\' || i + 1 >= value.size())
+            continue;
+        i++;
+        for (int digits = 1; digits < 3 && value[i] >= '0' && value[i] <= '7' && i + 1 < value.size() &&
+                             value[i + 1] >= '0' && value[i + 1] <= '7';
+             digits++)
+            i++;
+    }
+    return length;
+}
+
 int GenCodeVisitor::visit(NumberExp *exp)
 {
     out << " movq $" << exp->value << ", %rax\n";
@@ -1695,7 +3299,7 @@ int GenCodeVisitor::visit(NumberExp *exp)
 int GenCodeVisitor::visit(DecimalExp *exp)
 {
     string label = getFloatConstantLabel(exp->value);
-    out << " movsd " << label << "(%rip), %xmm0\n";
+    out << " movss " << label << "(%rip), %xmm0\n";
     return 2;
 }
 
@@ -1707,12 +3311,7 @@ int GenCodeVisitor::visit(BoolExp *exp)
 
 int GenCodeVisitor::visit(StringExp *exp)
 {
-    static int stringCount = 0;
-    string label = "str_" + to_string(stringCount++);
-    out << " .section .rodata\n";
-    out << label << ": .string \"" << exp->value << "\"\n";
-    out << " .text\n";
-    out << " leaq " << label << "(%rip), %rax\n";
+    out << " leaq " << getStringConstantLabel(exp->value) << "(%rip), %rax\n";
     return 5;
 }
 
@@ -1723,11 +3322,11 @@ int GenCodeVisitor::visit(IdentifierExp *exp)
     if (type == 2)
     {
         if (memoriaGlobal.count(exp->name))
-            out << " movsd " << exp->name << "(%rip), %xmm0\n";
+            out << " movss " << exp->name << "(%rip), %xmm0\n";
         else if (memoria.count(exp->name))
-            out << " movsd " << memoria[exp->name] << "(%rbp), %xmm0\n";
+            out << " movss " << memoria[exp->name] << "(%rbp), %xmm0\n";
         else
-            out << " xorpd %xmm0, %xmm0\n";
+            out << " xorps %xmm0, %xmm0\n";
     }
     else
     {
@@ -1743,122 +3342,173 @@ int GenCodeVisitor::visit(IdentifierExp *exp)
 
 int GenCodeVisitor::visit(BinaryExp *exp)
 {
-    int leftType = exp->left->accept(this);
+    return genOperators(exp);
+}
 
-    if (leftType == 2)
+int GenCodeVisitor::genOperators(Exp *exp)
+{
+    walk(exp);
+    int type = typeStack.back();
+    typeStack.pop_back();
+    return type;
+}
+
+void GenCodeVisitor::onLeaf(Exp *exp)
+{
+    typeStack.push_back(exp->accept(this));
+}
+
+void GenCodeVisitor::onEnter(Exp *exp)
+{
+    BinaryExp *bin = dynamic_cast<BinaryExp *>(exp);
+    BinaryExp *left = bin ? dynamic_cast<BinaryExp *>(bin->left) : nullptr;
+    if (bin && bin->op == PLUS_OP && left && left->op == PLUS_OP)
+        concatChain[left] = 0;
+}
+
+bool GenCodeVisitor::onOperand(BinaryExp *exp)
+{
+    if (exp->op == AND_OP || exp->op == OR_OP)
+    {
+        // El izquierdo queda en rax; si ya decide el resultado se salta el derecho
+        int label = labelcont++;
+        shortCircuitLabels.push_back(label);
+        out << " testq %rax, %rax\n";
+        out << (exp->op == AND_OP ? " je" : " jne") << " .sc_short_" << label << "\n";
+        return true;
+    }
+
+    auto chain = concatChain.find(exp->left);
+    if (chain == concatChain.end() || chain->second == 0)
+        pushOperand(typeStack.back());
+    return true;
+}
+
+void GenCodeVisitor::pushOperand(int type)
+{
+    if (type == 2)
     {
-        out << " movsd %xmm0, -8(%rsp)\n";
+        out << " movss %xmm0, -8(%rsp)\n";
         out << " subq $8, %rsp\n";
     }
     else
     {
         out << " pushq %rax\n";
     }
+}
 
-    int rightType = exp->right->accept(this);
-
-    if ((leftType == 5 || rightType == 5) && exp->op == PLUS_OP)
+void GenCodeVisitor::onExit(Exp *exp)
+{
+    BinaryExp *bin = dynamic_cast<BinaryExp *>(exp);
+    if (bin && (bin->op == AND_OP || bin->op == OR_OP))
     {
-        out << " movq %rax, %r8\n";
-        out << " popq %r9\n";
-
-        out << " leaq string_buffer(%rip), %rax\n";
-
-        out << " movq %rax, %rdi\n";
-        out << " movq %r9, %rsi\n";
-        out << " call strcpy@PLT\n";
-
-        out << " leaq string_buffer(%rip), %rdi\n";
-        out << " movq %r8, %rsi\n";
-        out << " call strcat@PLT\n";
+        int label = shortCircuitLabels.back();
+        shortCircuitLabels.pop_back();
+        out << " testq %rax, %rax\n";
+        out << " setne %al\n";
+        out << " movzbq %al, %rax\n";
+        out << " jmp .sc_end_" << label << "\n";
+        out << ".sc_short_" << label << ":\n";
+        out << " movq $" << (bin->op == OR_OP ? 1 : 0) << ", %rax\n";
+        out << ".sc_end_" << label << ":\n";
+        typeStack.pop_back();
+        typeStack.back() = 3;
+    }
+    else if (bin)
+    {
+        int rightType = typeStack.back();
+        typeStack.pop_back();
+        typeStack.back() = emitBinaryOp(bin, typeStack.back(), rightType);
+    }
+    else if (UnaryExp *unary = dynamic_cast<UnaryExp *>(exp))
+    {
+        typeStack.back() = emitUnaryOp(unary, typeStack.back());
+    }
+}
 
-        out << " leaq string_buffer(%rip), %rax\n";
+static bool isComparison(int op)
+{
+    int precedence = getOperatorPrecedence(static_cast<BinaryOp>(op));
+    return precedence == 3 || precedence == 4;
+}
 
-        return 5;
-    }
+static string invertCondition(const string &condition)
+{
+    static const unordered_map<string, string> inverse = {
+        {"l", "ge"}, {"ge", "l"}, {"le", "g"}, {"g", "le"},
+        {"b", "ae"}, {"ae", "b"}, {"be", "a"}, {"a", "be"},
+        {"e", "ne"}, {"ne", "e"}};
+    return inverse.at(condition);
+}
 
-    bool isFloat = (leftType == 2 || rightType == 2);
+int GenCodeVisitor::emitBinaryOp(BinaryExp *exp, int leftType, int rightType)
+{
 
-    if (isFloat)
+    if ((leftType == 5 || rightType == 5) && exp->op == PLUS_OP)
     {
-        if (rightType == 2)
+        int pieces = 1;
+        auto left = concatChain.find(exp->left);
+        if (left != concatChain.end())
         {
-            out << " movsd %xmm0, %xmm1\n";
+            pieces = max(left->second, 1);
+            concatChain.erase(left);
         }
-        else
+        bool chained = pieces > 1;
+        // Las piezas que no son String se convierten antes de concatenar; el
+        // izquierdo, si no es una cadena de concatenaciones, está en la pila
+        if (rightType != 5)
+            emitToString(rightType);
+        out << " pushq %rax\n";
+        if (!chained && leftType != 5)
         {
-            out << " cvtsi2sd %rax, %xmm1\n";
+            out << (leftType == 2 ? " movss 8(%rsp), %xmm0\n" : " movq 8(%rsp), %rax\n");
+            emitToString(leftType);
+            out << " movq %rax, 8(%rsp)\n";
         }
+        pieces++;
 
-        if (leftType == 2)
-        {
-            out << " movsd (%rsp), %xmm0\n";
-            out << " addq $8, %rsp\n";
-        }
+        auto self = concatChain.find(exp);
+        if (self != concatChain.end())
+            self->second = pieces;
         else
-        {
-            out << " popq %rax\n";
-            out << " cvtsi2sd %rax, %xmm0\n";
-        }
+            emitConcat(pieces);
+        return 5;
+    }
 
+    if (isComparison(exp->op))
+    {
+        string condition = emitCompare(exp->op, leftType, rightType);
+        out << " movl $0, %eax\n";
+        out << " set" << condition << " %al\n";
+        out << " movzbq %al, %rax\n";
+        return 3;
+    }
+
+    bool isFloat = popOperands(leftType, rightType);
+
+    if (isFloat)
+    {
         switch (exp->op)
         {
         case PLUS_OP:
-            out << " addsd %xmm1, %xmm0\n";
+            out << " addss %xmm1, %xmm0\n";
             break;
         case MINUS_OP:
-            out << " subsd %xmm1, %xmm0\n";
+            out << " subss %xmm1, %xmm0\n";
             break;
         case MUL_OP:
-            out << " mulsd %xmm1, %xmm0\n";
+            out << " mulss %xmm1, %xmm0\n";
             break;
         case DIV_OP:
-            out << " divsd %xmm1, %xmm0\n";
+            out << " divss %xmm1, %xmm0\n";
             break;
-        case LT_OP:
-            out << " comisd %xmm1, %xmm0\n";
-            out << " movl $0, %eax\n";
-            out << " setb %al\n";
-            out << " movzbq %al, %rax\n";
-            return 3;
-        case LE_OP:
-            out << " comisd %xmm1, %xmm0\n";
-            out << " movl $0, %eax\n";
-            out << " setbe %al\n";
-            out << " movzbq %al, %rax\n";
-            return 3;
-        case GT_OP:
-            out << " comisd %xmm1, %xmm0\n";
-            out << " movl $0, %eax\n";
-            out << " seta %al\n";
-            out << " movzbq %al, %rax\n";
-            return 3;
-        case GE_OP:
-            out << " comisd %xmm1, %xmm0\n";
-            out << " movl $0, %eax\n";
-            out << " setae %al\n";
-            out << " movzbq %al, %rax\n";
-            return 3;
-        case EQ_OP:
-            out << " comisd %xmm1, %xmm0\n";
-            out << " movl $0, %eax\n";
-            out << " sete %al\n";
-            out << " movzbq %al, %rax\n";
-            return 3;
-        case NE_OP:
-            out << " comisd %xmm1, %xmm0\n";
-            out << " movl $0, %eax\n";
-            out << " setne %al\n";
-            out << " movzbq %al, %rax\n";
-            return 3;
+        default:
+            throw runtime_error("operador no soportado con Float en el código generado");
         }
         return 2;
     }
     else
     {
-        out << " movq %rax, %rcx\n";
-        out << " popq %rax\n";
-
         switch (exp->op)
         {
         case PLUS_OP:
@@ -1879,75 +3529,109 @@ int GenCodeVisitor::visit(BinaryExp *exp)
             out << " idivq %rcx\n";
             out << " movq %rdx, %rax\n";
             break;
-        case LT_OP:
-            out << " cmpq %rcx, %rax\n";
-            out << " movl $0, %eax\n";
-            out << " setl %al\n";
-            out << " movzbq %al, %rax\n";
-            return 3;
+        default:
+            throw runtime_error("operador no soportado con Int en el código generado");
+        }
+        return 1;
+    }
+}
+
+// Saca el operando izquierdo de la pila y deja izquierdo/derecho en
+// xmm0/xmm1 (si alguno es Float) o en rax/rcx. Devuelve si es flotante.
+bool GenCodeVisitor::popOperands(int leftType, int rightType)
+{
+    if (leftType == 2 || rightType == 2)
+    {
+        if (rightType == 2)
+        {
+            out << " movss %xmm0, %xmm1\n";
+        }
+        else
+        {
+            out << " cvtsi2ss %rax, %xmm1\n";
+        }
+
+        if (leftType == 2)
+        {
+            out << " movss (%rsp), %xmm0\n";
+            out << " addq $8, %rsp\n";
+        }
+        else
+        {
+            out << " popq %rax\n";
+            out << " cvtsi2ss %rax, %xmm0\n";
+        }
+        return true;
+    }
+
+    out << " movq %rax, %rcx\n";
+    out << " popq %rax\n";
+    return false;
+}
+
+// Emite la comparación y devuelve el sufijo de condición (l, ae, ...) para
+// setcc o jcc. Float usa comiss, que compara sin signo.
+string GenCodeVisitor::emitCompare(int op, int leftType, int rightType)
+{
+    // Dos String son iguales por contenido, no por dirección
+    if (leftType == 5 && rightType == 5 && (op == EQ_OP || op == NE_OP))
+    {
+        usaCadenas = true;
+        out << " movq %rax, %rsi\n";
+        out << " popq %rdi\n";
+        out << " call cadena_igual\n";
+        out << " testq %rax, %rax\n";
+        return op == EQ_OP ? "ne" : "e";
+    }
+
+    if (popOperands(leftType, rightType))
+    {
+        out << " comiss %xmm1, %xmm0\n";
+        switch (op)
+        {
+        case LT_OP:
+            return "b";
         case LE_OP:
-            out << " cmpq %rcx, %rax\n";
-            out << " movl $0, %eax\n";
-            out << " setle %al\n";
-            out << " movzbq %al, %rax\n";
-            return 3;
+            return "be";
         case GT_OP:
-            out << " cmpq %rcx, %rax\n";
-            out << " movl $0, %eax\n";
-            out << " setg %al\n";
-            out << " movzbq %al, %rax\n";
-            return 3;
+            return "a";
         case GE_OP:
-            out << " cmpq %rcx, %rax\n";
-            out << " movl $0, %eax\n";
-            out << " setge %al\n";
-            out << " movzbq %al, %rax\n";
-            return 3;
+            return "ae";
         case EQ_OP:
-            out << " cmpq %rcx, %rax\n";
-            out << " movl $0, %eax\n";
-            out << " sete %al\n";
-            out << " movzbq %al, %rax\n";
-            return 3;
-        case NE_OP:
-            out << " cmpq %rcx, %rax\n";
-            out << " movl $0, %eax\n";
-            out << " setne %al\n";
-            out << " movzbq %al, %rax\n";
-            return 3;
-        case AND_OP:
-            out << " testq %rax, %rax\n";
-            out << " setne %al\n";
-            out << " testq %rcx, %rcx\n";
-            out << " setne %cl\n";
-            out << " andb %cl, %al\n";
-            out << " movzbq %al, %rax\n";
-            return 3;
-        case OR_OP:
-            out << " testq %rax, %rax\n";
-            out << " setne %al\n";
-            out << " testq %rcx, %rcx\n";
-            out << " setne %cl\n";
-            out << " orb %cl, %al\n";
-            out << " movzbq %al, %rax\n";
-            return 3;
+            return "e";
+        default:
+            return "ne";
         }
-        return 1;
+    }
+
+    out << " cmpq %rcx, %rax\n";
+    switch (op)
+    {
+    case LT_OP:
+        return "l";
+    case LE_OP:
+        return "le";
+    case GT_OP:
+        return "g";
+    case GE_OP:
+        return "ge";
+    case EQ_OP:
+        return "e";
+    default:
+        return "ne";
     }
 }
 
-int GenCodeVisitor::visit(UnaryExp *exp)
+int GenCodeVisitor::emitUnaryOp(UnaryExp *exp, int type)
 {
-    int type = exp->expr->accept(this);
-
     switch (exp->op)
     {
     case UnaryExp::NEG_OP:
         if (type == 2)
         {
-            out << " xorpd %xmm1, %xmm1\n";
-            out << " subsd %xmm0, %xmm1\n";
-            out << " movsd %xmm1, %xmm0\n";
+            out << " xorps %xmm1, %xmm1\n";
+            out << " subss %xmm0, %xmm1\n";
+            out << " movss %xmm1, %xmm0\n";
         }
         else
         {
@@ -1959,8 +3643,8 @@ int GenCodeVisitor::visit(UnaryExp *exp)
     case UnaryExp::NOT_OP:
         if (type == 2)
         {
-            out << " xorpd %xmm1, %xmm1\n";
-            out << " comisd %xmm1, %xmm0\n";
+            out << " xorps %xmm1, %xmm1\n";
+            out << " comiss %xmm1, %xmm0\n";
             out << " setz %al\n";
             out << " movzbq %al, %rax\n";
             return 3;
@@ -1973,6 +3657,21 @@ int GenCodeVisitor::visit(UnaryExp *exp)
             return 3;
         }
         break;
+    default:
+        break;
+    }
+    return type;
+}
+
+int GenCodeVisitor::visit(UnaryExp *exp)
+{
+    if (isOperatorNode(exp))
+        return genOperators(exp);
+
+    int type = exp->expr->accept(this);
+
+    switch (exp->op)
+    {
     case UnaryExp::PRE_INC_OP:
     case UnaryExp::POST_INC_OP:
     case UnaryExp::PRE_DEC_OP:
@@ -1984,20 +3683,20 @@ int GenCodeVisitor::visit(UnaryExp *exp)
             {
                 if (memoriaGlobal.count(id_exp->name))
                 {
-                    out << " movsd " << id_exp->name << "(%rip), %xmm0\n";
-                    out << " movsd .L_one(%rip), %xmm1\n";
+                    out << " movss " << id_exp->name << "(%rip), %xmm0\n";
+                    out << " movss " << getFloatConstantLabel(1.0) << "(%rip), %xmm1\n";
                     if (exp->op == UnaryExp::PRE_INC_OP || exp->op == UnaryExp::POST_INC_OP)
-                        out << " addsd %xmm1, %xmm0\n";
+                        out << " addss %xmm1, %xmm0\n";
                     else
-                        out << " subsd %xmm1, %xmm0\n";
-                    out << " movsd %xmm0, " << id_exp->name << "(%rip)\n";
+                        out << " subss %xmm1, %xmm0\n";
+                    out << " movss %xmm0, " << id_exp->name << "(%rip)\n";
                 }
                 else
                 {
-                    out << " movsd " << memoria[id_exp->name] << "(%rbp), %xmm0\n";
-                    out << " movsd .L_one(%rip), %xmm1\n";
-                    out << " addsd %xmm1, %xmm0\n";
-                    out << " movsd %xmm0, " << memoria[id_exp->name] << "(%rbp)\n";
+                    out << " movss " << memoria[id_exp->name] << "(%rbp), %xmm0\n";
+                    out << " movss " << getFloatConstantLabel(1.0) << "(%rip), %xmm1\n";
+                    out << " addss %xmm1, %xmm0\n";
+                    out << " movss %xmm0, " << memoria[id_exp->name] << "(%rbp)\n";
                 }
                 return 2;
             }
@@ -2046,7 +3745,7 @@ int GenCodeVisitor::visit(UnaryExp *exp)
 
 int GenCodeVisitor::visit(ParenthesizedExp *exp)
 {
-    return exp->expr->accept(this);
+    return genOperators(exp);
 }
 
 int GenCodeVisitor::visit(RangeExp *exp)
@@ -2057,108 +3756,93 @@ int GenCodeVisitor::visit(RangeExp *exp)
 
 int GenCodeVisitor::visit(RunExp *exp)
 {
-    if (exp->block && exp->block->statements)
+    if (exp->block)
     {
-        exp->block->statements->accept(this);
+        exp->block->accept(this);
     }
     return 0;
 }
 
-int GenCodeVisitor::visit(FunctionCallExp *exp)
+// Evalúa todos los argumentos en la pila, porque evaluar uno puede pisar los
+// registros de los anteriores (operaciones, llamadas anidadas), y después los
+// carga en los registros de la convención según el tipo del parámetro,
+// convirtiendo Int/Float como el intérprete. Los parámetros que no caben en
+// registros no se pasan: FunctionDecl tampoco los lee. Devuelve cuántos
+// registros xmm se usaron.
+int GenCodeVisitor::emitCallArguments(FunctionCallExp *exp)
 {
     vector<string> argRegs = {"%rdi", "%rsi", "%rdx", "%rcx", "%r8", "%r9"};
     vector<string> xmmRegs = {"%xmm0", "%xmm1", "%xmm2", "%xmm3", "%xmm4", "%xmm5", "%xmm6", "%xmm7"};
 
-    if (exp->name == "println" || exp->name == "print")
+    vector<int> argTypes;
+    for (auto arg : exp->args)
     {
-        if (!exp->args.empty())
-        {
-            auto it = exp->args.begin();
-            int type = (*it)->accept(this);
-
-            if (type == 5)
-            {
-                out << " movq %rax, %rsi\n";
-                out << " leaq print_str_fmt(%rip), %rdi\n";
-                out << " movl $0, %eax\n";
-                out << " call printf@PLT\n";
-            }
-            else if (type == 2)
-            {
-                out << " movq $1, %rax\n";
-                out << " leaq print_float_fmt(%rip), %rdi\n";
-                out << " call printf@PLT\n";
-            }
-            else
-            {
-                out << " movq %rax, %rsi\n";
-                out << " leaq print_fmt(%rip), %rdi\n";
-                out << " xorl %eax, %eax\n";
-                out << " call printf@PLT\n";
-            }
-        }
-        return 0;
+        argTypes.push_back(arg->accept(this));
+        pushOperand(argTypes.back());
     }
 
+    int count = argTypes.size();
     int intArgIndex = 0;
     int floatArgIndex = 0;
-
-    for (auto it = exp->args.begin(); it != exp->args.end(); it++)
+    for (int i = 0; i < count; i++)
     {
-        int argType = (*it)->accept(this);
+        int slot = (count - 1 - i) * 8;
+        int paramType = (exp->decl && i < (int)exp->decl->paramTypes.size()) ? exp->decl->paramTypes[i] : argTypes[i];
 
-        if (argType == 2)
+        if (paramType == 2)
         {
-            if (floatArgIndex < 8)
-            {
-                if (floatArgIndex != 0)
-                {
-                    out << " movsd %xmm0, " << xmmRegs[floatArgIndex] << "\n";
-                }
-                floatArgIndex++;
-            }
-            else
-            {
-                out << " movsd %xmm0, -8(%rsp)\n";
-                out << " subq $8, %rsp\n";
-            }
+            if (floatArgIndex >= 8)
+                continue;
+            out << (argTypes[i] == 2 ? " movss " : " cvtsi2ssq ") << slot << "(%rsp), " << xmmRegs[floatArgIndex++] << "\n";
         }
         else
         {
-            if (intArgIndex < 6)
-            {
-                out << " movq %rax, " << argRegs[intArgIndex] << "\n";
-                intArgIndex++;
-            }
-            else
-            {
-                out << " pushq %rax\n";
-            }
+            if (intArgIndex >= 6)
+                continue;
+            out << (argTypes[i] == 2 ? " cvttss2si " : " movq ") << slot << "(%rsp), " << argRegs[intArgIndex++] << "\n";
         }
     }
 
-    out << " movl $" << min(floatArgIndex, 8) << ", %eax\n";
-    out << " call " << exp->name << "\n";
+    if (count > 0)
+        out << " addq $" << count * 8 << ", %rsp\n";
+    return floatArgIndex;
+}
 
-    if (exp->args.size() > 6)
-    {
-        int stackCleanup = (exp->args.size() - 6) * 8;
-        out << " addq $" << stackCleanup << ", %rsp\n";
-    }
+// return g(...) se puede convertir en salto si g devuelve lo mismo que la
+// función actual y todos sus parámetros viajan en registros: el marco actual
+// se descarta y g reutiliza la dirección de retorno del llamador.
+bool GenCodeVisitor::isTailCall(FunctionCallExp *exp)
+{
+    // main no puede saltar a otra función: tiene que volcar la salida al terminar
+    if (!exp->decl || !funcionActual || funcionActual->name == "main" ||
+        exp->decl->returnTypeCode != funcionActual->returnTypeCode)
+        return false;
+    const vector<int> &paramTypes = exp->decl->paramTypes;
+    int floatParams = std::count(paramTypes.begin(), paramTypes.end(), 2);
+    int intParams = paramTypes.size() - floatParams;
+    return intParams <= 6 && floatParams <= 8;
+}
 
-    if (functionReturnTypes.count(exp->name))
+int GenCodeVisitor::visit(FunctionCallExp *exp)
+{
+    if (exp->name == "println" || exp->name == "print")
     {
-        string returnType = functionReturnTypes[exp->name];
-        if (returnType == "Float")
-            return 2;
-        else if (returnType == "Boolean")
-            return 3;
-        else if (returnType == "String")
-            return 5;
-        else if (returnType == "Int")
-            return 1;
+        if (!exp->args.empty())
+        {
+            auto it = exp->args.begin();
+            emitPrint((*it)->accept(this));
+        }
+        return 0;
     }
 
+    int floatArgs = emitCallArguments(exp);
+
+    out << " movl $" << floatArgs << ", %eax\n";
+    out << " call " << exp->name << "\n";
+
+    if (exp->decl && exp->decl->returnTypeCode > 0)
+        return exp->decl->returnTypeCode;
+
     return 0;
 }
 
@@ -2180,24 +3864,24 @@ void GenCodeVisitor::visit(AssignStatement *stm)
             if (valueType == 2)
             {
                 if (memoriaGlobal.count(stm->id))
-                    out << " movsd %xmm0, " << stm->id << "(%rip)\n";
+                    out << " movss %xmm0, " << stm->id << "(%rip)\n";
                 else
-                    out << " movsd %xmm0, " << memoria[stm->id] << "(%rbp)\n";
+                    out << " movss %xmm0, " << memoria[stm->id] << "(%rbp)\n";
             }
             else
             {
-                out << " cvtsi2sd %rax, %xmm0\n";
+                out << " cvtsi2ss %rax, %xmm0\n";
                 if (memoriaGlobal.count(stm->id))
-                    out << " movsd %xmm0, " << stm->id << "(%rip)\n";
+                    out << " movss %xmm0, " << stm->id << "(%rip)\n";
                 else
-                    out << " movsd %xmm0, " << memoria[stm->id] << "(%rbp)\n";
+                    out << " movss %xmm0, " << memoria[stm->id] << "(%rbp)\n";
             }
         }
         else
         {
             if (valueType == 2)
             {
-                out << " cvttsd2si %xmm0, %rax\n";
+                out << " cvttss2si %xmm0, %rax\n";
             }
             if (memoriaGlobal.count(stm->id))
                 out << " movq %rax, " << stm->id << "(%rip)\n";
@@ -2223,19 +3907,10 @@ void GenCodeVisitor::visit(AssignStatement *stm)
             out << " pushq %rdi\n";
 
             int rhsType = stm->rhs->accept(this);
-            out << " movq %rax, %rsi\n";
-            out << " pushq %rsi\n";
-
-            out << " leaq string_buffer(%rip), %rdi\n";
-            out << " leaq .str_concat_fmt(%rip), %rsi\n";
-            out << " movq 8(%rsp), %rdx\n";
-            out << " movq (%rsp), %rcx\n";
-            out << " movl $0, %eax\n";
-            out << " call sprintf@PLT\n";
-
-            out << " addq $16, %rsp\n";
-
-            out << " leaq string_buffer(%rip), %rax\n";
+            if (rhsType != 5)
+                emitToString(rhsType);
+            out << " pushq %rax\n";
+            emitConcat(2);
             if (memoriaGlobal.count(stm->id))
                 out << " movq %rax, " << stm->id << "(%rip)\n";
             else
@@ -2244,43 +3919,43 @@ void GenCodeVisitor::visit(AssignStatement *stm)
         else if (varType == 2)
         {
             if (memoriaGlobal.count(stm->id))
-                out << " movsd " << stm->id << "(%rip), %xmm0\n";
+                out << " movss " << stm->id << "(%rip), %xmm0\n";
             else
-                out << " movsd " << memoria[stm->id] << "(%rbp), %xmm0\n";
+                out << " movss " << memoria[stm->id] << "(%rbp), %xmm0\n";
 
-            out << " movsd %xmm0, -8(%rsp)\n";
+            out << " movss %xmm0, -8(%rsp)\n";
             out << " subq $8, %rsp\n";
 
             int rhsType = stm->rhs->accept(this);
 
             if (rhsType == 1)
             {
-                out << " cvtsi2sd %rax, %xmm0\n";
+                out << " cvtsi2ss %rax, %xmm0\n";
             }
 
-            out << " movsd (%rsp), %xmm1\n";
+            out << " movss (%rsp), %xmm1\n";
             out << " addq $8, %rsp\n";
 
             switch (stm->op)
             {
             case AssignStatement::PLUS_ASSIGN_OP:
-                out << " addsd %xmm0, %xmm1\n";
+                out << " addss %xmm0, %xmm1\n";
                 break;
             case AssignStatement::MINUS_ASSIGN_OP:
-                out << " subsd %xmm0, %xmm1\n";
+                out << " subss %xmm0, %xmm1\n";
                 break;
             case AssignStatement::MUL_ASSIGN_OP:
-                out << " mulsd %xmm0, %xmm1\n";
+                out << " mulss %xmm0, %xmm1\n";
                 break;
             case AssignStatement::DIV_ASSIGN_OP:
-                out << " divsd %xmm0, %xmm1\n";
+                out << " divss %xmm0, %xmm1\n";
                 break;
             }
 
             if (memoriaGlobal.count(stm->id))
-                out << " movsd %xmm1, " << stm->id << "(%rip)\n";
+                out << " movss %xmm1, " << stm->id << "(%rip)\n";
             else
-                out << " movsd %xmm1, " << memoria[stm->id] << "(%rbp)\n";
+                out << " movss %xmm1, " << memoria[stm->id] << "(%rbp)\n";
         }
         else
         {
@@ -2293,7 +3968,7 @@ void GenCodeVisitor::visit(AssignStatement *stm)
             int rhsType = stm->rhs->accept(this);
             if (rhsType == 2)
             {
-                out << " cvttsd2si %xmm0, %rax\n";
+                out << " cvttss2si %xmm0, %rax\n";
             }
             out << " movq %rax, %rcx\n";
             out << " popq %rax\n";
@@ -2334,17 +4009,17 @@ void GenCodeVisitor::visit(AssignStatement *stm)
         {
             if (memoriaGlobal.count(stm->id))
             {
-                out << " movsd " << stm->id << "(%rip), %xmm0\n";
-                out << " movsd .L_one(%rip), %xmm1\n";
-                out << " addsd %xmm1, %xmm0\n";
-                out << " movsd %xmm0, " << stm->id << "(%rip)\n";
+                out << " movss " << stm->id << "(%rip), %xmm0\n";
+                out << " movss " << getFloatConstantLabel(1.0) << "(%rip), %xmm1\n";
+                out << " addss %xmm1, %xmm0\n";
+                out << " movss %xmm0, " << stm->id << "(%rip)\n";
             }
             else
             {
-                out << " movsd " << memoria[stm->id] << "(%rbp), %xmm0\n";
-                out << " movsd .L_one(%rip), %xmm1\n";
-                out << " addsd %xmm1, %xmm0\n";
-                out << " movsd %xmm0, " << memoria[stm->id] << "(%rbp)\n";
+                out << " movss " << memoria[stm->id] << "(%rbp), %xmm0\n";
+                out << " movss " << getFloatConstantLabel(1.0) << "(%rip), %xmm1\n";
+                out << " addss %xmm1, %xmm0\n";
+                out << " movss %xmm0, " << memoria[stm->id] << "(%rbp)\n";
             }
         }
         else
@@ -2362,17 +4037,17 @@ void GenCodeVisitor::visit(AssignStatement *stm)
         {
             if (memoriaGlobal.count(stm->id))
             {
-                out << " movsd " << stm->id << "(%rip), %xmm0\n";
-                out << " movsd .L_one(%rip), %xmm1\n";
-                out << " subsd %xmm1, %xmm0\n";
-                out << " movsd %xmm0, " << stm->id << "(%rip)\n";
+                out << " movss " << stm->id << "(%rip), %xmm0\n";
+                out << " movss " << getFloatConstantLabel(1.0) << "(%rip), %xmm1\n";
+                out << " subss %xmm1, %xmm0\n";
+                out << " movss %xmm0, " << stm->id << "(%rip)\n";
             }
             else
             {
-                out << " movsd " << memoria[stm->id] << "(%rbp), %xmm0\n";
-                out << " movsd .L_one(%rip), %xmm1\n";
-                out << " subsd %xmm1, %xmm0\n";
-                out << " movsd %xmm0, " << memoria[stm->id] << "(%rbp)\n";
+                out << " movss " << memoria[stm->id] << "(%rbp), %xmm0\n";
+                out << " movss " << getFloatConstantLabel(1.0) << "(%rip), %xmm1\n";
+                out << " subss %xmm1, %xmm0\n";
+                out << " movss %xmm0, " << memoria[stm->id] << "(%rbp)\n";
             }
         }
         else
@@ -2391,28 +4066,7 @@ void GenCodeVisitor::visit(PrintStatement *stm)
     if (!stm || !stm->e)
         return;
 
-    int type = stm->e->accept(this);
-
-    if (type == 5)
-    {
-        out << " movq %rax, %rsi\n";
-        out << " leaq print_str_fmt(%rip), %rdi\n";
-        out << " movl $0, %eax\n";
-        out << " call printf@PLT\n";
-    }
-    else if (type == 2)
-    {
-        out << " movq $1, %rax\n";
-        out << " leaq print_float_fmt(%rip), %rdi\n";
-        out << " call printf@PLT\n";
-    }
-    else
-    {
-        out << " movq %rax, %rsi\n";
-        out << " leaq print_fmt(%rip), %rdi\n";
-        out << " movl $0, %eax\n";
-        out << " call printf@PLT\n";
-    }
+    emitPrint(stm->e->accept(this));
 }
 
 void GenCodeVisitor::visit(ExpressionStatement *stm)
@@ -2442,21 +4096,21 @@ void GenCodeVisitor::visit(VarDec *stm)
         varType = 5;
     }
 
-    setVariableType(stm->id, varType);
-
+    // El valor se evalúa antes de declarar la local: puede leer una variable
+    // de afuera con el mismo nombre
+    int valueType = stm->value ? stm->value->accept(this) : 0;
     if (!entornoFuncion)
     {
+        setVariableType(stm->id, varType);
         memoriaGlobal[stm->id] = true;
     }
     else
     {
-        memoria[stm->id] = offset;
-        offset -= 8;
+        declareLocal(stm->id, marco->ranura(stm), varType);
     }
 
     if (stm->value)
     {
-        int valueType = stm->value->accept(this);
 
         if (varType == 2)
         {
@@ -2464,23 +4118,23 @@ void GenCodeVisitor::visit(VarDec *stm)
             {
                 if (!entornoFuncion)
                 {
-                    out << " movsd %xmm0, " << stm->id << "(%rip)\n";
+                    out << " movss %xmm0, " << stm->id << "(%rip)\n";
                 }
                 else
                 {
-                    out << " movsd %xmm0, " << memoria[stm->id] << "(%rbp)\n";
+                    out << " movss %xmm0, " << memoria[stm->id] << "(%rbp)\n";
                 }
             }
             else
             {
-                out << " cvtsi2sd %rax, %xmm0\n";
+                out << " cvtsi2ss %rax, %xmm0\n";
                 if (!entornoFuncion)
                 {
-                    out << " movsd %xmm0, " << stm->id << "(%rip)\n";
+                    out << " movss %xmm0, " << stm->id << "(%rip)\n";
                 }
                 else
                 {
-                    out << " movsd %xmm0, " << memoria[stm->id] << "(%rbp)\n";
+                    out << " movss %xmm0, " << memoria[stm->id] << "(%rbp)\n";
                 }
             }
         }
@@ -2488,7 +4142,7 @@ void GenCodeVisitor::visit(VarDec *stm)
         {
             if (valueType == 2)
             {
-                out << " cvttsd2si %xmm0, %rax\n";
+                out << " cvttss2si %xmm0, %rax\n";
             }
             if (!entornoFuncion)
             {
@@ -2530,7 +4184,9 @@ void GenCodeVisitor::visit(Block *stm)
 {
     if (stm && stm->statements)
     {
+        size_t mark = shadowed.size();
         stm->statements->accept(this);
+        closeScope(mark);
     }
 }
 
@@ -2538,7 +4194,98 @@ void GenCodeVisitor::visit(RunBlock *stm)
 {
     if (stm && stm->statements)
     {
+        size_t mark = shadowed.size();
         stm->statements->accept(this);
+        closeScope(mark);
+    }
+}
+
+// Salta a label cuando la condición vale jumpIf, sin materializar el booleano:
+// && y || se vuelven saltos encadenados y ! invierte el sentido del salto.
+void GenCodeVisitor::genBranch(Exp *condition, bool jumpIf, const string &label)
+{
+    struct Branch
+    {
+        Exp *exp; // nullptr: solo se coloca la etiqueta
+        bool jumpIf;
+        string label;
+    };
+
+    vector<Branch> pending;
+    pending.push_back({condition, jumpIf, label});
+
+    while (!pending.empty())
+    {
+        Branch branch = pending.back();
+        pending.pop_back();
+
+        if (branch.exp == nullptr)
+        {
+            out << branch.label << ":\n";
+            continue;
+        }
+
+        Exp *exp = branch.exp;
+        while (true)
+        {
+            ParenthesizedExp *paren = dynamic_cast<ParenthesizedExp *>(exp);
+            UnaryExp *unary = dynamic_cast<UnaryExp *>(exp);
+            if (paren)
+            {
+                exp = paren->expr;
+            }
+            else if (unary && unary->op == UnaryExp::NOT_OP)
+            {
+                exp = unary->expr;
+                branch.jumpIf = !branch.jumpIf;
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        BinaryExp *bin = dynamic_cast<BinaryExp *>(exp);
+        if (bin && (bin->op == AND_OP || bin->op == OR_OP))
+        {
+            // a && b es falso si cualquiera lo es; a || b es verdadero si cualquiera lo es
+            if ((bin->op == AND_OP) != branch.jumpIf)
+            {
+                pending.push_back({bin->right, branch.jumpIf, branch.label});
+                pending.push_back({bin->left, branch.jumpIf, branch.label});
+            }
+            else
+            {
+                string skip = ".cond_skip_" + to_string(labelcont++);
+                pending.push_back({nullptr, false, skip});
+                pending.push_back({bin->right, branch.jumpIf, branch.label});
+                pending.push_back({bin->left, !branch.jumpIf, skip});
+            }
+            continue;
+        }
+
+        if (BoolExp *boolean = dynamic_cast<BoolExp *>(exp))
+        {
+            if ((boolean->value != 0) == branch.jumpIf)
+                out << " jmp " << branch.label << "\n";
+            continue;
+        }
+
+        if (bin && isComparison(bin->op))
+        {
+            // Comparación seguida directamente del salto, sin setcc ni cmpq $0
+            int leftType = bin->left->accept(this);
+            pushOperand(leftType);
+            int rightType = bin->right->accept(this);
+            string condition = emitCompare(bin->op, leftType, rightType);
+            out << " j" << (branch.jumpIf ? condition : invertCondition(condition)) << " " << branch.label << "\n";
+            continue;
+        }
+
+        if (exp->accept(this) == 2)
+            out << " cvttss2si %xmm0, %rax\n";
+        out << " cmpq $0, %rax\n";
+        out << (branch.jumpIf ? " jne " : " je ") << branch.label << "\n";
     }
 }
 
@@ -2548,9 +4295,7 @@ void GenCodeVisitor::visit(IfStatement *stm)
         return;
 
     int label = labelcont++;
-    stm->condition->accept(this);
-    out << " cmpq $0, %rax\n";
-    out << " je else_" << label << "\n";
+    genBranch(stm->condition, false, "else_" + to_string(label));
     if (stm->thenStmt)
         stm->thenStmt->accept(this);
     out << " jmp endif_" << label << "\n";
@@ -2567,18 +4312,19 @@ void GenCodeVisitor::visit(WhileStatement *stm)
 
     int labelId = labelcont++;
 
-    out << ".while_start_" << labelId << ":" << endl;
+    labelStack.push("while_" + to_string(labelId));
 
-    stm->condition->accept(this);
+    out << ".while_start_" << labelId << ":" << endl;
 
-    out << "    cmpq $0, %rax" << endl;
-    out << "    je .while_end_" << labelId << endl;
+    genBranch(stm->condition, false, ".while_end_" + to_string(labelId));
 
     if (stm->stmt)
         stm->stmt->accept(this);
 
     out << "    jmp .while_start_" << labelId << endl;
     out << ".while_end_" << labelId << ":" << endl;
+
+    labelStack.pop();
 }
 
 void GenCodeVisitor::visit(DoWhileStatement *stm)
@@ -2597,14 +4343,7 @@ void GenCodeVisitor::visit(DoWhileStatement *stm)
     if (stm->stmt)
         stm->stmt->accept(this);
 
-    int conditionType = stm->condition->accept(this);
-
-    if (conditionType == 2) {
-        out << "    cvttsd2si %xmm0, %rax" << endl;
-    }
-
-    out << "    cmpq $0, %rax" << endl;
-    out << "    jne .do_while_start_" << labelId << endl;
+    genBranch(stm->condition, true, ".do_while_start_" + to_string(labelId));
 
     out << ".do_while_end_" << labelId << ":" << endl;
 
@@ -2621,33 +4360,31 @@ void GenCodeVisitor::visit(ForStatement *stm)
         int labelId = labelcont++;
 
         range->start->accept(this);
-        offset -= 8;
-        int startOffset = offset;
+        int startOffset = marco->ranura(stm, 0);
         out << "    movq %rax, " << startOffset << "(%rbp)" << endl;
 
         range->end->accept(this);
-        offset -= 8;
-        int endOffset = offset;
+        int endOffset = marco->ranura(stm, 1);
         out << "    movq %rax, " << endOffset << "(%rbp)" << endl;
 
         int stepValue = 1;
         int stepOffset = 0;
         if (range->step != nullptr) {
             range->step->accept(this); // genero el valor de ese step
-            offset -= 8;
-            stepOffset = offset;
+            stepOffset = marco->ranura(stm, 2);
             out << "    movq %rax, " << stepOffset << "(%rbp)" << endl;
         }
 
-        if (memoria.find(stm->id) == memoria.end()) {
-            offset -= 8;
-            memoria[stm->id] = offset;
-            setVariableType(stm->id, 1);
+        size_t mark = shadowed.size();
+        if (marco->tieneRanura(stm, 3)) {
+            declareLocal(stm->id, marco->ranura(stm, 3), 1);
         }
 
         out << "    movq " << startOffset << "(%rbp), %rax" << endl;
         out << "    movq %rax, " << memoria[stm->id] << "(%rbp)" << endl;
 
+        labelStack.push("for_" + to_string(labelId));
+
         out << ".for_start_" << labelId << ":" << endl;
 
         out << "    movq " << memoria[stm->id] << "(%rbp), %rax" << endl;
@@ -2665,6 +4402,8 @@ void GenCodeVisitor::visit(ForStatement *stm)
         if (stm->stmt)
             stm->stmt->accept(this);
 
+        // continue salta aquí: al paso, no a la comparación
+        out << ".for_next_" << labelId << ":" << endl;
         out << "    movq " << memoria[stm->id] << "(%rbp), %rax" << endl;
 
         if (range->downTo) {
@@ -2687,6 +4426,8 @@ void GenCodeVisitor::visit(ForStatement *stm)
 
         out << "    jmp .for_start_" << labelId << endl;
         out << ".for_end_" << labelId << ":" << endl;
+        labelStack.pop();
+        closeScope(mark);
     }
 }
 
@@ -2695,65 +4436,72 @@ void GenCodeVisitor::visit(FunctionDecl *stm)
     if (!stm)
         return;
 
-    functionReturnTypes[stm->name] = stm->returnType;
-
     entornoFuncion = true;
+    // Los parámetros de la función anterior no deben tapar el tipo de una global
+    closeScope(0);
     memoria.clear();
-    offset = -8;
+    FrameLayout layout;
+    layout.calcular(stm);
+    marco = &layout;
     nombreFuncion = stm->name;
+    funcionActual = stm;
 
     vector<string> argRegs = {"%rdi", "%rsi", "%rdx", "%rcx", "%r8", "%r9"};
     vector<string> xmmRegs = {"%xmm0", "%xmm1", "%xmm2", "%xmm3", "%xmm4", "%xmm5", "%xmm6", "%xmm7"};
 
+    // Toda la función pasa por la mirilla antes de llegar a out
+    ostringstream funcion;
+    streambuf *archivo = out.rdbuf(funcion.rdbuf());
+
     out << ".globl " << stm->name << "\n";
     out << stm->name << ":\n";
     out << " pushq %rbp\n";
     out << " movq %rsp, %rbp\n";
+    out << ".tail_" << stm->name << ":\n";
 
     int intParamIndex = 0;
     int floatParamIndex = 0;
+    int paramIndex = 0;
 
-    for (auto it = stm->params.begin(); it != stm->params.end(); it++)
+    for (auto it = stm->params.begin(); it != stm->params.end(); it++, paramIndex++)
     {
         string paramName = it->first;
-        string paramType = it->second;
+        int type = stm->paramTypes[paramIndex];
 
-        memoria[paramName] = offset;
+        declareLocal(paramName, layout.ranura(stm, paramIndex), type);
 
-        if (paramType == "Float")
+        if (type == 2)
         {
-            setVariableType(paramName, 2);
             if (floatParamIndex < 8)
             {
-                out << " movsd " << xmmRegs[floatParamIndex] << ", " << offset << "(%rbp)\n";
+                out << " movss " << xmmRegs[floatParamIndex] << ", " << memoria[paramName] << "(%rbp)\n";
                 floatParamIndex++;
             }
         }
         else
         {
-            int type = 1;
-            if (paramType == "Boolean")
-                type = 3;
-            else if (paramType == "String")
-                type = 5;
-
-            setVariableType(paramName, type);
-
             if (intParamIndex < 6)
             {
-                out << " movq " << argRegs[intParamIndex] << ", " << offset << "(%rbp)\n";
+                out << " movq " << argRegs[intParamIndex] << ", " << memoria[paramName] << "(%rbp)\n";
                 intParamIndex++;
             }
         }
-
-        offset -= 8;
     }
 
-    int reserva = -offset - 8;
-    if (reserva > 0)
+    if (layout.reserva() > 0)
+    {
+        out << " subq $" << layout.reserva() << ", %rsp\n";
+    }
+    if (stm->name == "main")
     {
-        out << " subq $" << reserva << ", %rsp\n";
+        entornoFuncion = false;
+        for (VarDec *global : inicioGlobales)
+            global->accept(this);
+        entornoFuncion = true;
     }
+    funcionesMarco++;
+    bytesMarcos += layout.reserva();
+    bytesSinReutilizar += layout.reservaSinReutilizar();
 
     if (stm->body)
     {
@@ -2761,6 +4509,21 @@ void GenCodeVisitor::visit(FunctionDecl *stm)
     }
 
     out << ".end_" << stm->name << ":\n";
+    if (stm->name == "main")
+    {
+        // Con Unit, el código de salida es 0 y no lo que quedó en rax
+        if (stm->returnTypeCode == 0)
+        {
+            out << " call salida_vaciar\n";
+            out << " xorl %eax, %eax\n";
+        }
+        else
+        {
+            out << " pushq %rax\n";
+            out << " call salida_vaciar\n";
+            out << " popq %rax\n";
+        }
+    }
 
     if (stm->returnType == "Float")
     {
@@ -2772,11 +4535,45 @@ void GenCodeVisitor::visit(FunctionDecl *stm)
     out << " leave\n";
     out << " ret\n";
 
+    out.rdbuf(archivo);
+    if (usarMirilla || omitirMarcos)
+    {
+        vector<AsmLine> lineas = parseAssembly(funcion.str());
+        if (usarMirilla)
+            mirilla.optimizar(lineas);
+        if (omitirMarcos)
+            hojas.omitir(lineas, layout.reserva());
+        printAssembly(lineas, out);
+    }
+    else
+        out << funcion.str();
+
     entornoFuncion = false;
+    funcionActual = nullptr;
+    marco = nullptr;
 }
 
 void GenCodeVisitor::visit(ReturnStatement *stm)
 {
+    FunctionCallExp *call = stm ? dynamic_cast<FunctionCallExp *>(stm->expr) : nullptr;
+    if (call && isTailCall(call))
+    {
+        int floatArgs = emitCallArguments(call);
+        if (call->decl == funcionActual)
+        {
+            // Llamada propia: mismo marco, se vuelve justo después del prólogo
+            out << " movq %rbp, %rsp\n";
+            out << " jmp .tail_" << call->name << "\n";
+        }
+        else
+        {
+            out << " leave\n";
+            out << " movl $" << floatArgs << ", %eax\n";
+            out << " jmp " << call->name << "\n";
+        }
+        return;
+    }
+
     if (stm && stm->expr)
     {
         int type = stm->expr->accept(this);
@@ -2825,7 +4622,7 @@ void GenCodeVisitor::visit(ContinueStatement *stm)
         else if (currentLabel.find("for_") == 0)
         {
             string label = currentLabel.substr(4);
-            out << "    jmp .for_start_" << label << endl;
+            out << "    jmp .for_next_" << label << endl;
         }
     }
 }
@@ -2844,137 +4641,92 @@ void GenCodeVisitor::setVariableType(const string &name, int type)
     variableTypes[name] = type;
 }
 
-string GenCodeVisitor::getFloatConstantLabel(double value)
+void GenCodeVisitor::declareLocal(const string &name, int offset, int type)
+{
+    auto found = memoria.find(name);
+    auto known = variableTypes.find(name);
+    shadowed.push_back({name, found != memoria.end() ? found->second : 0,
+                        known != variableTypes.end() ? known->second : 0});
+    memoria[name] = offset;
+    variableTypes[name] = type;
+}
+
+void GenCodeVisitor::closeScope(size_t mark)
 {
-    for (auto it = floatConstants.begin(); it != floatConstants.end(); ++it)
+    while (shadowed.size() > mark)
     {
-        if (it->first == value)
-        {
-            return it->second;
-        }
+        Shadowed &previous = shadowed.back();
+        if (previous.offset)
+            memoria[previous.name] = previous.offset;
+        else
+            memoria.erase(previous.name);
+        if (previous.type)
+            variableTypes[previous.name] = previous.type;
+        else
+            variableTypes.erase(previous.name);
+        shadowed.pop_back();
     }
-    string label = ".float_" + to_string(floatConstants.size());
-    floatConstants[value] = label;
-    return label;
 }
 
-void GenCodeVisitor::processForFloatConstants(Block *block)
+void GenCodeVisitor::imprimirPerfil(std::ostream &salida) const
 {
-    if (!block || !block->statements)
-        return;
+    salida << "Marcos: " << bytesMarcos << " bytes en " << funcionesMarco << " funciones ("
+           << bytesSinReutilizar << " sin reutilizar ranuras)" << endl;
+    mirilla.imprimirPerfil(salida);
+    if (omitirMarcos)
+        hojas.imprimirPerfil(salida);
+}
 
-    for (auto stmt : block->statements->stms)
-    {
-        if (VarDec *varDecl = dynamic_cast<VarDec *>(stmt))
-        {
-            if (varDecl->value)
-            {
-                processExpForFloatConstants(varDecl->value);
-            }
-        }
-        else if (AssignStatement *assign = dynamic_cast<AssignStatement *>(stmt))
-        {
-            if (assign->rhs)
-            {
-                processExpForFloatConstants(assign->rhs);
-            }
-        }
-        else if (PrintStatement *print = dynamic_cast<PrintStatement *>(stmt))
-        {
-            if (print->e)
-            {
-                processExpForFloatConstants(print->e);
-            }
-        }
-        else if (ExpressionStatement *exprStmt = dynamic_cast<ExpressionStatement *>(stmt))
-        {
-            if (exprStmt->expr)
-            {
-                processExpForFloatConstants(exprStmt->expr);
-            }
-        }
-        else if (IfStatement *ifStmt = dynamic_cast<IfStatement *>(stmt))
-        {
-            if (ifStmt->condition)
-                processExpForFloatConstants(ifStmt->condition);
-            if (ifStmt->thenStmt)
-                processForFloatConstants(dynamic_cast<Block *>(ifStmt->thenStmt));
-            if (ifStmt->elseStmt)
-                processForFloatConstants(dynamic_cast<Block *>(ifStmt->elseStmt));
-        }
-        else if (WhileStatement *whileStmt = dynamic_cast<WhileStatement *>(stmt))
-        {
-            if (whileStmt->condition)
-                processExpForFloatConstants(whileStmt->condition);
-            if (whileStmt->stmt)
-                processForFloatConstants(dynamic_cast<Block *>(whileStmt->stmt));
-        }
-        else if (DoWhileStatement *doWhileStmt = dynamic_cast<DoWhileStatement *>(stmt))
-        {
-            if (doWhileStmt->condition)
-                processExpForFloatConstants(doWhileStmt->condition);
-            if (doWhileStmt->stmt)
-                processForFloatConstants(dynamic_cast<Block *>(doWhileStmt->stmt));
-        }
-        else if (ForStatement *forStmt = dynamic_cast<ForStatement *>(stmt))
-        {
-            if (forStmt->range)
-                processExpForFloatConstants(forStmt->range);
-            if (forStmt->stmt)
-                processForFloatConstants(dynamic_cast<Block *>(forStmt->stmt));
-        }
-        else if (FunctionDecl *funcDecl = dynamic_cast<FunctionDecl *>(stmt))
-        {
-            if (funcDecl->body)
-                processForFloatConstants(funcDecl->body);
-        }
-        else if (ReturnStatement *retStmt = dynamic_cast<ReturnStatement *>(stmt))
-        {
-            if (retStmt->expr)
-                processExpForFloatConstants(retStmt->expr);
-        }
-    }
+// Los Float se identifican por sus bits una vez redondeados a 32 bits, así
+// que 0.1 y 0.10000000149 comparten rótulo y 0.0 y -0.0 no
+string GenCodeVisitor::getFloatConstantLabel(double value)
+{
+    float single = (float)value;
+    uint32_t bits;
+    memcpy(&bits, &single, sizeof(bits));
+    auto found = floatConstants.find(bits);
+    if (found != floatConstants.end())
+        return found->second;
+    string label = ".float_" + to_string(floatOrder.size());
+    floatConstants.emplace(bits, label);
+    floatOrder.push_back(bits);
+    return label;
 }
 
-void GenCodeVisitor::processExpForFloatConstants(Exp *exp)
+// Los literales de cadena se comparan por su texto fuente, con los escapes
+// sin resolver
+string GenCodeVisitor::getStringConstantLabel(const string &value)
 {
-    if (!exp)
-        return;
+    auto found = stringConstants.find(value);
+    if (found != stringConstants.end())
+        return found->second;
+    string label = "str_" + to_string(stringOrder.size());
+    stringConstants.emplace(value, label);
+    stringOrder.push_back(value);
+    return label;
+}
 
-    if (DecimalExp *decExp = dynamic_cast<DecimalExp *>(exp))
-    {
-        getFloatConstantLabel(decExp->value);
-    }
-    else if (BinaryExp *binExp = dynamic_cast<BinaryExp *>(exp))
-    {
-        processExpForFloatConstants(binExp->left);
-        processExpForFloatConstants(binExp->right);
-    }
-    else if (UnaryExp *unExp = dynamic_cast<UnaryExp *>(exp))
-    {
-        processExpForFloatConstants(unExp->expr);
-    }
-    else if (ParenthesizedExp *parenExp = dynamic_cast<ParenthesizedExp *>(exp))
-    {
-        processExpForFloatConstants(parenExp->expr);
-    }
-    else if (FunctionCallExp *funcCall = dynamic_cast<FunctionCallExp *>(exp))
-    {
-        for (auto arg : funcCall->args)
-        {
-            processExpForFloatConstants(arg);
-        }
-    }
-    else if (RangeExp *rangeExp = dynamic_cast<RangeExp *>(exp))
+// Todos los literales juntos al final del archivo, en orden de aparición: los
+// Float con los dígitos justos para recuperar el mismo valor y las cadenas
+// precedidas de su longitud, como las de la arena
+void GenCodeVisitor::emitConstantPool()
+{
+    if (floatOrder.empty() && stringOrder.empty())
+        return;
+    out << "\n.section .rodata\n";
+    if (!floatOrder.empty())
+        out << ".align 4\n";
+    for (uint32_t bits : floatOrder)
     {
-        processExpForFloatConstants(rangeExp->start);
-        processExpForFloatConstants(rangeExp->end);
-        if (rangeExp->step)
-            processExpForFloatConstants(rangeExp->step);
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        char text[32];
+        out << floatConstants[bits] << ": .float " << string(text, to_chars(text, text + sizeof(text), value).ptr) << "\n";
     }
-    else if (RunExp *runExp = dynamic_cast<RunExp *>(exp))
+    for (const string &value : stringOrder)
     {
-        if (runExp->block)
-            processForFloatConstants(runExp->block);
+        out << ".align 8\n";
+        out << " .quad " << assembledLength(value) << "\n";
+        out << stringConstants[value] << ": .string \"" << value << "\"\n";
     }
 }
@@ -2,10 +2,14 @@
 #define VISITOR_H
 #include "exp.h"
 #include "environment.h"
+#include "peephole.h"
 #include <list>
+#include <map>
 #include <unordered_map>
 #include <iostream>
 #include <stack>
+#include <vector>
+#include <cstdint>
 
 class Exp;
 class BinaryExp;
@@ -40,6 +44,61 @@ class ReturnStatement;
 class BreakStatement;
 class ContinueStatement;
 
+string formatFloat(float value);
+
+// Superinstrucciones que marca SuperinstructionFuser: el intérprete ejecuta
+// cada patrón de una vez en lugar de recorrer sus nodos uno por uno.
+enum SuperOp
+{
+    SUPER_NONE,
+    SUPER_COMPARE_LOCALS,   // i < n
+    SUPER_COMPARE_CONST,    // i < 10
+    SUPER_INCREMENT_LOCAL,  // i += 1, i++, i = i + 1
+    SUPER_ACCUMULATE_LOCAL, // suma += expr, suma = suma + expr
+    SUPER_FOR_ASSIGN,       // for (i in a..b) con una sola asignación
+    SUPER_COUNT
+};
+
+// Valor evaluado por el interprete: mismo protocolo que lastType/lastInt/
+// lastFloat/lastString (1 Int, 2 Float, 3 Boolean, 4 rango, 5 String).
+struct EvalValue
+{
+    int type;
+    int intValue;
+    float floatValue;
+    string stringValue;
+};
+
+EvalValue evalBinaryOp(int op, const EvalValue &left, const EvalValue &right);
+EvalValue evalUnaryOp(int op, const EvalValue &operand);
+
+// Recorrido postorden con pila explicita sobre los nodos de operador de una
+// expresion (BinaryExp, ParenthesizedExp y UnaryExp !, -, +). El resto de
+// nodos se entrega a onLeaf, asi una cadena de 10^5 operadores o parentesis
+// no consume pila nativa. onOperand se llama entre ambos lados de un
+// BinaryExp; si devuelve false el lado derecho no se recorre.
+class ExpWalker
+{
+protected:
+    enum NodeKind
+    {
+        LEAF_NODE,
+        BINARY_NODE,
+        PAREN_NODE,
+        UNARY_NODE
+    };
+    static int nodeKind(Exp *exp);
+    void walk(Exp *root);
+    virtual void onLeaf(Exp *exp) = 0;
+    virtual void onEnter(Exp *exp) {}
+    virtual bool onOperand(BinaryExp *exp) { return true; }
+    virtual void onExit(Exp *exp) = 0;
+
+public:
+    virtual ~ExpWalker() {}
+    static bool isOperatorNode(Exp *exp);
+};
+
 class Visitor
 {
 public:
@@ -72,12 +131,16 @@ public:
     virtual void visit(ContinueStatement *stm) = 0;
 };
 
-class PrintVisitor : public Visitor
+class PrintVisitor : public Visitor, private ExpWalker
 {
 private:
     int indent = 0;
 
     void imprimirIndentacion();
+    void onLeaf(Exp *exp) override;
+    void onEnter(Exp *exp) override;
+    bool onOperand(BinaryExp *exp) override;
+    void onExit(Exp *exp) override;
 
 public:
     void imprimir(Program *program);
@@ -110,7 +173,7 @@ public:
     void visit(ContinueStatement *stm) override;
 };
 
-class EvalVisitor : public Visitor
+class EvalVisitor : public Visitor, private ExpWalker
 {
     Environment env;
     std::unordered_map<string, FunctionDecl *> functions;
@@ -123,9 +186,75 @@ class EvalVisitor : public Visitor
     bool continueExecuted;
     bool inBlockExecutionContext;
     bool inFunctionBody;
+    std::vector<EvalValue> valueStack;
+    FunctionDecl *currentFunction = nullptr;
+    bool tailCallPending = false;
+    std::vector<EvalValue> tailCallArgs;
+
+    // Memoización de funciones puras: tabla de correspondencia directa, cada
+    // llamada nueva reemplaza a la que ocupaba su casilla.
+    struct MemoEntry
+    {
+        FunctionDecl *func = nullptr;
+        std::vector<EvalValue> args;
+        EvalValue result;
+    };
+    struct MemoStats
+    {
+        long hits = 0;
+        long misses = 0;
+    };
+    static const size_t MEMO_SIZE = 4096;
+    std::vector<MemoEntry> memoTable;
+    // Solo con --perfil: contarlos no debe costar nada a las demás ejecuciones
+    bool perfilar = false;
+    std::unordered_map<FunctionDecl *, MemoStats> memoStats;
+    size_t memoSlot(FunctionDecl *func, const std::vector<EvalValue> &args);
+
+    // Evaluación anticipada (--aot): se guarda la salida del programa mientras
+    // la ejecución no pase del presupuesto de pasos ni del tamaño máximo.
+    static const size_t AOT_MAX_OUTPUT = 1 << 20;
+    bool captureOutput = false;
+    bool captureValid = false;
+    long stepBudget = 0;
+    long steps = 0;
+    string capturedOutput;
+    void countStep();
+    void cancelCapture();
+
+    struct QuickStats
+    {
+        long specialized = 0;
+        long generic = 0;
+        long deopts = 0;
+        long hits = 0;
+    };
+    bool especializar = true;
+    QuickStats quickStats;
+    bool quickBinary(BinaryExp *exp, EvalValue &left, const EvalValue &right);
+    bool quickUnary(UnaryExp *exp, EvalValue &operand);
+
+    long superHits[SUPER_COUNT] = {};
+    bool compareLocal(BinaryExp *exp);
+    bool incrementLocal(AssignStatement *stm);
+    bool accumulateLocal(AssignStatement *stm);
+    void storeLast(const string &id, int type);
+    bool runForBody(ForStatement *stm, bool prevInBlockExecutionContext);
+
+    int evalOperators(Exp *exp);
+    std::vector<EvalValue> evalArguments(FunctionCallExp *call);
+    void bindArguments(FunctionDecl *func, const std::vector<EvalValue> &args);
+    void onLeaf(Exp *exp) override;
+    bool onOperand(BinaryExp *exp) override;
+    void onExit(Exp *exp) override;
 
 public:
     void ejecutar(Program *program);
+    void imprimirPerfil();
+    void capturarSalida(long presupuesto);
+    void desactivarEspecializacion() { especializar = false; }
+    void activarPerfil() { perfilar = true; }
+    bool salidaCapturada(string &salida) const;
     void executeBlock(Block *block);
     int visit(BinaryExp *exp) override;
     int visit(NumberExp *exp) override;
@@ -156,32 +285,89 @@ public:
     void visit(ContinueStatement *stm) override;
 };
 
-class GenCodeVisitor : public Visitor
+class FrameLayout;
+
+class GenCodeVisitor : public Visitor, private ExpWalker
 {
 private:
     std::ostream &out;
     std::unordered_map<string, bool> memoriaGlobal;
+    std::vector<VarDec *> inicioGlobales;
     std::unordered_map<string, int> memoria;
     std::unordered_map<string, int> variableTypes;
-    std::unordered_map<double, string> floatConstants;
-    std::unordered_map<string, string> functionReturnTypes;
     std::stack<string> labelStack;
-    int offset;
     int labelcont;
-    int stringBufferCounter;
     bool entornoFuncion;
     string nombreFuncion;
+    FunctionDecl *funcionActual = nullptr;
 
     int getVariableType(const string &name);
     void setVariableType(const string &name, int type);
+
+    // Ranuras de la función actual (FrameLayout). Al cerrar un bloque se
+    // deshacen sus declaraciones, porque la ranura de una local muerta puede
+    // pasar a otra
+    struct Shadowed
+    {
+        string name;
+        int offset; // 0: el nombre no era local
+        int type;   // 0: no tenía tipo
+    };
+    FrameLayout *marco = nullptr;
+    std::vector<Shadowed> shadowed;
+    long bytesMarcos = 0, bytesSinReutilizar = 0;
+    int funcionesMarco = 0;
+    void declareLocal(const string &name, int offset, int type);
+    void closeScope(size_t mark);
+
+    // Pool de literales: un rótulo por valor, con búsqueda por hash, y el
+    // orden de aparición para emitirlos juntos al final
+    std::unordered_map<uint32_t, string> floatConstants;
+    std::vector<uint32_t> floatOrder;
+    std::unordered_map<string, string> stringConstants;
+    std::vector<string> stringOrder;
     string getFloatConstantLabel(double value);
-    void processForFloatConstants(Block *block);
-    void processExpForFloatConstants(Exp *exp);
+    string getStringConstantLabel(const string &value);
+    void emitConstantPool();
+
+    std::vector<int> typeStack;
+    std::vector<int> shortCircuitLabels;
+    // Concatenaciones que son el operando izquierdo de otra: sus piezas se
+    // quedan en la pila y la última de la cadena reserva una sola vez
+    std::unordered_map<Exp *, int> concatChain;
+    bool usaCadenas = false;
+    PeepholeOptimizer mirilla;
+    bool usarMirilla = true;
+    LeafFrameElider hojas;
+    bool omitirMarcos = true;
+    void emitConcat(int pieces);
+    void emitToString(int type);
+    void emitStringRuntime();
+    void emitWriteRuntime();
+    void emitOutputRuntime();
+    void emitPrint(int type);
+    int genOperators(Exp *exp);
+    int emitCallArguments(FunctionCallExp *exp);
+    bool isTailCall(FunctionCallExp *exp);
+    void genBranch(Exp *condition, bool jumpIf, const string &label);
+    int emitBinaryOp(BinaryExp *exp, int leftType, int rightType);
+    void pushOperand(int type);
+    bool popOperands(int leftType, int rightType);
+    string emitCompare(int op, int leftType, int rightType);
+    int emitUnaryOp(UnaryExp *exp, int type);
+    void onLeaf(Exp *exp) override;
+    void onEnter(Exp *exp) override;
+    bool onOperand(BinaryExp *exp) override;
+    void onExit(Exp *exp) override;
 
 public:
-    GenCodeVisitor(std::ostream &output) : out(output), offset(0), labelcont(1), stringBufferCounter(0), entornoFuncion(false) {}
+    GenCodeVisitor(std::ostream &output) : out(output), labelcont(1), entornoFuncion(false) {}
 
     void generar(Program *program);
+    void generarSalidaFija(const string &salida);
+    void desactivarMirilla() { usarMirilla = false; }
+    void conservarMarcos() { omitirMarcos = false; }
+    void imprimirPerfil(std::ostream &salida) const;
     int visit(BinaryExp *exp) override;
     int visit(NumberExp *exp) override;
     int visit(DecimalExp *exp) override;